@@ -1,9 +1,13 @@
 #include <HAPI/HAPI.h>
 #include <HAPI_cpp.h>
+#include "stringcache.h"
+#include "infocache.h"
+#include "cookcache.h"
+#include "mappedfile.h"
+#include <climits>
 #include <string>
 #include <vector>
 #include <map>
-#include <stdexcept>
 
 namespace hapi {
 
@@ -11,19 +15,7 @@ Engine* Engine::sInstance = nullptr;
 
 std::string getString( int string_handle )
 {
-    if (string_handle == 0)
-        return "";
-
-    int buffer_length;
-    HAPI_GetStringBufLength(string_handle, &buffer_length);
-
-    char * buf = new char[ buffer_length ];
-
-    HAPI_GetString(string_handle, buf, buffer_length);
-
-    std::string result( buf );
-    delete[] buf;
-    return result;
+    return StringCache::getInstance()->get( string_handle );
 }
 
 static void throwOnFailure(HAPI_Result result)
@@ -33,57 +25,15 @@ static void throwOnFailure(HAPI_Result result)
 }
 
 Asset::Asset(int id)
-    : id(id), _info(NULL), _nodeInfo(NULL)
-{
-}
-
-Asset::Asset(const Asset &asset)
-    : id(asset.id)
-    , _info(asset._info ? new HAPI_AssetInfo(*asset._info) : NULL)
-    , _nodeInfo(asset._nodeInfo ? new HAPI_NodeInfo(*asset._nodeInfo) : NULL)
-{
-}
-
-Asset::~Asset()
-{
-    delete this->_info;
-    delete this->_nodeInfo;
-}
-
-Asset & Asset::operator=(const Asset &asset)
+    : id(id)
 {
-    if (this != &asset)
-    {
-        delete this->_info;
-        delete this->_nodeInfo;
-        this->id = asset.id;
-        this->_info = asset._info ? new HAPI_AssetInfo(*asset._info) : NULL;
-        this->_nodeInfo = asset._nodeInfo
-                ? new HAPI_NodeInfo(*asset._nodeInfo) : NULL;
-    }
-    return *this;
 }
 
-const HAPI_AssetInfo & Asset::info() const
-{
-    if (!this->_info)
-    {
-        this->_info = new HAPI_AssetInfo();
-        throwOnFailure(HAPI_GetAssetInfo(this->id, this->_info));
-    }
-    return *this->_info;
-}
+HAPI_AssetInfo Asset::info() const
+{ return *InfoCache::getInstance()->assetInfo(this->id); }
 
-const HAPI_NodeInfo & Asset::nodeInfo() const
-{
-    if (!this->_nodeInfo)
-    {
-        this->_nodeInfo = new HAPI_NodeInfo();
-        throwOnFailure(HAPI_GetNodeInfo(
-                           this->info().nodeId, this->_nodeInfo));
-    }
-    return *this->_nodeInfo;
-}
+HAPI_NodeInfo Asset::nodeInfo() const
+{ return *InfoCache::getInstance()->nodeInfo(this->id); }
 
 bool Asset::isValid() const
 {
@@ -92,8 +42,8 @@ bool Asset::isValid() const
     {
         // Note that calling info() might fail if the info isn't cached
         // and the asest id is invalid.
-        throwOnFailure(HAPI_IsAssetValid(
-                           this->id, this->info().validationId, &is_valid));
+        throwOnFailure(HAPI_TRACE(HAPI_IsAssetValid(
+                           this->id, this->info().validationId, &is_valid)));
         return is_valid;
     }
     catch (Failure &failure)
@@ -112,17 +62,25 @@ std::string Asset::filePath() const
 { return getString(info().filePathSH); }
 
 void Asset::destroyAsset() const
-{ throwOnFailure(HAPI_DestroyAsset(this->id)); }
+{
+    StringCache::getInstance()->clear();
+    InfoCache::getInstance()->remove(this->id);
+    throwOnFailure(HAPI_TRACE(HAPI_DestroyAsset(this->id)));
+}
 
 void Asset::cook() const
-{ throwOnFailure(HAPI_CookAsset(this->id, NULL)); }
+{
+    StringCache::getInstance()->clear();
+    InfoCache::getInstance()->cooked(this->id);
+    throwOnFailure(HAPI_TRACE(HAPI_CookAsset(this->id, NULL)));
+}
 
 HAPI_TransformEuler Asset::getTransform(
         HAPI_RSTOrder rst_order, HAPI_XYZOrder rot_order) const
 {
     HAPI_TransformEuler result;
-    throwOnFailure(HAPI_GetAssetTransform(
-                       this->id, rst_order, rot_order, &result));
+    throwOnFailure(HAPI_TRACE(HAPI_GetAssetTransform(
+                       this->id, rst_order, rot_order, &result)));
     return result;
 }
 
@@ -130,26 +88,114 @@ void Asset::getTransformAsMatrix(float result_matrix[16]) const
 {
     HAPI_TransformEuler transform =
             this->getTransform( HAPI_SRT, HAPI_XYZ );
-    throwOnFailure(HAPI_ConvertTransformEulerToMatrix(
-                       &transform, result_matrix ) );
+    throwOnFailure(HAPI_TRACE(HAPI_ConvertTransformEulerToMatrix(
+                       &transform, result_matrix )) );
 }
 
 
+void Asset::getObjectTransformsAsMatrices(
+        float *result_matrices, int start, int length) const
+{
+    if (length <= 0)
+        return;
+
+    std::shared_ptr<const std::vector<HAPI_Transform> > transforms =
+            InfoCache::getInstance()->objectTransforms(this->id);
+    if (start < 0 || start + length > int(transforms->size()))
+        throw Failure(HAPI_RESULT_INVALID_ARGUMENT);
+
+    for (int i=0; i < length; ++i)
+        throwOnFailure(HAPI_TRACE(HAPI_ConvertTransformQuatToMatrix(
+                           &(*transforms)[start + i], result_matrices + i * 16)));
+}
+
 std::string Asset::getInputName( int input, int input_type ) const
 {
     HAPI_StringHandle name;
-    throwOnFailure(HAPI_GetInputName( this->id,
+    throwOnFailure(HAPI_TRACE(HAPI_GetInputName( this->id,
                                       input, input_type,
-                                      &name ) );
+                                      &name )) );
     return getString(name);
 }
 
 
 std::vector<Object> Asset::objects() const
 {
+    // The cache fetches every object info with one ranged call.
+    int object_count = int(InfoCache::getInstance()->objectInfos(this->id)->size());
+
     std::vector<Object> result;
-    for (int object_id=0; object_id < info().objectCount; ++object_id)
-        result.push_back(Object(*this, object_id));
+    result.reserve(object_count);
+    for (int object_id=0; object_id < object_count; ++object_id)
+        result.emplace_back(this->id, object_id);
+    return result;
+}
+
+
+ChangeSet Asset::sync(SyncState &state) const
+{
+    InfoCache *cache = InfoCache::getInstance();
+    ChangeSet result;
+
+    if (state.asset_id != this->id)
+    {
+        state.clear();
+        state.asset_id = this->id;
+    }
+
+    std::shared_ptr<const std::vector<HAPI_ObjectInfo> > objects =
+            cache->objectInfos(this->id);
+    int object_count = int(objects->size());
+
+    std::vector<unsigned> transform_stamps(object_count);
+    std::map<std::pair<int, int>, std::pair<unsigned, int> > geo_stamps;
+
+    for (int object_id=0; object_id < object_count; ++object_id)
+    {
+        transform_stamps[object_id] = cache->transformStamp(this->id, object_id);
+        if (object_id >= int(state.transform_stamps.size()) ||
+            state.transform_stamps[object_id] != transform_stamps[object_id])
+            result.moved_objects.emplace_back(this->id, object_id);
+
+        for (int geo_id=0; geo_id < (*objects)[object_id].geoCount; ++geo_id)
+        {
+            std::pair<int, int> key(object_id, geo_id);
+            unsigned stamp = cache->geoStamp(this->id, object_id, geo_id);
+            int part_count = cache->geoInfo(this->id, object_id, geo_id)->partCount;
+            geo_stamps[key] = std::make_pair(stamp, part_count);
+
+            // A geo keeps its stamp until its geometry or part count changes.
+            int old_part_count = 0;
+            bool same = false;
+            std::map<std::pair<int, int>, std::pair<unsigned, int> >::iterator old =
+                    state.geo_stamps.find(key);
+            if (old != state.geo_stamps.end())
+            {
+                same = old->second.first == stamp;
+                old_part_count = old->second.second;
+                state.geo_stamps.erase(old);
+            }
+
+            std::vector<Part> &parts = same
+                    ? result.unchanged_parts : result.changed_parts;
+            for (int part_id=0; part_id < part_count; ++part_id)
+                parts.emplace_back(this->id, object_id, geo_id, part_id);
+            for (int part_id=part_count; part_id < old_part_count; ++part_id)
+                result.removed_parts.emplace_back(this->id, object_id, geo_id, part_id);
+        }
+    }
+
+    // Whatever is left belonged to geos that went away.
+    for (std::map<std::pair<int, int>, std::pair<unsigned, int> >::const_iterator it =
+             state.geo_stamps.begin(); it != state.geo_stamps.end(); ++it)
+    {
+        for (int part_id=0; part_id < it->second.second; ++part_id)
+            result.removed_parts.emplace_back(
+                        this->id, it->first.first, it->first.second, part_id);
+    }
+
+    state.transform_stamps.swap(transform_stamps);
+    state.geo_stamps.swap(geo_stamps);
     return result;
 }
 
@@ -159,24 +205,56 @@ std::vector<Parm> Asset::parms() const
     // Get all the parm infos.
     int num_parms = nodeInfo().parmCount;
     std::vector<HAPI_ParmInfo> parm_infos(num_parms);
-    throwOnFailure(HAPI_GetParameters(
-                       this->info().nodeId, &parm_infos[0], /*start=*/0, num_parms));
+    throwOnFailure(HAPI_TRACE(HAPI_GetParameters(
+                       this->info().nodeId, &parm_infos[0], /*start=*/0, num_parms)));
 
     // Get all the parm choice infos.
     std::vector<HAPI_ParmChoiceInfo> parm_choice_infos(
                 this->nodeInfo().parmChoiceCount);
-    throwOnFailure(HAPI_GetParmChoiceLists(
+    throwOnFailure(HAPI_TRACE(HAPI_GetParmChoiceLists(
                        this->info().nodeId, &parm_choice_infos[0], /*start=*/0,
-                   this->nodeInfo().parmChoiceCount));
+                   this->nodeInfo().parmChoiceCount)));
+
+    // Resolve every name and label up front so Parm::name(), Parm::label()
+    // and the choice accessors are served from the string cache.
+    std::vector<HAPI_StringHandle> handles;
+    handles.reserve(num_parms * 2 + parm_choice_infos.size() * 2);
+    for (int i=0; i < num_parms; ++i)
+    {
+        handles.push_back(parm_infos[i].nameSH);
+        handles.push_back(parm_infos[i].labelSH);
+    }
+    for (int i=0; i < int(parm_choice_infos.size()); ++i)
+    {
+        handles.push_back(parm_choice_infos[i].labelSH);
+        handles.push_back(parm_choice_infos[i].valueSH);
+    }
+    StringCache::getInstance()->resolve(handles);
+
+    // Snapshot all values so the Parm getters don't go back to the engine.
+    std::shared_ptr<ParmValueStore> values = this->parmValues();
 
     // Build and return a vector of Parm objects.
     std::vector<Parm> result;
+    result.reserve(num_parms);
     for (int i=0; i < num_parms; ++i)
         result.push_back(Parm(
-                             this->info().nodeId, parm_infos[i], &parm_choice_infos[0]));
+                             this->info().nodeId, parm_infos[i], &parm_choice_infos[0],
+                             values));
+    return result;
+}
+
+std::shared_ptr<ParmValueStore> Asset::parmValues() const
+{
+    std::shared_ptr<ParmValueStore> result(
+                new ParmValueStore(this->info().nodeId));
+    result->fetch(this->nodeInfo());
     return result;
 }
 
+ParmTransaction Asset::beginTransaction() const
+{ return ParmTransaction(*this); }
+
 std::map<std::string, Parm> Asset::parmMap() const
 {
     std::vector<Parm> parms = this->parms();
@@ -188,52 +266,45 @@ std::map<std::string, Parm> Asset::parmMap() const
     return result;
 }
 
-Object::Object(int asset_id, int object_id)
-    : asset(asset_id), id(object_id), _info(NULL)
-{}
+bool ChangeSet::empty() const
+{
+    return this->moved_objects.empty() && this->changed_parts.empty() &&
+           this->removed_parts.empty();
+}
 
-Object::Object(const Asset &asset, int id)
-    : asset(asset), id(id), _info(NULL)
+SyncState::SyncState()
+    : asset_id(-1)
 {}
 
-Object::Object(const Object &object)
-    : asset(object.asset)
-    , id(object.id)
-    , _info(object._info ? new HAPI_ObjectInfo(*object._info) : NULL)
+void SyncState::clear()
+{
+    this->asset_id = -1;
+    this->transform_stamps.clear();
+    this->geo_stamps.clear();
+}
+
+
+Object::Object(int asset_id, int object_id)
+    : asset_id(asset_id), id(object_id)
 {}
 
-Object::~Object()
-{ delete this->_info; }
+Object::Object(const Asset &asset, int id)
+    : asset_id(asset.id), id(id)
+{}
 
-Object & Object::operator=(const Object &object)
-{
-    if (this != &object)
-    {
-        delete this->_info;
-        asset = object.asset;
-        this->id = object.id;
-        this->_info = object._info
-                ? new HAPI_ObjectInfo(*object._info) : NULL;
-    }
-    return *this;
-}
+HAPI_ObjectInfo Object::info() const
+{ return *InfoCache::getInstance()->objectInfo(this->asset_id, this->id); }
 
-const HAPI_ObjectInfo & Object::info() const
-{
-    if (!this->_info)
-    {
-        this->_info = new HAPI_ObjectInfo();
-        throwOnFailure(HAPI_GetObjects(
-                           this->asset.id, this->_info, this->id, /*length=*/1));
-    }
-    return *this->_info;
-}
+Asset Object::asset() const
+{ return Asset(this->asset_id); }
 
 std::vector<Geo> Object::geos() const
 {
+    int geo_count = info().geoCount;
     std::vector<Geo> result;
-    for (int geo_id=0; geo_id < info().geoCount; ++geo_id)
-        result.push_back(Geo(*this, geo_id));
+    result.reserve(geo_count);
+    for (int geo_id=0; geo_id < geo_count; ++geo_id)
+        result.emplace_back(this->asset_id, this->id, geo_id);
     return result;
 }
 
@@ -245,44 +316,21 @@ std::string Object::objectInstancePath() const
 
 
 Geo::Geo(const Object &object, int id)
-    : object(object), id(id), _info(NULL)
+    : asset_id(object.asset_id), object_id(object.id), id(id)
 {}
 
 Geo::Geo(int asset_id, int object_id, int geo_id)
-    : object(asset_id, object_id), id(geo_id), _info(NULL)
-{}
-
-Geo::Geo(const Geo &geo)
-    : object(geo.object)
-    , id(geo.id)
-    , _info(geo._info ? new HAPI_GeoInfo(*geo._info) : NULL)
+    : asset_id(asset_id), object_id(object_id), id(geo_id)
 {}
 
-Geo::~Geo()
-{ delete _info; }
-
-Geo & Geo::operator=(const Geo &geo)
+HAPI_GeoInfo Geo::info() const
 {
-    if (this != &geo)
-    {
-        delete this->_info;
-        this->object = geo.object;
-        this->id = geo.id;
-        this->_info = geo._info ? new HAPI_GeoInfo(*geo._info) : NULL;
-    }
-    return *this;
+    return *InfoCache::getInstance()->geoInfo(
+                this->asset_id, this->object_id, this->id);
 }
 
-const HAPI_GeoInfo & Geo::info() const
-{
-    if (!this->_info)
-    {
-        this->_info = new HAPI_GeoInfo();
-        throwOnFailure(HAPI_GetGeoInfo(
-                           this->object.asset.id, this->object.id, this->id, this->_info));
-    }
-    return *this->_info;
-}
+Object Geo::object() const
+{ return Object(this->asset_id, this->object_id); }
 
 std::string Geo::name() const
 { return getString(info().nameSH); }
@@ -290,53 +338,31 @@ std::string Geo::name() const
 
 std::vector<Part> Geo::parts() const
 {
+    int part_count = info().partCount;
     std::vector<Part> result;
-    for (int part_id=0; part_id < info().partCount; ++part_id)
-        result.push_back(Part(*this, part_id));
+    result.reserve(part_count);
+    for (int part_id=0; part_id < part_count; ++part_id)
+        result.emplace_back(this->asset_id, this->object_id, this->id, part_id);
     return result;
 }
 
 
 Part::Part(const Geo &geo, int id)
-    : geo(geo), id(id), _info(NULL)
+    : asset_id(geo.asset_id), object_id(geo.object_id), geo_id(geo.id), id(id)
 {}
 
 Part::Part(int asset_id, int object_id, int geo_id, int part_id)
-    : geo(asset_id, object_id, geo_id), id(part_id), _info(NULL)
-{}
-
-Part::Part(const Part &part)
-    : geo(part.geo)
-    , id(part.id)
-    , _info(part._info ? new HAPI_PartInfo(*part._info) : NULL)
+    : asset_id(asset_id), object_id(object_id), geo_id(geo_id), id(part_id)
 {}
 
-Part::~Part()
-{ delete _info; }
-
-Part & Part::operator=(const Part &part)
+HAPI_PartInfo Part::info() const
 {
-    if (this != &part)
-    {
-        delete this->_info;
-        this->geo = part.geo;
-        this->id = part.id;
-        this->_info = part._info ? new HAPI_PartInfo(*part._info) : NULL;
-    }
-    return *this;
+    return *InfoCache::getInstance()->partInfo(
+                this->asset_id, this->object_id, this->geo_id, this->id);
 }
 
-const HAPI_PartInfo & Part::info() const
-{
-    if (!this->_info)
-    {
-        this->_info = new HAPI_PartInfo();
-        throwOnFailure(HAPI_GetPartInfo(
-                           this->geo.object.asset.id, this->geo.object.id, this->geo.id,
-                           this->id, this->_info));
-    }
-    return *this->_info;
-}
+Geo Part::geo() const
+{ return Geo(this->asset_id, this->object_id, this->geo_id); }
 
 std::string Part::name() const
 { return getString(info().nameSH); }
@@ -366,11 +392,14 @@ std::vector<std::string> Part::attribNames(HAPI_AttributeOwner attrib_owner) con
     int num_attribs = numAttribs(attrib_owner);
     std::vector<int> attrib_names_sh(num_attribs);
 
-    throwOnFailure(HAPI_GetAttributeNames(
-                       this->geo.object.asset.id, this->geo.object.id, this->geo.id,
-                       this->id, attrib_owner, &attrib_names_sh[0], num_attribs));
+    throwOnFailure(HAPI_TRACE(HAPI_GetAttributeNames(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, attrib_owner, &attrib_names_sh[0], num_attribs)));
+
+    StringCache::getInstance()->resolve(attrib_names_sh);
 
     std::vector<std::string> result;
+    result.reserve(attrib_names_sh.size());
     for (int attrib_index=0; attrib_index < int(attrib_names_sh.size());
          ++attrib_index)
         result.push_back(getString(attrib_names_sh[attrib_index]));
@@ -381,9 +410,9 @@ HAPI_AttributeInfo Part::attribInfo(
         HAPI_AttributeOwner attrib_owner, const char *attrib_name) const
 {
     HAPI_AttributeInfo result;
-    throwOnFailure(HAPI_GetAttributeInfo(
-                       this->geo.object.asset.id, this->geo.object.id, this->geo.id,
-                       this->id, attrib_name, attrib_owner, &result));
+    throwOnFailure(HAPI_TRACE(HAPI_GetAttributeInfo(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, attrib_name, attrib_owner, &result)));
     return result;
 }
 
@@ -394,11 +423,193 @@ float * Part::getNewFloatAttribData(
     if (length < 0)
         length = attrib_info.count - start;
 
-    float *result = new float[attrib_info.count * attrib_info.tupleSize];
-    throwOnFailure(HAPI_GetAttributeFloatData(
-                       this->geo.object.asset.id, this->geo.object.id, this->geo.id,
-                       this->id, attrib_name, &attrib_info, result,
-                       /*start=*/0, attrib_info.count));
+    float *result = new float[length * attrib_info.tupleSize];
+    try
+    {
+        getAttribFloatData(attrib_info, attrib_name, result, start, length);
+    }
+    catch (Failure &)
+    {
+        delete[] result;
+        throw;
+    }
+    return result;
+}
+
+int Part::getAttribIntData(
+        HAPI_AttributeInfo &attrib_info, const char *attrib_name,
+        int *data, int start, int length) const
+{
+    if (length < 0)
+        length = attrib_info.count - start;
+    if (length <= 0)
+        return 0;
+
+    throwOnFailure(HAPI_TRACE(HAPI_GetAttributeIntData(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, attrib_name, &attrib_info, data,
+                       start, length)));
+    return length;
+}
+
+int Part::getAttribFloatData(
+        HAPI_AttributeInfo &attrib_info, const char *attrib_name,
+        float *data, int start, int length) const
+{
+    if (length < 0)
+        length = attrib_info.count - start;
+    if (length <= 0)
+        return 0;
+
+    throwOnFailure(HAPI_TRACE(HAPI_GetAttributeFloatData(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, attrib_name, &attrib_info, data,
+                       start, length)));
+    return length;
+}
+
+int Part::getFaceCounts(int *data, int start, int length) const
+{
+    if (length < 0)
+        length = this->info().faceCount - start;
+    if (length <= 0)
+        return 0;
+
+    throwOnFailure(HAPI_TRACE(HAPI_GetFaceCounts(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, data, start, length)));
+    return length;
+}
+
+int Part::getVertexList(int *data, int start, int length) const
+{
+    if (length < 0)
+        length = this->info().vertexCount - start;
+    if (length <= 0)
+        return 0;
+
+    throwOnFailure(HAPI_TRACE(HAPI_GetVertexList(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, data, start, length)));
+    return length;
+}
+
+int Part::getAttribStringHandles(
+        HAPI_AttributeInfo &attrib_info, const char *attrib_name,
+        HAPI_StringHandle *data, int start, int length) const
+{
+    if (length < 0)
+        length = attrib_info.count - start;
+    if (length <= 0)
+        return 0;
+
+    throwOnFailure(HAPI_TRACE(HAPI_GetAttributeStringData(
+                       this->asset_id, this->object_id, this->geo_id,
+                       this->id, attrib_name, &attrib_info, data,
+                       start, length)));
+    return length;
+}
+
+ParmValueStore::ParmValueStore(int node_id)
+    : node_id(node_id)
+{}
+
+void ParmValueStore::fetch(const HAPI_NodeInfo &node_info)
+{
+    this->int_values.resize(node_info.parmIntValueCount);
+    if (!this->int_values.empty())
+        throwOnFailure(HAPI_TRACE(HAPI_GetParmIntValues(
+                           this->node_id, &this->int_values[0], /*start=*/0,
+                           node_info.parmIntValueCount)));
+
+    this->float_values.resize(node_info.parmFloatValueCount);
+    if (!this->float_values.empty())
+        throwOnFailure(HAPI_TRACE(HAPI_GetParmFloatValues(
+                           this->node_id, &this->float_values[0], /*start=*/0,
+                           node_info.parmFloatValueCount)));
+
+    std::vector<HAPI_StringHandle> string_handles(node_info.parmStringValueCount);
+    if (!string_handles.empty())
+        throwOnFailure(HAPI_TRACE(HAPI_GetParmStringValues(
+                           this->node_id, true, &string_handles[0], /*start=*/0,
+                           node_info.parmStringValueCount)));
+
+    StringCache::getInstance()->resolve(string_handles);
+    this->string_values.resize(string_handles.size());
+    for (int i=0; i < int(string_handles.size()); ++i)
+        this->string_values[i] = getString(string_handles[i]);
+}
+
+// Value indices come from HAPI_ParmInfo, which goes stale once a multiparm
+// changes its instance count.
+static void checkValueIndex(int index, size_t count)
+{
+    if (index < 0 || size_t(index) >= count)
+        throw Failure(HAPI_RESULT_INVALID_ARGUMENT);
+}
+
+int ParmValueStore::intValue(int index) const
+{
+    checkValueIndex(index, this->int_values.size());
+    return this->int_values[index];
+}
+
+float ParmValueStore::floatValue(int index) const
+{
+    checkValueIndex(index, this->float_values.size());
+    return this->float_values[index];
+}
+
+const std::string & ParmValueStore::stringValue(int index) const
+{
+    checkValueIndex(index, this->string_values.size());
+    return this->string_values[index];
+}
+
+void ParmValueStore::setIntValue(int index, int value)
+{
+    checkValueIndex(index, this->int_values.size());
+    this->int_values[index] = value;
+}
+
+void ParmValueStore::setFloatValue(int index, float value)
+{
+    checkValueIndex(index, this->float_values.size());
+    this->float_values[index] = value;
+}
+
+void ParmValueStore::setStringValue(int index, const std::string &value)
+{
+    checkValueIndex(index, this->string_values.size());
+    this->string_values[index] = value;
+}
+
+static uint64_t fnv1a(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i=0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t ParmValueStore::hash(uint64_t seed) const
+{
+    // Counts go in too so values cannot shift between the three arrays.
+    uint64_t counts[3] = { this->int_values.size(), this->float_values.size(),
+                           this->string_values.size() };
+    uint64_t result = fnv1a(counts, sizeof(counts), seed);
+    if (!this->int_values.empty())
+        result = fnv1a(&this->int_values[0],
+                       this->int_values.size() * sizeof(int), result);
+    if (!this->float_values.empty())
+        result = fnv1a(&this->float_values[0],
+                       this->float_values.size() * sizeof(float), result);
+    for (size_t i=0; i < this->string_values.size(); ++i)
+        result = fnv1a(this->string_values[i].c_str(),
+                       this->string_values[i].size() + 1, result);
     return result;
 }
 
@@ -406,8 +617,9 @@ Parm::Parm()
 { }
 
 Parm::Parm(int node_id, const HAPI_ParmInfo &info,
-           HAPI_ParmChoiceInfo *all_choice_infos)
-    : node_id(node_id), _info(info)
+           HAPI_ParmChoiceInfo *all_choice_infos,
+           const std::shared_ptr<ParmValueStore> &values)
+    : node_id(node_id), values(values), _info(info)
 {
     for (int i=0; i < info.choiceCount; ++i)
         this->choices.push_back(ParmChoice(
@@ -425,61 +637,197 @@ std::string Parm::label() const
 
 int Parm::getIntValue(int sub_index) const
 {
+    if (this->values)
+        return this->values->intValue(this->_info.intValuesIndex + sub_index);
+
     int result;
-    throwOnFailure(HAPI_GetParmIntValues(
+    throwOnFailure(HAPI_TRACE(HAPI_GetParmIntValues(
                        this->node_id, &result, this->_info.intValuesIndex + sub_index,
-                       /*length=*/1));
+                       /*length=*/1)));
     return result;
 }
 
 float Parm::getFloatValue(int sub_index) const
 {
+    if (this->values)
+        return this->values->floatValue(this->_info.floatValuesIndex + sub_index);
+
     float result;
-    throwOnFailure(HAPI_GetParmFloatValues(
+    throwOnFailure(HAPI_TRACE(HAPI_GetParmFloatValues(
                        this->node_id, &result, this->_info.floatValuesIndex + sub_index,
-                       /*length=*/1));
+                       /*length=*/1)));
     return result;
 }
 
 std::string Parm::getStringValue(int sub_index) const
 {
+    if (this->values)
+        return this->values->stringValue(this->_info.stringValuesIndex + sub_index);
+
     int string_handle;
-    throwOnFailure(HAPI_GetParmStringValues(
+    throwOnFailure(HAPI_TRACE(HAPI_GetParmStringValues(
                        this->node_id, true, &string_handle,
-                       this->_info.stringValuesIndex + sub_index, /*length=*/1));
+                       this->_info.stringValuesIndex + sub_index, /*length=*/1)));
     return getString(string_handle);
 }
 
 void Parm::setIntValue(int sub_index, int value)
 {
-    throwOnFailure(HAPI_SetParmIntValues(
+    throwOnFailure(HAPI_TRACE(HAPI_SetParmIntValues(
                        this->node_id, &value, this->_info.intValuesIndex + sub_index,
-                       /*length=*/1));
+                       /*length=*/1)));
+    // Multiparm counts are int parms.
+    InfoCache::getInstance()->invalidateNode(this->node_id);
+    if (this->values)
+        this->values->setIntValue(this->_info.intValuesIndex + sub_index, value);
 }
 
 void Parm::setFloatValue(int sub_index, float value)
 {
-    throwOnFailure(HAPI_SetParmFloatValues(
+    throwOnFailure(HAPI_TRACE(HAPI_SetParmFloatValues(
                        this->node_id, &value, this->_info.floatValuesIndex + sub_index,
-                       /*length=*/1));
+                       /*length=*/1)));
+    if (this->values)
+        this->values->setFloatValue(this->_info.floatValuesIndex + sub_index, value);
 }
 
 void Parm::setStringValue(int sub_index, const char *value)
 {
-    throwOnFailure(HAPI_SetParmStringValue(
-                       this->node_id, value, this->_info.id, sub_index));
+    throwOnFailure(HAPI_TRACE(HAPI_SetParmStringValue(
+                       this->node_id, value, this->_info.id, sub_index)));
+    if (this->values)
+        this->values->setStringValue(this->_info.stringValuesIndex + sub_index, value);
 }
 
 void Parm::insertMultiparmInstance(int instance_position)
 {
-    throwOnFailure(HAPI_InsertMultiparmInstance(
-                       this->node_id, this->_info.id, instance_position));
+    throwOnFailure(HAPI_TRACE(HAPI_InsertMultiparmInstance(
+                       this->node_id, this->_info.id, instance_position)));
+    InfoCache::getInstance()->invalidateNode(this->node_id);
 }
 
 void Parm::removeMultiparmInstance(int instance_position)
 {
-    throwOnFailure(HAPI_RemoveMultiparmInstance(
-                       this->node_id, this->_info.id, instance_position));
+    throwOnFailure(HAPI_TRACE(HAPI_RemoveMultiparmInstance(
+                       this->node_id, this->_info.id, instance_position)));
+    InfoCache::getInstance()->invalidateNode(this->node_id);
+}
+
+ParmTransaction::ParmTransaction(const Asset &asset)
+    : asset_id(asset.id), node_id(asset.info().nodeId)
+{}
+
+ParmTransaction::ParmTransaction(const Parm &parm)
+    : asset_id(-1), node_id(parm.node_id), _values(parm.values)
+{}
+
+void ParmTransaction::track(const Parm &parm)
+{
+    if (parm.node_id != this->node_id)
+        throw Failure(HAPI_RESULT_INVALID_ARGUMENT);
+    if (!this->_values)
+        this->_values = parm.values;
+}
+
+void ParmTransaction::setIntValue(const Parm &parm, int sub_index, int value)
+{
+    track(parm);
+    this->_ints[parm.info().intValuesIndex + sub_index] = value;
+}
+
+void ParmTransaction::setFloatValue(const Parm &parm, int sub_index, float value)
+{
+    track(parm);
+    this->_floats[parm.info().floatValuesIndex + sub_index] = value;
+}
+
+void ParmTransaction::setStringValue(const Parm &parm, int sub_index, const char *value)
+{
+    track(parm);
+    PendingString &pending = this->_strings[parm.info().stringValuesIndex + sub_index];
+    pending.parm_id = parm.info().id;
+    pending.sub_index = sub_index;
+    pending.value = value;
+}
+
+bool ParmTransaction::empty() const
+{ return this->_ints.empty() && this->_floats.empty() && this->_strings.empty(); }
+
+static HAPI_Result setIntValues(int node_id, const int *values, int start, int length)
+{ return HAPI_TRACE(HAPI_SetParmIntValues(node_id, values, start, length)); }
+
+static HAPI_Result setFloatValues(int node_id, const float *values, int start, int length)
+{ return HAPI_TRACE(HAPI_SetParmFloatValues(node_id, values, start, length)); }
+
+// Walk a sorted index->value map and issue one setter call per run of
+// consecutive indices.
+template <typename T, typename SetFunc>
+static int flushRanges(int node_id, const std::map<int, T> &pending, SetFunc set_values)
+{
+    int calls = 0;
+    std::vector<T> run;
+    typename std::map<int, T>::const_iterator it = pending.begin();
+    while (it != pending.end())
+    {
+        int start = it->first;
+        run.clear();
+        run.push_back(it->second);
+        for (++it; it != pending.end() && it->first == start + int(run.size()); ++it)
+            run.push_back(it->second);
+
+        throwOnFailure(set_values(node_id, &run[0], start, int(run.size())));
+        ++calls;
+    }
+    return calls;
+}
+
+int ParmTransaction::commit(bool cook)
+{
+    if (this->empty())
+        return 0;
+
+    int calls = 0;
+    calls += flushRanges(this->node_id, this->_ints, setIntValues);
+    if (!this->_ints.empty())
+        InfoCache::getInstance()->invalidateNode(this->node_id);
+    calls += flushRanges(this->node_id, this->_floats, setFloatValues);
+
+    // There is no ranged string setter, so strings go one element at a time.
+    for (std::map<int, PendingString>::const_iterator it = this->_strings.begin();
+         it != this->_strings.end(); ++it)
+    {
+        throwOnFailure(HAPI_TRACE(HAPI_SetParmStringValue(
+                           this->node_id, it->second.value.c_str(),
+                           it->second.parm_id, it->second.sub_index)));
+        ++calls;
+    }
+
+    if (this->_values)
+    {
+        for (std::map<int, int>::const_iterator it = this->_ints.begin();
+             it != this->_ints.end(); ++it)
+            this->_values->setIntValue(it->first, it->second);
+        for (std::map<int, float>::const_iterator it = this->_floats.begin();
+             it != this->_floats.end(); ++it)
+            this->_values->setFloatValue(it->first, it->second);
+        for (std::map<int, PendingString>::const_iterator it = this->_strings.begin();
+             it != this->_strings.end(); ++it)
+            this->_values->setStringValue(it->first, it->second.value);
+    }
+
+    rollback();
+
+    if (cook && this->asset_id >= 0)
+        Asset(this->asset_id).cook();
+
+    return calls;
+}
+
+void ParmTransaction::rollback()
+{
+    this->_ints.clear();
+    this->_floats.clear();
+    this->_strings.clear();
 }
 
 ParmChoice::ParmChoice(HAPI_ParmChoiceInfo &info)
@@ -496,7 +844,7 @@ std::string ParmChoice::value() const
 { return getString(_info.valueSH); }
 
 
-Engine::Engine() : mInitialized(false)
+Engine::Engine() : mInitialized(false), mLoadMode(LOAD_FROM_FILE)
 {
 
 }
@@ -513,13 +861,15 @@ bool Engine::initialize( const char * otl_search_path,
 {
     if ( !isInitialize() )
     {
+        StringCache::getInstance()->clear();
+        InfoCache::getInstance()->clear();
         HAPI_CookOptions cook_options = HAPI_CookOptions_Create();
-        mResult = HAPI_Initialize (
+        mResult = HAPI_TRACE(HAPI_Initialize (
                     otl_search_path,
                     dso_search_path,
                     &cook_options,
                     use_cooking_thread,
-                    cooking_thread_stack_size );
+                    cooking_thread_stack_size ));
 
 #if !defined( INIT_CHECK_BY_HAPI )
         if (  mResult == HAPI_RESULT_SUCCESS )
@@ -536,7 +886,13 @@ void Engine::cleanup()
 {
     if ( isInitialize() )
     {
-        mResult = HAPI_Cleanup();
+        StringCache::getInstance()->clear();
+        InfoCache::getInstance()->clear();
+        mResult = HAPI_TRACE(HAPI_Cleanup());
+        mAssetLib.clear();
+        mAssetNames.clear();
+        mMappedLibraries.clear();
+        mRetiredLibraries.clear();
 #if !defined( INIT_CHECK_BY_HAPI )
         mInitialized = false;
 #endif
@@ -546,7 +902,7 @@ void Engine::cleanup()
 bool    Engine::isInitialize()
 {
 #if defined( INIT_CHECK_BY_HAPI )
-    mResult = HAPI_IsInitialized();
+    mResult = HAPI_TRACE(HAPI_IsInitialized());
     return mResult == HAPI_RESULT_SUCCESS;
 #else
     return mInitialized;
@@ -561,12 +917,12 @@ HAPI_Result     Engine::getLastResult()
 std::string     Engine::getLastError()
 {
     int buffer_length;
-    HAPI_GetStatusStringBufLength(
-                HAPI_STATUS_CALL_RESULT, HAPI_STATUSVERBOSITY_ERRORS, &buffer_length);
+    HAPI_TRACE(HAPI_GetStatusStringBufLength(
+                HAPI_STATUS_CALL_RESULT, HAPI_STATUSVERBOSITY_ERRORS, &buffer_length));
 
     char * buf = new char[ buffer_length ];
 
-    HAPI_GetStatusString(HAPI_STATUS_CALL_RESULT, buf);
+    HAPI_TRACE(HAPI_GetStatusString(HAPI_STATUS_CALL_RESULT, buf));
 
     std::string result( buf );
     delete[] buf;
@@ -574,65 +930,185 @@ std::string     Engine::getLastError()
     return result;
 }
 
-int Engine::loadAssetLibrary( const char* otl_file )
+int Engine::loadAssetLibrary( const char* otl_file, bool reload )
 {
     std::string otl( otl_file );
     int library_id = -1;
 
-    if ( mAssetLib.find( otl ) != mAssetLib.end() )
+    if ( !reload && mAssetLib.find( otl ) != mAssetLib.end() )
     {
-        library_id = mAssetLib[ otl ];
+        return mAssetLib[ otl ];
+    }
+
+    releaseRetiredLibraries();
+
+    std::shared_ptr<MappedFile> file;
+    if ( mLoadMode == LOAD_FROM_MEMORY )
+    {
+        file.reset( new MappedFile );
+        if ( !file->open( otl ) || file->size() == 0 || file->size() > size_t( INT_MAX ) )
+            file.reset();
+    }
+
+    if ( file )
+    {
+        // The same file unchanged, whatever path it was loaded through.
+        for ( size_t i = 0; i < mMappedLibraries.size() && library_id < 0; ++i )
+            if ( mMappedLibraries[i].file->isSameFile( *file ) )
+                library_id = mMappedLibraries[i].id;
+
+        // A copy can only match a library of the same size, so the contents
+        // are hashed just when there is one.
+        uint64_t hash = 0;
+        for ( size_t i = 0; i < mMappedLibraries.size() && library_id < 0; ++i )
+        {
+            MappedLibrary& library = mMappedLibraries[i];
+            if ( library.file->size() != file->size() )
+                continue;
+
+            if ( !hash )
+                hash = CookCache::hashData( file->data(), file->size() );
+            if ( !library.hash )
+                library.hash = CookCache::hashData( library.file->data(), library.file->size() );
+            if ( library.hash == hash )
+                library_id = library.id;
+        }
+
+        if ( library_id >= 0 )
+        {
+            mResult = HAPI_RESULT_SUCCESS;
+        }
+        else
+        {
+            mResult = HAPI_TRACE(HAPI_LoadAssetLibraryFromMemory(
+                        file->data(),
+                        int( file->size() ),
+                        reload,
+                        &library_id ));
+
+            if ( mResult == HAPI_RESULT_SUCCESS )
+            {
+                MappedLibrary library;
+                library.file = file;
+                library.hash = hash;
+                library.id = library_id;
+                mMappedLibraries.push_back( library );
+                mAssetNames.erase( library_id );
+            }
+        }
+
+        if ( mResult == HAPI_RESULT_SUCCESS )
+        {
+            std::map<std::string, int>::const_iterator it = mAssetLib.find( otl );
+            int previous_id = it != mAssetLib.end() ? it->second : -1;
+            mAssetLib[ otl ] = library_id;
+            if ( previous_id >= 0 && previous_id != library_id )
+                retireLibrary( previous_id );
+        }
     }
     else
     {
-        mResult = HAPI_LoadAssetLibraryFromFile(
+        mResult = HAPI_TRACE(HAPI_LoadAssetLibraryFromFile(
                     otl_file,
-                    false,
-                    &library_id );
+                    reload,
+                    &library_id ));
 
         if ( mResult == HAPI_RESULT_SUCCESS )
         {
             mAssetLib[ otl ] = library_id;
+            mAssetNames.erase( library_id );
         }
     }
 
     return library_id;
 }
 
-int Engine::getAvailableAssetCount( int library_id )
+// Called once no path loads library_id any more, e.g. after its file was
+// reloaded with new contents.
+void Engine::retireLibrary( int library_id )
 {
-    int count = 0;
+    for ( std::map<std::string, int>::const_iterator it = mAssetLib.begin(); it != mAssetLib.end(); ++it )
+        if ( it->second == library_id )
+            return;
+
+    for ( size_t i = 0; i < mMappedLibraries.size(); ++i )
+    {
+        if ( mMappedLibraries[i].id == library_id )
+        {
+            mRetiredLibraries.push_back( mMappedLibraries[i].file );
+            mMappedLibraries.erase( mMappedLibraries.begin() + i );
+            break;
+        }
+    }
+    releaseRetiredLibraries();
+}
+
+// The engine may still be reading a retired mapping while a load is in
+// flight; once it is idle they can go.
+void Engine::releaseRetiredLibraries()
+{
+    if ( mRetiredLibraries.empty() )
+        return;
 
-    mResult = HAPI_GetAvailableAssetCount( library_id, &count );
+    int state = HAPI_STATE_READY;
+    if ( HAPI_TRACE(HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state )) == HAPI_RESULT_SUCCESS &&
+         state <= HAPI_STATE_MAX_READY_STATE )
+        mRetiredLibraries.clear();
+}
 
-    return count;
+int Engine::getAvailableAssetCount( int library_id )
+{
+    return int( getAssetNames( library_id ).size() );
 }
 
 std::string Engine::getAssetName( int library_id, int id )
 {
-    std::string asset_name;
-    int count = getAvailableAssetCount( library_id );
+    const std::vector<std::string>& names = getAssetNames( library_id );
 
-    if ( id >= 0 && id < count )
-    {
-        HAPI_StringHandle* asset_name_sh = new HAPI_StringHandle[count];
+    if ( id >= 0 && id < int( names.size() ) )
+        return names[ id ];
+    return std::string();
+}
 
-        mResult = HAPI_GetAvailableAssets( library_id, asset_name_sh, count );
+const std::vector<std::string>& Engine::getAssetNames( int library_id )
+{
+    std::map<int, std::vector<std::string> >::const_iterator it = mAssetNames.find( library_id );
+    if ( it != mAssetNames.end() )
+        return it->second;
 
-        if ( mResult == HAPI_RESULT_SUCCESS )
-            asset_name = getString( asset_name_sh[id] );
+    // Failures are not cached, so the next call asks again.
+    static const std::vector<std::string> sNone;
 
-        delete [] asset_name_sh;
+    int count = 0;
+    mResult = HAPI_TRACE(HAPI_GetAvailableAssetCount( library_id, &count ));
+    if ( mResult != HAPI_RESULT_SUCCESS )
+        return sNone;
+
+    std::vector<HAPI_StringHandle> handles( count );
+    if ( count > 0 )
+    {
+        mResult = HAPI_TRACE(HAPI_GetAvailableAssets( library_id, &handles[0], count ));
+        if ( mResult != HAPI_RESULT_SUCCESS )
+            return sNone;
     }
 
-    return asset_name;
+    std::vector<std::string>& names = mAssetNames[ library_id ];
+    names.reserve( count );
+    for ( int i = 0; i < count; ++i )
+        names.push_back( getString( handles[i] ) );
+    return names;
 }
 
 int Engine::instantiateAsset(  const char* name, bool cook_on_load )
 {
     int asset_id = -1;
 
-    mResult = HAPI_InstantiateAsset( name, cook_on_load, &asset_id );
+    StringCache::getInstance()->clear();
+    mResult = HAPI_TRACE(HAPI_InstantiateAsset( name, cook_on_load, &asset_id ));
+
+    // The id may belong to an asset destroyed behind the wrapper's back.
+    if ( asset_id >= 0 )
+        InfoCache::getInstance()->remove( asset_id );
 
     return asset_id;
 }
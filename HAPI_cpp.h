@@ -2,13 +2,18 @@
 #define HAPI_CPP_H
 
 #include <HAPI/HAPI.h>
+#include "hapitrace.h"
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <stdint.h>
 
 namespace hapi
 {
 
+class MappedFile;
+
 std::string getString( int string_handle );
 
 //----------------------------------------------------------------------------
@@ -29,12 +34,12 @@ public:
     static std::string lastErrorMessage()
     {
     int buffer_length;
-    HAPI_GetStatusStringBufLength(
-            HAPI_STATUS_CALL_RESULT, HAPI_STATUSVERBOSITY_ERRORS, &buffer_length);
+    HAPI_TRACE(HAPI_GetStatusStringBufLength(
+            HAPI_STATUS_CALL_RESULT, HAPI_STATUSVERBOSITY_ERRORS, &buffer_length));
 
     char * buf = new char[ buffer_length ];
 
-    HAPI_GetStatusString(HAPI_STATUS_CALL_RESULT, buf);
+    HAPI_TRACE(HAPI_GetStatusString(HAPI_STATUS_CALL_RESULT, buf));
         std::string result(buf);
     return result;
     }
@@ -46,24 +51,32 @@ public:
 //----------------------------------------------------------------------------
 // Classes:
 
+// Asset, Object, Geo and Part are lightweight handles: a tuple of ids. Their
+// infos live in the shared InfoCache, which revalidates them after a cook,
+// so handles never go stale and repeated traversals cost no HAPI calls.
+// info() copies the current cache entry, so handles stay trivially copyable
+// and can be shared between threads.
+
 class Object;
 class Parm;
+class ParmValueStore;
+class ParmTransaction;
+class SyncState;
+struct ChangeSet;
 
 class Asset
 {
 public:
     Asset(int id);
-    Asset(const Asset &asset);
-    ~Asset();
-
-    Asset &operator=(const Asset &asset);
 
-    const HAPI_AssetInfo &info() const;
-    const HAPI_NodeInfo &nodeInfo() const;
+    HAPI_AssetInfo info() const;
+    HAPI_NodeInfo nodeInfo() const;
 
     std::vector<Object> objects() const;
     std::vector<Parm> parms() const;
     std::map<std::string, Parm> parmMap() const;
+    std::shared_ptr<ParmValueStore> parmValues() const;
+    ParmTransaction beginTransaction() const;
 
     bool isValid() const;
 
@@ -75,12 +88,18 @@ public:
     HAPI_TransformEuler getTransform(
         HAPI_RSTOrder rst_order, HAPI_XYZOrder rot_order) const;
     void getTransformAsMatrix(float result_matrix[16]) const;
+    // Transforms of objects [start, start + length) as 4x4 matrices.
+    void getObjectTransformsAsMatrices(
+        float *result_matrices, int start, int length) const;
 
     std::string getInputName( int input, int input_type = HAPI_INPUT_GEOMETRY ) const;
+
+    // Compare the asset against what state saw last time and record the
+    // current objects, geos and parts in it. Only geos whose geometry
+    // changed report their parts as changed; after a small parm tweak most
+    // parts come back unchanged and can keep their extracted buffers.
+    ChangeSet sync(SyncState &state) const;
     int id;
-private:
-    mutable HAPI_AssetInfo *_info;
-    mutable HAPI_NodeInfo *_nodeInfo;
 };
 
 class Geo;
@@ -90,19 +109,14 @@ class Object
 public:
     Object(int asset_id, int object_id);
     Object(const Asset &asset, int id);
-    Object(const Object &object);
-
-    ~Object();
 
-    Object &operator=(const Object &object);
-    const HAPI_ObjectInfo &info() const;
+    HAPI_ObjectInfo info() const;
     std::vector<Geo> geos() const;
     std::string name() const;
     std::string objectInstancePath() const;
-    Asset asset;
+    Asset asset() const;
+    int asset_id;
     int id;
-private:
-    mutable HAPI_ObjectInfo *_info;
 };
 
 class Part;
@@ -112,16 +126,13 @@ class Geo
 public:
     Geo(const Object &object, int id);
     Geo(int asset_id, int object_id, int geo_id);
-    Geo(const Geo &geo);
-    ~Geo();
-    Geo &operator=(const Geo &geo);
-    const HAPI_GeoInfo &info() const;
+    HAPI_GeoInfo info() const;
     std::string name() const;
     std::vector<Part> parts() const;
-    Object object;
+    Object object() const;
+    int asset_id;
+    int object_id;
     int id;
-private:
-    mutable HAPI_GeoInfo *_info;
 };
 
 class Part
@@ -129,11 +140,8 @@ class Part
 public:
     Part(const Geo &geo, int id);
     Part(int asset_id, int object_id, int geo_id, int part_id);
-    Part(const Part &part);
-    ~Part();
 
-    Part &operator=(const Part &part);
-    const HAPI_PartInfo &info() const;
+    HAPI_PartInfo info() const;
     std::string name() const;
     int numAttribs(HAPI_AttributeOwner attrib_owner) const;
     std::vector<std::string> attribNames(HAPI_AttributeOwner attrib_owner) const;
@@ -142,10 +150,85 @@ public:
     float *getNewFloatAttribData(
     HAPI_AttributeInfo &attrib_info, const char *attrib_name,
     int start=0, int length=-1) const;
-    Geo geo;
+
+    // Copy the [start, start + length) elements of an attribute straight
+    // into caller-owned storage, which must hold length * tupleSize values.
+    // A negative length reads up to the end of the attribute. Returns the
+    // number of elements read.
+    int getAttribIntData(
+    HAPI_AttributeInfo &attrib_info, const char *attrib_name,
+    int *data, int start=0, int length=-1) const;
+    int getAttribFloatData(
+    HAPI_AttributeInfo &attrib_info, const char *attrib_name,
+    float *data, int start=0, int length=-1) const;
+    int getFaceCounts(int *data, int start=0, int length=-1) const;
+    int getVertexList(int *data, int start=0, int length=-1) const;
+    int getAttribStringHandles(
+    HAPI_AttributeInfo &attrib_info, const char *attrib_name,
+    HAPI_StringHandle *data, int start=0, int length=-1) const;
+    Geo geo() const;
+    int asset_id;
+    int object_id;
+    int geo_id;
     int id;
-private:
-    mutable HAPI_PartInfo *_info;
+};
+
+// Result of Asset::sync(). Every part of the asset is either changed (new
+// or modified geometry) or unchanged; removed_parts only carry the ids of
+// parts that no longer exist.
+struct ChangeSet
+{
+    bool empty() const;
+
+    std::vector<Object> moved_objects;
+    std::vector<Part> changed_parts;
+    std::vector<Part> unchanged_parts;
+    std::vector<Part> removed_parts;
+};
+
+// The change stamps one consumer saw on its last Asset::sync(). Starting
+// from an empty state reports everything as changed.
+class SyncState
+{
+public:
+    SyncState();
+    void clear();
+
+    int asset_id;
+    // Transform stamp per object id.
+    std::vector<unsigned> transform_stamps;
+    // Geo stamp and part count per (object id, geo id).
+    std::map<std::pair<int, int>, std::pair<unsigned, int> > geo_stamps;
+};
+
+// Snapshot of every int, float and string value on a node, pulled with one
+// ranged call per type. Parms built by Asset::parms() share one store and
+// read their values from it; their setters write through to both the engine
+// and the store.
+class ParmValueStore
+{
+public:
+    ParmValueStore(int node_id);
+
+    void fetch(const HAPI_NodeInfo &node_info);
+
+    // Indices outside the snapshot throw Failure(HAPI_RESULT_INVALID_ARGUMENT).
+    int intValue(int index) const;
+    float floatValue(int index) const;
+    const std::string &stringValue(int index) const;
+
+    void setIntValue(int index, int value);
+    void setFloatValue(int index, float value);
+    void setStringValue(int index, const std::string &value);
+
+    // FNV-1a over every value, continuing from seed. Equal hashes identify
+    // equal parameter states, e.g. to key cached cook results.
+    uint64_t hash(uint64_t seed = 14695981039346656037ULL) const;
+
+    int node_id;
+    std::vector<int> int_values;
+    std::vector<float> float_values;
+    std::vector<std::string> string_values;
 };
 
 class ParmChoice;
@@ -157,7 +240,8 @@ public:
     // where a Parm object does not exist in the map.
     Parm();
     Parm(int node_id, const HAPI_ParmInfo &info,
-    HAPI_ParmChoiceInfo *all_choice_infos);
+    HAPI_ParmChoiceInfo *all_choice_infos,
+    const std::shared_ptr<ParmValueStore> &values = std::shared_ptr<ParmValueStore>());
 
     const HAPI_ParmInfo &info() const;
     std::string name() const;
@@ -172,10 +256,49 @@ public:
     void removeMultiparmInstance(int instance_position);
     int node_id;
     std::vector<ParmChoice> choices;
+    std::shared_ptr<ParmValueStore> values;
 private:
     HAPI_ParmInfo _info;
 };
 
+// Records pending parm writes and flushes them on commit(). Writes to
+// adjacent int and float value indices are merged into one ranged
+// HAPI_SetParm*Values call each, and the asset is cooked at most once.
+// A transaction created from a Parm has no asset and never cooks.
+class ParmTransaction
+{
+public:
+    explicit ParmTransaction(const Asset &asset);
+    explicit ParmTransaction(const Parm &parm);
+
+    void setIntValue(const Parm &parm, int sub_index, int value);
+    void setFloatValue(const Parm &parm, int sub_index, float value);
+    void setStringValue(const Parm &parm, int sub_index, const char *value);
+
+    bool empty() const;
+
+    // Returns the number of HAPI set calls that were issued.
+    int commit(bool cook = true);
+    void rollback();
+
+    int asset_id;
+    int node_id;
+private:
+    struct PendingString
+    {
+        int parm_id;
+        int sub_index;
+        std::string value;
+    };
+
+    void track(const Parm &parm);
+
+    std::map<int, int> _ints;
+    std::map<int, float> _floats;
+    std::map<int, PendingString> _strings;
+    std::shared_ptr<ParmValueStore> _values;
+};
+
 class ParmChoice
 {
 public:
@@ -201,17 +324,33 @@ public:
     void        cleanup();
 
     bool        isInitialize();
+
+    enum LoadMode
+    {
+        LOAD_FROM_FILE,
+        // Map the library and hand the bytes to
+        // HAPI_LoadAssetLibraryFromMemory. The same file reached through
+        // another path is loaded once; so is a copy, which is told by
+        // content only when its size matches a loaded library. Files that
+        // cannot be mapped are loaded from file.
+        LOAD_FROM_MEMORY
+    };
+    void        setLoadMode( LoadMode mode ) { mLoadMode = mode; }
+    LoadMode    loadMode() const { return mLoadMode; }
     HAPI_Result getLastResult();
     std::string getLastError();
 
-    int         loadAssetLibrary( const char* otl_file );
+    // Libraries are loaded once per path; reload loads the file again,
+    // for when it changed on disk.
+    int         loadAssetLibrary( const char* otl_file, bool reload = false );
+    bool        isAssetLibraryLoaded( const char* otl_file ) const
+    { return mAssetLib.find( otl_file ) != mAssetLib.end(); }
     int         getAvailableAssetCount( int library_id );
     std::string getAssetName( int library_id, int id );
+    // The names are fetched once per library and cached.
+    const std::vector<std::string>& getAssetNames( int library_id );
     int         instantiateAsset(  const char* name, bool cook_on_load = true );
 
-    int         getAssetNames();
-    std::string getAssetName( int id );
-
 
     void        release();
     static Engine* getInstance();
@@ -222,7 +361,24 @@ private:
     bool                            mInitialized;
     HAPI_Result                     mResult;
     std::map<std::string, int>      mAssetLib;
-    std::vector<std::string>        mAssetNames;
+    std::map<int, std::vector<std::string> > mAssetNames;
+    LoadMode                        mLoadMode;
+    struct MappedLibrary
+    {
+        std::shared_ptr<MappedFile> file;
+        // Content hash; 0 until another library of the same size is loaded.
+        uint64_t    hash;
+        int         id;
+    };
+
+    void        retireLibrary( int library_id );
+    void        releaseRetiredLibraries();
+
+    // The mappings handed to the engine for libraries some path still
+    // loads. Superseded ones are retired and released once the engine is
+    // idle, since loads can finish asynchronously.
+    std::vector<MappedLibrary>      mMappedLibraries;
+    std::vector< std::shared_ptr<MappedFile> > mRetiredLibraries;
 };
 
 }
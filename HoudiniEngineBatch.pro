@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Headless batch cooker for parameter sweeps
+#
+#-------------------------------------------------
+
+QT       = core
+
+TARGET = HoudiniEngineBatch
+TEMPLATE = app
+CONFIG   += console
+CONFIG   -= app_bundle
+
+include(hapi.pri)
+
+SOURCES += batchmain.cpp \
+    batchcooker.cpp \
+    cookfarm.cpp \
+    sweepfile.cpp
+
+HEADERS += batchcooker.h \
+    cookfarm.h \
+    sweepfile.h
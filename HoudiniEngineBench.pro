@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Benchmarks against the stub engine in stub/
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = HoudiniEngineBench
+TEMPLATE = app
+CONFIG   += console hapi_stub
+CONFIG   -= app_bundle
+
+include(hapi.pri)
+
+SOURCES += benchmain.cpp \
+    parameters.cpp \
+    parametersview.cpp \
+    fileselector.cpp \
+    cookscheduler.cpp \
+    parmtree.cpp \
+    parametersmodel.cpp
+
+HEADERS += parameters.h \
+    parametersview.h \
+    fileselector.h \
+    cookscheduler.h \
+    parmtree.h \
+    parametersmodel.h
@@ -6,25 +6,37 @@
 
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 TARGET = HoudiniEngine
 TEMPLATE = app
+CONFIG   += c++11
 
 
-SOURCES += main.cpp mainwindow.cpp HAPI_cpp.cpp \
+include(hapi.pri)
+
+SOURCES += main.cpp mainwindow.cpp \
     parameters.cpp \
     parametersview.cpp \
-    fileselector.cpp
+    fileselector.cpp \
+    assetcatalog.cpp \
+    catalogrefresher.cpp \
+    assetloader.cpp \
+    enginestarter.cpp \
+    cookscheduler.cpp \
+    parmtree.cpp \
+    parametersmodel.cpp
 
 HEADERS  += mainwindow.h \
-    HAPI_cpp.h \
     parameters.h \
     parametersview.h \
-    fileselector.h
+    fileselector.h \
+    assetcatalog.h \
+    catalogrefresher.h \
+    assetloader.h \
+    enginestarter.h \
+    cookscheduler.h \
+    parmtree.h \
+    parametersmodel.h
 
 FORMS    += mainwindow.ui
-
-INCLUDEPATH += "$$(HOUDINI_ROOT)/toolkit/include"
-LIBS += "$$(HOUDINI_ROOT)/custom/houdini/dsolib/libHAPI.a"
-
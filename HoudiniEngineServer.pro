@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Resident engine for clients built with CONFIG+=hapi_remote
+#
+#-------------------------------------------------
+
+QT       = core network
+
+TARGET = HoudiniEngineServer
+TEMPLATE = app
+CONFIG   += console
+CONFIG   -= app_bundle
+
+# The server is what links the real engine.
+CONFIG   -= hapi_remote
+
+include(hapi.pri)
+
+SOURCES += servermain.cpp \
+    engineserver.cpp \
+    remoteengine.cpp \
+    remoteprotocol.cpp
+
+HEADERS += engineserver.h \
+    remoteengine.h \
+    remoteprotocol.h
@@ -0,0 +1,349 @@
+#include "assetcatalog.h"
+#include "HAPI_cpp.h"
+#include "cookcache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#define INDEX_MAGIC         (0x48514349)
+#define INDEX_VERSION       (1)
+#define POLL_INTERVAL_MS    (10)
+
+namespace hapi {
+
+// What refresh() finds out about a file off the calling thread.
+struct LibraryProbe
+{
+    QString     file;
+    bool        known;
+    qint64      known_modified;
+    qint64      known_size;
+    quint64     known_hash;
+
+    bool        exists;
+    qint64      modified;
+    qint64      size;
+    quint64     hash;
+};
+
+static QStringList ListDirectory( const QString& path )
+{
+    QStringList filters;
+    filters << "*.otl" << "*.otllc" << "*.otlnc" << "*.hda" << "*.hdalc" << "*.hdanc";
+
+    QFileInfoList infos = QDir( path ).entryInfoList( filters, QDir::Files | QDir::Readable,
+                                                      QDir::Name );
+    QStringList files;
+    for ( int i = 0; i < infos.size(); ++i )
+        files << infos[i].absoluteFilePath();
+    return files;
+}
+
+// Only hash when the file looks different; a hash equal to the known one
+// means the file was merely touched.
+static void Probe( LibraryProbe& probe )
+{
+    QFileInfo info( probe.file );
+    probe.exists = info.isFile();
+    if ( !probe.exists )
+        return;
+
+    probe.modified = info.lastModified().toMSecsSinceEpoch();
+    probe.size = info.size();
+    if ( probe.known && probe.modified == probe.known_modified && probe.size == probe.known_size )
+        probe.hash = probe.known_hash;
+    else
+        probe.hash = CookCache::hashFile( QFile::encodeName( probe.file ).constData() );
+}
+
+// Loading a library returns right away when the engine has a cooking thread.
+static bool WaitForReady()
+{
+    int state = HAPI_STATE_STARTING_COOK;
+    while ( state > HAPI_STATE_MAX_READY_STATE )
+    {
+        if ( HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) ) != HAPI_RESULT_SUCCESS )
+            return false;
+        if ( state > HAPI_STATE_MAX_READY_STATE )
+            std::this_thread::sleep_for( std::chrono::milliseconds( POLL_INTERVAL_MS ) );
+    }
+    return state != HAPI_STATE_READY_WITH_FATAL_ERRORS;
+}
+
+AssetCatalog::AssetCatalog() :
+    mDirty(false)
+{
+    // "&" stands for Houdini's own directories, which are not ours to scan.
+    QString scan_path = QString::fromLocal8Bit( qgetenv( "HOUDINI_OTLSCAN_PATH" ) );
+#ifdef Q_OS_WIN
+    QStringList paths = scan_path.split( ';', QString::SkipEmptyParts );
+#else
+    QStringList paths = scan_path.split( ':', QString::SkipEmptyParts );
+#endif
+    for ( int i = 0; i < paths.size(); ++i )
+        if ( paths[i].trimmed() != "&" )
+            mSearchPaths << paths[i].trimmed();
+}
+
+void AssetCatalog::addLibrary( const QString& file )
+{
+    QString path = QFileInfo( file ).absoluteFilePath();
+    if ( !mFiles.contains( path ) )
+    {
+        mFiles << path;
+        mDirty = true;
+    }
+}
+
+// Loads without overwriting, so a library defining an asset that is already
+// loaded from elsewhere fails with HAPI_RESULT_ASSET_DEF_ALREADY_LOADED.
+bool AssetCatalog::list( const QString& file, QStringList& assets )
+{
+    Engine* hapi = Engine::getInstance();
+
+    int library_id = hapi->loadAssetLibrary( QFile::encodeName( file ).constData() );
+    if ( library_id < 0 || !WaitForReady() )
+    {
+        mError = file + ": " + QString::fromStdString( hapi->getLastError() );
+        return false;
+    }
+
+    try
+    {
+        const std::vector<std::string>& names = hapi->getAssetNames( library_id );
+        for ( size_t i = 0; i < names.size(); ++i )
+            assets << QString::fromStdString( names[i] );
+    }
+    catch ( Failure& )
+    {
+        mError = file + ": " + QString::fromStdString( Failure::lastErrorMessage() );
+        return false;
+    }
+    return true;
+}
+
+int AssetCatalog::refresh( const Progress& progress )
+{
+    mError.clear();
+
+    // Explicit files first, then the search paths in order.
+    QList<QStringList> found = QtConcurrent::blockingMapped( mSearchPaths, ListDirectory );
+    QStringList files = mFiles;
+    for ( int i = 0; i < found.size(); ++i )
+        files += found[i];
+    files.removeDuplicates();
+
+    QHash<QString, int> known;
+    for ( int i = 0; i < mLibraries.size(); ++i )
+        known.insert( mLibraries[i].file, i );
+
+    QVector<LibraryProbe> probes( files.size() );
+    for ( int i = 0; i < files.size(); ++i )
+    {
+        LibraryProbe& probe = probes[i];
+        int index = known.value( files[i], -1 );
+        probe.file = files[i];
+        probe.known = index >= 0;
+        probe.known_modified = probe.known ? mLibraries[ index ].modified : 0;
+        probe.known_size = probe.known ? mLibraries[ index ].size : 0;
+        probe.known_hash = probe.known ? mLibraries[ index ].hash : 0;
+        probe.exists = false;
+        probe.modified = probe.size = 0;
+        probe.hash = 0;
+    }
+    QtConcurrent::blockingMap( probes, Probe );
+
+    int to_list = 0;
+    for ( int i = 0; i < probes.size(); ++i )
+    {
+        const LibraryProbe& probe = probes[i];
+        if ( probe.exists && probe.hash &&
+             ( !probe.known || probe.hash != mLibraries[ known.value( probe.file ) ].hash ) )
+            ++to_list;
+    }
+
+    QList<Library> libraries;
+    bool dirty = false;
+    int listed = 0;
+    for ( int i = 0; i < probes.size(); ++i )
+    {
+        const LibraryProbe& probe = probes[i];
+        // Gone or unreadable.
+        if ( !probe.exists || !probe.hash )
+            continue;
+
+        Library library;
+        if ( probe.known )
+            library = mLibraries[ known.value( probe.file ) ];
+        else
+            library.file = probe.file;
+
+        if ( !probe.known || probe.hash != library.hash )
+        {
+            if ( progress && !progress( listed, to_list ) )
+                return -1;
+            ++listed;
+
+            // The engine would hand back the definitions it loaded from this
+            // path before; getting the new ones means reloading over them.
+            QStringList assets;
+            bool current = !probe.known ||
+                           !Engine::getInstance()->isAssetLibraryLoaded(
+                                QFile::encodeName( probe.file ).constData() );
+            if ( current && list( probe.file, assets ) )
+            {
+                library.modified = probe.modified;
+                library.size = probe.size;
+                library.hash = probe.hash;
+                library.assets = assets;
+                dirty = true;
+            }
+            // Nothing is recorded, so the next refresh tries again.
+            else if ( !probe.known )
+                continue;
+        }
+        else if ( probe.modified != library.modified || probe.size != library.size )
+        {
+            library.modified = probe.modified;
+            library.size = probe.size;
+            dirty = true;
+        }
+        libraries << library;
+    }
+
+    if ( progress )
+        progress( listed, to_list );
+    if ( dirty || libraries.size() != mLibraries.size() )
+        mDirty = true;
+    mLibraries = libraries;
+    rebuild();
+    return listed;
+}
+
+void AssetCatalog::rebuild()
+{
+    mEntries.clear();
+    for ( int l = 0; l < mLibraries.size(); ++l )
+    {
+        const Library& library = mLibraries[l];
+        for ( int i = 0; i < library.assets.size(); ++i )
+        {
+            if ( mEntries.contains( library.assets[i] ) )
+                continue;
+
+            Entry entry;
+            entry.name = library.assets[i];
+            entry.file = library.file;
+            entry.index = i;
+            entry.modified = library.modified;
+            entry.hash = library.hash;
+            mEntries.insert( entry.name, entry );
+        }
+    }
+}
+
+const AssetCatalog::Entry* AssetCatalog::find( const QString& name ) const
+{
+    QHash<QString, Entry>::const_iterator it = mEntries.constFind( name );
+    return it != mEntries.constEnd() ? &it.value() : nullptr;
+}
+
+QStringList AssetCatalog::names() const
+{
+    QStringList result = mEntries.keys();
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+bool AssetCatalog::load( const QString& path )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        mError = path + ": " + file.errorString();
+        return false;
+    }
+
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_4_8 );
+
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    QStringList files;
+    in >> magic >> version;
+    if ( magic != INDEX_MAGIC || version != INDEX_VERSION )
+    {
+        mError = path + ": not an asset index";
+        return false;
+    }
+    in >> files >> count;
+
+    QList<Library> libraries;
+    for ( qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i )
+    {
+        Library library;
+        in >> library.file >> library.modified >> library.size >> library.hash >> library.assets;
+        libraries << library;
+    }
+    if ( in.status() != QDataStream::Ok || count < 0 )
+    {
+        mError = path + ": damaged asset index";
+        return false;
+    }
+
+    files += mFiles;
+    files.removeDuplicates();
+    mFiles = files;
+    mLibraries = libraries;
+    rebuild();
+    mDirty = false;
+    return true;
+}
+
+bool AssetCatalog::save( const QString& path )
+{
+    // Write next to the index and swap, so a crash never leaves half of it.
+    QString temp_path = path + ".tmp";
+    QFile file( temp_path );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        mError = temp_path + ": " + file.errorString();
+        return false;
+    }
+
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_8 );
+    out << quint32( INDEX_MAGIC ) << quint32( INDEX_VERSION ) << mFiles
+        << qint32( mLibraries.size() );
+    for ( int i = 0; i < mLibraries.size(); ++i )
+    {
+        const Library& library = mLibraries[i];
+        out << library.file << library.modified << library.size << library.hash << library.assets;
+    }
+    file.close();
+
+    if ( out.status() != QDataStream::Ok || file.error() != QFile::NoError )
+    {
+        mError = temp_path + ": " + file.errorString();
+        QFile::remove( temp_path );
+        return false;
+    }
+    QFile::remove( path );
+    if ( !QFile::rename( temp_path, path ) )
+    {
+        mError = path + ": cannot replace the index";
+        return false;
+    }
+
+    mDirty = false;
+    return true;
+}
+
+};
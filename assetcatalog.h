@@ -0,0 +1,97 @@
+#ifndef ASSETCATALOG_H
+#define ASSETCATALOG_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+namespace hapi {
+
+//
+// Index of the assets in a set of asset libraries, so pickers can list and
+// look up assets by name without loading every library into the engine.
+//
+// refresh() lists the search directories and stats every library on the
+// global thread pool; libraries whose size or modification time changed
+// are hashed there as well. Only libraries that are new or whose contents
+// really changed are loaded into the engine to list their assets, which
+// happens on the calling thread; CatalogRefresher runs it off the GUI thread.
+// Listing never overwrites definitions the engine already has, so a library
+// that fails to load, or one that changed after the engine loaded it, keeps
+// its previous listing and is tried again on the next refresh.
+//
+// The index is saved and loaded as a whole, so a new session starts from
+// the last one and only re-lists the libraries that changed meanwhile.
+// When two libraries define the same asset, the one found first wins.
+//
+class AssetCatalog
+{
+public:
+    struct Entry
+    {
+        QString     name;
+        QString     file;
+        int         index;      // position of the asset in its library
+        qint64      modified;   // msecs since epoch
+        quint64     hash;       // CookCache::hashFile()
+    };
+
+    // Called before each library that has to be listed by the engine, with
+    // the number listed so far and the number to list; returning false
+    // cancels the refresh.
+    typedef std::function<bool( int done, int total )> Progress;
+
+    AssetCatalog();
+
+    // Directories scanned for libraries, not recursively. The default is
+    // HOUDINI_OTLSCAN_PATH.
+    void    setSearchPaths( const QStringList& paths ) { mSearchPaths = paths; }
+    const QStringList& searchPaths() const { return mSearchPaths; }
+
+    // Indexes file on the next refresh(), wherever it is.
+    void    addLibrary( const QString& file );
+
+    bool    load( const QString& path );
+    bool    save( const QString& path );
+
+    // Brings the index up to date with the files on disk. Calls into the
+    // engine, so it must run where HAPI calls are allowed. Returns the
+    // number of libraries that had to be listed by the engine, or -1 when
+    // progress canceled it, in which case the index is left as it was.
+    int     refresh( const Progress& progress = Progress() );
+
+    const Entry* find( const QString& name ) const;
+    // Sorted.
+    QStringList names() const;
+    int     libraryCount() const { return mLibraries.size(); }
+
+    // True when the index changed since it was last loaded or saved.
+    bool    isDirty() const { return mDirty; }
+    const QString& error() const { return mError; }
+
+private:
+    struct Library
+    {
+        QString     file;
+        qint64      modified;
+        qint64      size;
+        quint64     hash;
+        QStringList assets;
+    };
+
+    bool    list( const QString& file, QStringList& assets );
+    void    rebuild();
+
+    QStringList             mSearchPaths;
+    QStringList             mFiles;
+    // Libraries in the order they were found, and the assets they define.
+    QList<Library>          mLibraries;
+    QHash<QString, Entry>   mEntries;
+    bool                    mDirty;
+    QString                 mError;
+};
+
+};
+
+#endif // ASSETCATALOG_H
@@ -0,0 +1,101 @@
+#include "assetloader.h"
+#include "HAPI_cpp.h"
+
+#define POLL_INTERVAL_MS        (50)
+
+namespace hapi {
+
+AssetLoader::AssetLoader( const QString& filename, QObject *parent ) :
+    QThread(parent), mFilename(filename), mCanceled(0)
+{
+}
+
+void AssetLoader::cancel()
+{
+    if ( mCanceled.fetchAndStoreOrdered(1) == 0 && isRunning() )
+        HAPI_TRACE( HAPI_Interrupt() );
+}
+
+bool AssetLoader::isCanceled() const
+{
+    return mCanceled.fetchAndAddOrdered(0) != 0;
+}
+
+// Poll the cook state until the engine is idle again. With the cooking
+// thread enabled, loads, instantiation and cooks all return immediately and
+// report their progress here.
+bool AssetLoader::waitForReady( const QString& stage )
+{
+    int state = HAPI_STATE_STARTING_COOK;
+    while ( state > HAPI_STATE_MAX_READY_STATE )
+    {
+        if ( HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) ) != HAPI_RESULT_SUCCESS )
+            return false;
+
+        if ( state == HAPI_STATE_COOKING )
+        {
+            int current = 0, total = 0;
+            HAPI_TRACE( HAPI_GetCookingCurrentCount( &current ) );
+            HAPI_TRACE( HAPI_GetCookingTotalCount( &total ) );
+            emit progress( stage, current, total );
+        }
+
+        if ( state > HAPI_STATE_MAX_READY_STATE )
+            msleep( POLL_INTERVAL_MS );
+    }
+    return state != HAPI_STATE_READY_WITH_FATAL_ERRORS;
+}
+
+void AssetLoader::abort( int asset_id )
+{
+    if ( asset_id >= 0 )
+        HAPI_TRACE( HAPI_DestroyAsset( asset_id ) );
+
+    if ( isCanceled() )
+        emit canceled();
+    else
+        emit failed( QString::fromStdString( Engine::getInstance()->getLastError() ) );
+}
+
+void AssetLoader::run()
+{
+    Engine* hapi = Engine::getInstance();
+
+    emit progress( tr("Loading library"), 0, 0 );
+    int library_id = hapi->loadAssetLibrary( mFilename.toStdString().c_str() );
+    if ( library_id < 0 || !waitForReady( tr("Loading library") ) || isCanceled() )
+    {
+        abort( -1 );
+        return;
+    }
+
+    emit progress( tr("Instantiating"), 0, 0 );
+    std::string name = mAssetName.isEmpty() ? hapi->getAssetName( library_id, 0 )
+                                            : mAssetName.toStdString();
+    int asset_id = hapi->instantiateAsset( name.c_str(), false );
+    if ( asset_id < 0 || !waitForReady( tr("Instantiating") ) || isCanceled() )
+    {
+        abort( asset_id );
+        return;
+    }
+
+    emit progress( tr("Cooking"), 0, 0 );
+    try
+    {
+        Asset( asset_id ).cook();
+    }
+    catch ( Failure& )
+    {
+        abort( asset_id );
+        return;
+    }
+    if ( !waitForReady( tr("Cooking") ) || isCanceled() )
+    {
+        abort( asset_id );
+        return;
+    }
+
+    emit loaded( asset_id );
+}
+
+};
@@ -0,0 +1,51 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <QThread>
+#include <QString>
+#include <QAtomicInt>
+
+namespace hapi {
+
+//
+// Opens an asset off the GUI thread in stages: load the library,
+// instantiate without cooking, then cook while polling the cook state.
+// Building the parameter view is left to the receiver of loaded(), which
+// runs on the GUI thread.
+//
+class AssetLoader : public QThread
+{
+    Q_OBJECT
+public:
+    explicit AssetLoader( const QString& filename, QObject *parent = 0 );
+
+    const QString& filename() const { return mFilename; }
+
+    void    cancel();
+    bool    isCanceled() const;
+
+    // Must be set before start(); empty loads the first asset of the library.
+    void    setAssetName( const QString& name ) { mAssetName = name; }
+
+signals:
+    // maximum is 0 when the stage cannot report how far along it is.
+    void    progress( const QString& stage, int value, int maximum );
+    void    loaded( int asset_id );
+    void    failed( const QString& message );
+    void    canceled();
+
+protected:
+    virtual void run();
+
+private:
+    bool    waitForReady( const QString& stage );
+    void    abort( int asset_id );
+
+    QString         mFilename;
+    QString         mAssetName;
+    QAtomicInt      mCanceled;
+};
+
+};
+
+#endif // ASSETLOADER_H
@@ -0,0 +1,110 @@
+#include "attribbuffer.h"
+#include "stringcache.h"
+
+namespace hapi {
+
+// Resolve a negative length and set up the buffer bookkeeping.
+template <typename T>
+static AttribBuffer<T> prepare(
+        AttribBufferPool &pool, const HAPI_AttributeInfo &info,
+        int start, int &length)
+{
+    if (length < 0)
+        length = info.count - start;
+    if (length < 0)
+        length = 0;
+    return pool.acquire<T>(length * info.tupleSize);
+}
+
+AttribBufferPool::AttribBufferPool()
+    : mAllocations(0)
+{}
+
+AttribBuffer<int> AttribBufferPool::intData(
+        const Part &part, HAPI_AttributeOwner owner, const char *name,
+        int start, int length)
+{ return intData(part, part.attribInfo(owner, name), name, start, length); }
+
+AttribBuffer<float> AttribBufferPool::floatData(
+        const Part &part, HAPI_AttributeOwner owner, const char *name,
+        int start, int length)
+{ return floatData(part, part.attribInfo(owner, name), name, start, length); }
+
+AttribBuffer<std::string> AttribBufferPool::stringData(
+        const Part &part, HAPI_AttributeOwner owner, const char *name,
+        int start, int length)
+{ return stringData(part, part.attribInfo(owner, name), name, start, length); }
+
+AttribBuffer<int> AttribBufferPool::intData(
+        const Part &part, const HAPI_AttributeInfo &info, const char *name,
+        int start, int length)
+{
+    AttribBuffer<int> result = prepare<int>(*this, info, start, length);
+    result.mInfo = info;
+    result.mStart = start;
+    result.mCount = part.getAttribIntData(
+                result.mInfo, name, result.data(), start, length);
+    return result;
+}
+
+AttribBuffer<float> AttribBufferPool::floatData(
+        const Part &part, const HAPI_AttributeInfo &info, const char *name,
+        int start, int length)
+{
+    AttribBuffer<float> result = prepare<float>(*this, info, start, length);
+    result.mInfo = info;
+    result.mStart = start;
+    result.mCount = part.getAttribFloatData(
+                result.mInfo, name, result.data(), start, length);
+    return result;
+}
+
+AttribBuffer<std::string> AttribBufferPool::stringData(
+        const Part &part, const HAPI_AttributeInfo &info, const char *name,
+        int start, int length)
+{
+    AttribBuffer<std::string> result = prepare<std::string>(*this, info, start, length);
+    result.mInfo = info;
+    result.mStart = start;
+
+    // The handles go through a pooled scratch buffer too. result.size()
+    // is still 0 here, the count is only known once they are read.
+    AttribBuffer<int> handles = acquire<int>(length * info.tupleSize);
+    result.mCount = part.getAttribStringHandles(
+                result.mInfo, name, handles.data(), start, length);
+
+    StringCache* strings = StringCache::getInstance();
+    strings->resolve(handles.data(), result.size());
+    for (int i = 0; i < result.size(); ++i)
+        strings->get(handles[i], result[i]);
+    return result;
+}
+
+size_t AttribBufferPool::allocations() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mAllocations;
+}
+
+size_t AttribBufferPool::pooledBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t result = 0;
+    for (size_t i = 0; i < mInts.size(); ++i)
+        result += mInts[i].capacity() * sizeof(int);
+    for (size_t i = 0; i < mFloats.size(); ++i)
+        result += mFloats[i].capacity() * sizeof(float);
+    for (size_t i = 0; i < mStrings.size(); ++i)
+        result += mStrings[i].capacity() * sizeof(std::string);
+    return result;
+}
+
+void AttribBufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mInts.clear();
+    mFloats.clear();
+    mStrings.clear();
+}
+
+};
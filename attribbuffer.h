@@ -0,0 +1,213 @@
+#ifndef ATTRIBBUFFER_H
+#define ATTRIBBUFFER_H
+
+#include "HAPI_cpp.h"
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace hapi
+{
+
+class AttribBufferPool;
+
+//----------------------------------------------------------------------------
+// Pooled attribute storage:
+
+// RAII handle to attribute data extracted into pooled storage. The storage
+// goes back to its pool when the handle is destroyed, so extracting the same
+// attributes again after a cook reuses the memory instead of allocating.
+template <typename T>
+class AttribBuffer
+{
+public:
+    AttribBuffer()
+        : mPool(NULL), mStart(0), mCount(0)
+    { mInfo = HAPI_AttributeInfo(); }
+
+    AttribBuffer(AttribBuffer &&other)
+        : mPool(other.mPool), mData(std::move(other.mData)),
+          mInfo(other.mInfo), mStart(other.mStart), mCount(other.mCount)
+    {
+        other.mPool = NULL;
+        other.mCount = 0;
+    }
+
+    AttribBuffer &operator=(AttribBuffer &&other)
+    {
+        if (this != &other)
+        {
+            release();
+            mPool = other.mPool;
+            mData = std::move(other.mData);
+            mInfo = other.mInfo;
+            mStart = other.mStart;
+            mCount = other.mCount;
+            other.mPool = NULL;
+            other.mCount = 0;
+        }
+        return *this;
+    }
+
+    ~AttribBuffer() { release(); }
+
+    const HAPI_AttributeInfo &info() const { return mInfo; }
+    int tupleSize() const { return mInfo.tupleSize; }
+    // First element and number of elements held.
+    int start() const { return mStart; }
+    int count() const { return mCount; }
+    // Number of values, i.e. count() * tupleSize().
+    int size() const { return mCount * mInfo.tupleSize; }
+    bool empty() const { return mCount == 0; }
+
+    T *data() { return mData.empty() ? NULL : &mData[0]; }
+    const T *data() const { return mData.empty() ? NULL : &mData[0]; }
+    T &operator[](int index) { return mData[index]; }
+    const T &operator[](int index) const { return mData[index]; }
+
+    inline void release();
+
+private:
+    AttribBuffer(const AttribBuffer &);
+    AttribBuffer &operator=(const AttribBuffer &);
+
+    friend class AttribBufferPool;
+
+    AttribBufferPool *mPool;
+    std::vector<T> mData;
+    HAPI_AttributeInfo mInfo;
+    int mStart;
+    int mCount;
+};
+
+// Recycles the storage behind AttribBuffers. The pool is thread-safe;
+// individual buffers are not.
+class AttribBufferPool
+{
+public:
+    AttribBufferPool();
+
+    AttribBuffer<int> intData(
+        const Part &part, HAPI_AttributeOwner owner, const char *name,
+        int start = 0, int length = -1);
+    AttribBuffer<float> floatData(
+        const Part &part, HAPI_AttributeOwner owner, const char *name,
+        int start = 0, int length = -1);
+    AttribBuffer<std::string> stringData(
+        const Part &part, HAPI_AttributeOwner owner, const char *name,
+        int start = 0, int length = -1);
+
+    // Same as above, for callers that already hold the attribute info.
+    AttribBuffer<int> intData(
+        const Part &part, const HAPI_AttributeInfo &info, const char *name,
+        int start = 0, int length = -1);
+    AttribBuffer<float> floatData(
+        const Part &part, const HAPI_AttributeInfo &info, const char *name,
+        int start = 0, int length = -1);
+    AttribBuffer<std::string> stringData(
+        const Part &part, const HAPI_AttributeInfo &info, const char *name,
+        int start = 0, int length = -1);
+
+    // Hand out an uninitialized buffer of count scalar values.
+    template <typename T> AttribBuffer<T> acquire(int count);
+
+    // Number of times a buffer had to be allocated or grown.
+    size_t allocations() const;
+    // Bytes currently parked in the pool.
+    size_t pooledBytes() const;
+    // Free every parked buffer.
+    void trim();
+
+private:
+    template <typename T> friend class AttribBuffer;
+
+    template <typename T> std::vector<T> take(int count);
+    template <typename T> void give(std::vector<T> &data);
+
+    std::vector< std::vector<int> > &freeList(int *) { return mInts; }
+    std::vector< std::vector<float> > &freeList(float *) { return mFloats; }
+    std::vector< std::vector<std::string> > &freeList(std::string *) { return mStrings; }
+
+    mutable std::mutex mMutex;
+    std::vector< std::vector<int> > mInts;
+    std::vector< std::vector<float> > mFloats;
+    std::vector< std::vector<std::string> > mStrings;
+    size_t mAllocations;
+};
+
+template <typename T>
+void AttribBuffer<T>::release()
+{
+    if (mPool)
+        mPool->give(mData);
+    mPool = NULL;
+    mData.clear();
+    mCount = 0;
+}
+
+// Pick the smallest parked buffer that fits, or grow the largest one.
+template <typename T>
+std::vector<T> AttribBufferPool::take(int count)
+{
+    std::vector<T> result;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector< std::vector<T> > &free_list = freeList((T *)NULL);
+
+        int best = -1;
+        for (int i = 0; i < int(free_list.size()); ++i)
+        {
+            size_t capacity = free_list[i].capacity();
+            if (best < 0)
+            {
+                best = i;
+                continue;
+            }
+            size_t best_capacity = free_list[best].capacity();
+            bool fits = capacity >= size_t(count);
+            bool best_fits = best_capacity >= size_t(count);
+            if ((fits && (!best_fits || capacity < best_capacity)) ||
+                (!fits && !best_fits && capacity > best_capacity))
+                best = i;
+        }
+
+        if (best >= 0)
+        {
+            result.swap(free_list[best]);
+            free_list.erase(free_list.begin() + best);
+        }
+        if (result.capacity() < size_t(count))
+            ++mAllocations;
+    }
+    result.resize(count);
+    return result;
+}
+
+template <typename T>
+void AttribBufferPool::give(std::vector<T> &data)
+{
+    if (data.capacity() == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector< std::vector<T> > &free_list = freeList((T *)NULL);
+    free_list.push_back(std::vector<T>());
+    free_list.back().swap(data);
+}
+
+template <typename T>
+AttribBuffer<T> AttribBufferPool::acquire(int count)
+{
+    AttribBuffer<T> result;
+    result.mPool = this;
+    result.mData = take<T>(count);
+    result.mInfo.exists = true;
+    result.mInfo.count = count;
+    result.mInfo.tupleSize = 1;
+    result.mCount = count;
+    return result;
+}
+
+}
+
+#endif // ATTRIBBUFFER_H
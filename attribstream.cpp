@@ -0,0 +1,122 @@
+#include "attribstream.h"
+#include <algorithm>
+
+namespace hapi {
+
+AttribStream::Chunk::Chunk(Chunk &&other)
+    : start(other.start), count(other.count),
+      ints(std::move(other.ints)), floats(std::move(other.floats)),
+      strings(std::move(other.strings))
+{}
+
+AttribStream::Chunk & AttribStream::Chunk::operator=(Chunk &&other)
+{
+    start = other.start;
+    count = other.count;
+    ints = std::move(other.ints);
+    floats = std::move(other.floats);
+    strings = std::move(other.strings);
+    return *this;
+}
+
+AttribStream::AttribStream(const Part &part, int chunk_size,
+                           AttribBufferPool *pool)
+    : _part(part),
+      _chunk_size(chunk_size > 0 ? chunk_size : 1),
+      _pool(pool ? pool : &_own_pool),
+      _total(0),
+      _started(false)
+{}
+
+AttribStream::~AttribStream()
+{
+    if (_next.valid())
+        _next.wait();
+}
+
+int AttribStream::addAttrib(HAPI_AttributeOwner owner, const char *name)
+{
+    Slot slot;
+    slot.name = name;
+    slot.info = _part.attribInfo(owner, name);
+
+    if (!slot.info.exists || _started ||
+        (!_slots.empty() && slot.info.count != _total))
+        throw Failure(HAPI_RESULT_INVALID_ARGUMENT);
+
+    _total = slot.info.count;
+    _slots.push_back(slot);
+    return int(_slots.size()) - 1;
+}
+
+// Runs on the prefetch thread. Only touches state that is immutable once
+// streaming started, plus the thread-safe pool.
+AttribStream::Chunk AttribStream::fetch(int start) const
+{
+    Chunk chunk;
+    chunk.start = start;
+    chunk.count = std::min(_chunk_size, _total - start);
+
+    int slots = int(_slots.size());
+    chunk.ints.resize(slots);
+    chunk.floats.resize(slots);
+    chunk.strings.resize(slots);
+
+    for (int i = 0; i < slots; ++i)
+    {
+        const Slot &slot = _slots[i];
+        const char *name = slot.name.c_str();
+        switch (slot.info.storage)
+        {
+        case HAPI_STORAGETYPE_INT:
+            chunk.ints[i] = _pool->intData(_part, slot.info, name, start, chunk.count);
+            break;
+        case HAPI_STORAGETYPE_FLOAT:
+            chunk.floats[i] = _pool->floatData(_part, slot.info, name, start, chunk.count);
+            break;
+        case HAPI_STORAGETYPE_STRING:
+            chunk.strings[i] = _pool->stringData(_part, slot.info, name, start, chunk.count);
+            break;
+        default:
+            break;
+        }
+    }
+    return chunk;
+}
+
+void AttribStream::prefetch(int start)
+{
+    if (start < _total)
+        _next = std::async(std::launch::async, &AttribStream::fetch, this, start);
+}
+
+bool AttribStream::next()
+{
+    if (!_started)
+    {
+        _started = true;
+        prefetch(0);
+    }
+
+    // Hand the consumed chunk back to the pool before taking the next one,
+    // so no more than two chunks ever exist.
+    _current = Chunk();
+
+    if (!_next.valid())
+        return false;
+
+    _current = _next.get();
+    prefetch(_current.start + _current.count);
+    return true;
+}
+
+void AttribStream::rewind()
+{
+    if (_next.valid())
+        _next.wait();
+    _next = std::future<Chunk>();
+    _current = Chunk();
+    _started = false;
+}
+
+};
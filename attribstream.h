@@ -0,0 +1,87 @@
+#ifndef ATTRIBSTREAM_H
+#define ATTRIBSTREAM_H
+
+#include "HAPI_cpp.h"
+#include "attribbuffer.h"
+#include <future>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Chunked attribute reader:
+
+// Walks one or more attributes of a part in fixed-size windows using the
+// start/length arguments of HAPI_GetAttribute*Data. While the caller works
+// on the current chunk the next one is fetched on a background thread, so
+// at most two chunks are alive at any time regardless of the part size.
+//
+// All attributes in a stream must have the same element count (e.g. all
+// point attributes). The caller must not make other HAPI calls while the
+// stream is between next() calls, since the prefetch may be running.
+class AttribStream
+{
+public:
+    AttribStream(const Part &part, int chunk_size = 65536,
+                 AttribBufferPool *pool = NULL);
+    ~AttribStream();
+
+    // Returns the slot index used to read the attribute back.
+    int addAttrib(HAPI_AttributeOwner owner, const char *name);
+
+    int chunkSize() const { return _chunk_size; }
+    int totalCount() const { return _total; }
+
+    // Advance to the next chunk. Returns false once every element was read.
+    bool next();
+    void rewind();
+
+    // Window of the current chunk, in elements.
+    int start() const { return _current.start; }
+    int count() const { return _current.count; }
+
+    const HAPI_AttributeInfo &info(int slot) const { return _slots[slot].info; }
+    const AttribBuffer<int> &intData(int slot) const { return _current.ints[slot]; }
+    const AttribBuffer<float> &floatData(int slot) const { return _current.floats[slot]; }
+    const AttribBuffer<std::string> &stringData(int slot) const { return _current.strings[slot]; }
+
+private:
+    AttribStream(const AttribStream &);
+    AttribStream &operator=(const AttribStream &);
+
+    struct Slot
+    {
+        std::string name;
+        HAPI_AttributeInfo info;
+    };
+
+    struct Chunk
+    {
+        Chunk() : start(0), count(0) {}
+        Chunk(Chunk &&other);
+        Chunk &operator=(Chunk &&other);
+
+        int start;
+        int count;
+        std::vector< AttribBuffer<int> > ints;
+        std::vector< AttribBuffer<float> > floats;
+        std::vector< AttribBuffer<std::string> > strings;
+    };
+
+    Chunk fetch(int start) const;
+    void prefetch(int start);
+
+    Part _part;
+    int _chunk_size;
+    AttribBufferPool _own_pool;
+    AttribBufferPool *_pool;
+    std::vector<Slot> _slots;
+    int _total;
+    bool _started;
+    Chunk _current;
+    std::future<Chunk> _next;
+};
+
+}
+
+#endif // ATTRIBSTREAM_H
@@ -0,0 +1,446 @@
+#include "batchcooker.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#define POLL_INTERVAL_MS        (10)
+
+namespace hapi {
+
+typedef std::chrono::steady_clock Clock;
+
+static double Seconds( Clock::time_point start )
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+static bool IsIntParm( const HAPI_ParmInfo& info )
+{
+    return info.type == HAPI_PARMTYPE_INT || info.type == HAPI_PARMTYPE_MULTIPARMLIST ||
+           info.type == HAPI_PARMTYPE_TOGGLE || info.type == HAPI_PARMTYPE_BUTTON;
+}
+
+static bool IsFloatParm( const HAPI_ParmInfo& info )
+{
+    return info.type == HAPI_PARMTYPE_FLOAT || info.type == HAPI_PARMTYPE_COLOR;
+}
+
+static bool IsStringParm( const HAPI_ParmInfo& info )
+{
+    return info.type == HAPI_PARMTYPE_STRING || info.type == HAPI_PARMTYPE_PATH_NODE ||
+           info.type == HAPI_PARMTYPE_PATH_FILE || info.type == HAPI_PARMTYPE_PATH_FILE_GEO ||
+           info.type == HAPI_PARMTYPE_PATH_FILE_IMAGE;
+}
+
+// Keep variation names usable as file names.
+static std::string FileName( const std::string& name )
+{
+    std::string result( name );
+    for ( size_t i = 0; i < result.size(); ++i )
+    {
+        char c = result[i];
+        if ( !( ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ||
+                ( c >= '0' && c <= '9' ) || c == '-' || c == '_' || c == '.' ) )
+            result[i] = '_';
+    }
+    return result;
+}
+
+VariationStats::VariationStats() :
+    ok(false), apply_time(0), cook_time(0), extract_time(0), write_time(0),
+    set_calls(0), meshes(0), triangles(0), bytes(0)
+{
+}
+
+double VariationStats::totalTime() const
+{
+    return apply_time + cook_time + extract_time + write_time;
+}
+
+BatchCooker::BatchCooker( int worker_count ) :
+    mExporter(worker_count),
+    mAssetId(-1),
+    mLibraryHash(0),
+    mCookCache(nullptr),
+    mCookCacheHits(0)
+{
+}
+
+BatchCooker::~BatchCooker()
+{
+    if ( mAssetId >= 0 )
+        HAPI_TRACE( HAPI_DestroyAsset( mAssetId ) );
+}
+
+bool BatchCooker::open( const std::string& library_path, const std::string& asset_name )
+{
+    Engine* hapi = Engine::getInstance();
+
+    int library_id = hapi->loadAssetLibrary( library_path.c_str() );
+    if ( library_id < 0 )
+    {
+        mError = "cannot load " + library_path + ": " + hapi->getLastError();
+        return false;
+    }
+
+    std::string name = asset_name;
+    if ( name.empty() )
+        name = hapi->getAssetName( library_id, 0 );
+    if ( name.empty() )
+    {
+        mError = library_path + " contains no assets";
+        return false;
+    }
+
+    mAssetId = hapi->instantiateAsset( name.c_str(), false );
+    if ( mAssetId < 0 )
+    {
+        mError = "cannot instantiate " + name + ": " + hapi->getLastError();
+        return false;
+    }
+    mAssetName = name;
+
+    // One pass over the library per run, keying both caches; 0 leaves the
+    // cook cache unused.
+    mLibraryHash = CookCache::hashFile( library_path );
+
+    try
+    {
+        Asset asset( mAssetId );
+        mParms = asset.parmMap();
+        std::shared_ptr<ParmValueStore> values = asset.parmValues();
+        for ( std::map<std::string, Parm>::const_iterator it = mParms.begin(); it != mParms.end(); ++it )
+        {
+            const HAPI_ParmInfo& info = it->second.info();
+            ParmDefault& defaults = mDefaults[ it->first ];
+            for ( int i = 0; i < info.size; ++i )
+            {
+                if ( IsIntParm( info ) && info.type != HAPI_PARMTYPE_BUTTON )
+                    defaults.ints.push_back( values->intValue( info.intValuesIndex + i ) );
+                else if ( IsFloatParm( info ) )
+                    defaults.floats.push_back( values->floatValue( info.floatValuesIndex + i ) );
+                else if ( IsStringParm( info ) )
+                    defaults.strings.push_back( values->stringValue( info.stringValuesIndex + i ) );
+            }
+        }
+    }
+    catch ( Failure& )
+    {
+        mError = "cannot read the parms of " + name + ": " + Failure::lastErrorMessage();
+        return false;
+    }
+    return true;
+}
+
+const Parm* BatchCooker::findParm( const std::string& name )
+{
+    std::map<std::string, Parm>::const_iterator it = mParms.find( name );
+    return it != mParms.end() ? &it->second : nullptr;
+}
+
+// Queue the parm's instantiation values. Parms of multiparm instances made
+// after instantiation have none and go away with their instance. Returns
+// true when that changes a multiparm count.
+bool BatchCooker::restore( ParmTransaction& transaction, const Parm& parm )
+{
+    std::map<std::string, ParmDefault>::const_iterator it = mDefaults.find( parm.name() );
+    if ( it == mDefaults.end() )
+        return false;
+
+    const ParmDefault& defaults = it->second;
+    const HAPI_ParmInfo& info = parm.info();
+    for ( int i = 0; i < info.size; ++i )
+    {
+        if ( i < int( defaults.ints.size() ) )
+            transaction.setIntValue( parm, i, defaults.ints[i] );
+        else if ( i < int( defaults.floats.size() ) )
+            transaction.setFloatValue( parm, i, defaults.floats[i] );
+        else if ( i < int( defaults.strings.size() ) )
+            transaction.setStringValue( parm, i, defaults.strings[i].c_str() );
+    }
+    return info.type == HAPI_PARMTYPE_MULTIPARMLIST;
+}
+
+bool BatchCooker::apply( const SweepVariation& variation, VariationStats& stats )
+{
+    ParmTransaction transaction( ( Asset( mAssetId ) ) );
+
+    // Undo the previous variation first, whole parms at a time so that
+    // components this variation leaves alone don't keep its values. The
+    // writes below override the restored ones where they overlap.
+    bool multiparm_changed = false;
+    for ( std::set<std::string>::const_iterator it = mTouched.begin(); it != mTouched.end(); ++it )
+    {
+        const Parm* parm = findParm( *it );
+        if ( parm )
+            multiparm_changed |= restore( transaction, *parm );
+    }
+    mTouched.clear();
+    for ( size_t i = 0; i < variation.values.size(); ++i )
+        mTouched.insert( variation.values[i].parm );
+
+    for ( size_t v = 0; v < variation.values.size(); ++v )
+    {
+        const SweepValue& value = variation.values[v];
+        char line[32];
+        snprintf( line, sizeof(line), " (line %d)", value.line );
+
+        const Parm* parm = findParm( value.parm );
+        if ( !parm )
+        {
+            stats.error = "unknown parm '" + value.parm + "'" + line;
+            return false;
+        }
+
+        const HAPI_ParmInfo& info = parm->info();
+        if ( value.sub_index + int( value.components.size() ) > info.size )
+        {
+            stats.error = "too many values for '" + value.parm + "'" + line;
+            return false;
+        }
+
+        for ( size_t c = 0; c < value.components.size(); ++c )
+        {
+            const std::string& text = value.components[c];
+            int sub_index = value.sub_index + int( c );
+            char* end = nullptr;
+
+            if ( IsIntParm( info ) )
+            {
+                long number = strtol( text.c_str(), &end, 10 );
+                if ( text.empty() || *end != '\0' )
+                {
+                    stats.error = "'" + text + "' is not an integer" + line;
+                    return false;
+                }
+                transaction.setIntValue( *parm, sub_index, int( number ) );
+                multiparm_changed |= info.type == HAPI_PARMTYPE_MULTIPARMLIST;
+            }
+            else if ( IsFloatParm( info ) )
+            {
+                double number = strtod( text.c_str(), &end );
+                if ( text.empty() || *end != '\0' )
+                {
+                    stats.error = "'" + text + "' is not a number" + line;
+                    return false;
+                }
+                transaction.setFloatValue( *parm, sub_index, float( number ) );
+            }
+            else if ( IsStringParm( info ) )
+            {
+                transaction.setStringValue( *parm, sub_index, text.c_str() );
+            }
+            else
+            {
+                stats.error = "'" + value.parm + "' has no value" + line;
+                return false;
+            }
+        }
+    }
+
+    stats.set_calls = transaction.commit( false );
+
+    // New multiparm instances bring new parms with them.
+    if ( multiparm_changed )
+        mParms = Asset( mAssetId ).parmMap();
+    return true;
+}
+
+// Cooks the asset and exports its geometry into the result cache under key.
+// Sets stats.error when the cook fails. Throws Failure.
+std::vector< std::shared_ptr<ExportedMesh> > BatchCooker::cookMeshes( const Asset& asset, uint64_t key,
+                                                                      VariationStats& stats )
+{
+    Clock::time_point start = Clock::now();
+    asset.cook();
+
+    // Only needed when the engine runs its cooking thread.
+    int state = HAPI_STATE_READY;
+    HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) );
+    while ( state > HAPI_STATE_MAX_READY_STATE )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( POLL_INTERVAL_MS ) );
+        HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) );
+    }
+    stats.cook_time = Seconds( start );
+    if ( state == HAPI_STATE_READY_WITH_FATAL_ERRORS )
+    {
+        stats.error = "cook failed: " + Engine::getInstance()->getLastError();
+        return std::vector< std::shared_ptr<ExportedMesh> >();
+    }
+
+    start = Clock::now();
+    std::shared_ptr<CookResult> result( new CookResult );
+    result->meshes = mExporter.exportAsset( asset );
+    stats.extract_time = Seconds( start );
+
+    mResults.insert( key, result );
+    return result->meshes;
+}
+
+// Copies the meshes of a cook cache hit; the engine's own export would have
+// made the same ones.
+bool BatchCooker::findCooked( uint64_t key, std::vector< std::shared_ptr<ExportedMesh> >& meshes )
+{
+    std::shared_ptr<const CachedCook> cooked = mCookCache && mLibraryHash ? mCookCache->find( key ) : nullptr;
+    if ( !cooked )
+        return false;
+
+    meshes.clear();
+    for ( int i = 0; i < cooked->meshCount(); ++i )
+        meshes.push_back( cooked->mesh( i ).toExportedMesh( mAssetId ) );
+    ++mCookCacheHits;
+    return true;
+}
+
+VariationStats BatchCooker::cook( const SweepVariation& variation )
+{
+    VariationStats stats;
+    stats.name = variation.name;
+
+    try
+    {
+        Clock::time_point start = Clock::now();
+        bool applied = apply( variation, stats );
+        stats.apply_time = Seconds( start );
+        if ( !applied )
+            return stats;
+
+        Asset asset( mAssetId );
+        std::shared_ptr<ParmValueStore> values = asset.parmValues();
+        uint64_t key = CookCache::makeKey( mLibraryHash, mAssetName, *values );
+
+        std::shared_ptr<const CookResult> cached = mResults.find( key );
+        std::vector< std::shared_ptr<ExportedMesh> > meshes;
+        if ( cached )
+            meshes = cached->meshes;
+        else if ( findCooked( key, meshes ) )
+        {
+            std::shared_ptr<CookResult> result( new CookResult );
+            result->meshes = meshes;
+            mResults.insert( key, result );
+        }
+        else
+        {
+            meshes = cookMeshes( asset, key, stats );
+            if ( !stats.error.empty() )
+                return stats;
+            // A failed store only costs the next run a cook.
+            if ( mCookCache && mLibraryHash )
+                mCookCache->store( key, meshes );
+        }
+
+        stats.meshes = int( meshes.size() );
+        for ( size_t i = 0; i < meshes.size(); ++i )
+            stats.triangles += meshes[i]->indices.size() / 3;
+
+        if ( !mOutputDirectory.empty() )
+        {
+            start = Clock::now();
+            std::string path = mOutputDirectory + "/" + FileName( variation.name ) + ".obj";
+            bool written = writeObj( path, meshes, stats.bytes );
+            stats.write_time = Seconds( start );
+            if ( !written )
+            {
+                stats.error = "cannot write " + path;
+                return stats;
+            }
+        }
+    }
+    catch ( Failure& )
+    {
+        stats.error = Failure::lastErrorMessage();
+        return stats;
+    }
+
+    stats.ok = true;
+    return stats;
+}
+
+// World-space positions and normals; one OBJ object per part. A variation
+// without geometry gets an empty file. Sets bytes to the size written.
+bool BatchCooker::writeObj( const std::string& path,
+                            const std::vector< std::shared_ptr<ExportedMesh> >& meshes,
+                            size_t& bytes )
+{
+    bytes = 0;
+    FILE* file = fopen( path.c_str(), "wb" );
+    if ( !file )
+        return false;
+
+    size_t vertex_base = 1;
+    for ( size_t m = 0; m < meshes.size(); ++m )
+    {
+        const ExportedMesh& mesh = *meshes[m];
+        const float* t = mesh.transform;
+        int vertex_count = mesh.stride ? int( mesh.vertices.size() ) / mesh.stride : 0;
+        int uv_offset = mesh.has_normals ? 6 : 3;
+
+        fprintf( file, "o %s\n", mesh.name.empty() ? "part" : mesh.name.c_str() );
+        for ( int i = 0; i < vertex_count; ++i )
+        {
+            const float* v = &mesh.vertices[ i * mesh.stride ];
+            fprintf( file, "v %g %g %g\n",
+                     v[0] * t[0] + v[1] * t[4] + v[2] * t[8] + t[12],
+                     v[0] * t[1] + v[1] * t[5] + v[2] * t[9] + t[13],
+                     v[0] * t[2] + v[1] * t[6] + v[2] * t[10] + t[14] );
+        }
+        if ( mesh.has_normals )
+        {
+            for ( int i = 0; i < vertex_count; ++i )
+            {
+                const float* n = &mesh.vertices[ i * mesh.stride + 3 ];
+                float x = n[0] * t[0] + n[1] * t[4] + n[2] * t[8];
+                float y = n[0] * t[1] + n[1] * t[5] + n[2] * t[9];
+                float z = n[0] * t[2] + n[1] * t[6] + n[2] * t[10];
+                float length = std::sqrt( x * x + y * y + z * z );
+                if ( length > 0.f )
+                {
+                    x /= length;
+                    y /= length;
+                    z /= length;
+                }
+                fprintf( file, "vn %g %g %g\n", x, y, z );
+            }
+        }
+        if ( mesh.has_uvs )
+        {
+            for ( int i = 0; i < vertex_count; ++i )
+            {
+                const float* uv = &mesh.vertices[ i * mesh.stride + uv_offset ];
+                fprintf( file, "vt %g %g\n", uv[0], uv[1] );
+            }
+        }
+
+        for ( size_t i = 0; i + 2 < mesh.indices.size(); i += 3 )
+        {
+            fputc( 'f', file );
+            for ( int corner = 0; corner < 3; ++corner )
+            {
+                unsigned long index = (unsigned long)( vertex_base + mesh.indices[ i + corner ] );
+                if ( mesh.has_normals && mesh.has_uvs )
+                    fprintf( file, " %lu/%lu/%lu", index, index, index );
+                else if ( mesh.has_normals )
+                    fprintf( file, " %lu//%lu", index, index );
+                else if ( mesh.has_uvs )
+                    fprintf( file, " %lu/%lu", index, index );
+                else
+                    fprintf( file, " %lu", index );
+            }
+            fputc( '\n', file );
+        }
+
+        vertex_base += vertex_count;
+    }
+
+    long size = ftell( file );
+    bool ok = size >= 0 && !ferror( file );
+    ok = fclose( file ) == 0 && ok;
+    if ( ok )
+        bytes = size_t( size );
+    return ok;
+}
+
+};
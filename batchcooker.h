@@ -0,0 +1,115 @@
+#ifndef BATCHCOOKER_H
+#define BATCHCOOKER_H
+
+#include "HAPI_cpp.h"
+#include "cookcache.h"
+#include "geoexport.h"
+#include "resultcache.h"
+#include "sweepfile.h"
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Headless batch cooking:
+
+struct VariationStats
+{
+    VariationStats();
+
+    std::string name;
+    bool        ok;
+    std::string error;
+
+    // Seconds spent in each stage.
+    double      apply_time;
+    double      cook_time;
+    double      extract_time;
+    double      write_time;
+
+    int         set_calls;
+    int         meshes;
+    size_t      triangles;
+    size_t      bytes;
+
+    double      totalTime() const;
+};
+
+// Cooks one asset through a list of parameter variations: each variation is
+// applied as one ParmTransaction, cooked, exported through GeometryExporter
+// and optionally written as a Wavefront OBJ named after the variation.
+// Parms a variation does not mention are back at the values the asset was
+// instantiated with, so the order of variations does not matter. Sweeps
+// that come back to a parameter state already cooked take its geometry from
+// a result cache and skip the cook and export. With a cook cache set, so do
+// states cooked by an earlier run or by another worker process.
+//
+// The engine must be initialized, preferably without the cooking thread so
+// cooks block until done.
+class BatchCooker
+{
+public:
+    // A worker count of 0 uses one exporter worker per hardware thread.
+    explicit BatchCooker( int worker_count = 0 );
+    ~BatchCooker();
+
+    // Loads the library and instantiates asset_name, or its first asset when
+    // the name is empty. The asset is not cooked.
+    bool            open( const std::string& library_path, const std::string& asset_name );
+    int             assetId() const { return mAssetId; }
+    const std::string& error() const { return mError; }
+
+    // An empty directory skips writing.
+    void            setOutputDirectory( const std::string& directory ) { mOutputDirectory = directory; }
+    // Null turns the persistent cache off; it must outlive the cooker.
+    void            setCookCache( CookCache* cache ) { mCookCache = cache; }
+    // Variations whose geometry came from the cook cache.
+    int             cookCacheHits() const { return mCookCacheHits; }
+
+    VariationStats  cook( const SweepVariation& variation );
+
+    const ResultCache& resultCache() const { return mResults; }
+
+private:
+    // The instantiation values of a parm, by sub index.
+    struct ParmDefault
+    {
+        std::vector<int>            ints;
+        std::vector<float>          floats;
+        std::vector<std::string>    strings;
+    };
+
+    bool            apply( const SweepVariation& variation, VariationStats& stats );
+    bool            restore( ParmTransaction& transaction, const Parm& parm );
+    const Parm*     findParm( const std::string& name );
+    std::vector< std::shared_ptr<ExportedMesh> > cookMeshes( const Asset& asset, uint64_t key,
+                                                             VariationStats& stats );
+    bool            findCooked( uint64_t key, std::vector< std::shared_ptr<ExportedMesh> >& meshes );
+    bool            writeObj( const std::string& path,
+                              const std::vector< std::shared_ptr<ExportedMesh> >& meshes,
+                              size_t& bytes );
+
+    GeometryExporter            mExporter;
+    ResultCache                 mResults;
+    int                         mAssetId;
+    std::string                 mAssetName;
+    // Content hash of the library, for the keys of both caches.
+    uint64_t                    mLibraryHash;
+    CookCache*                  mCookCache;
+    int                         mCookCacheHits;
+    std::map<std::string, Parm> mParms;
+    // By name: value indices move once a multiparm changes its instance count.
+    std::map<std::string, ParmDefault> mDefaults;
+    std::set<std::string>       mTouched;
+    std::string                 mOutputDirectory;
+    std::string                 mError;
+};
+
+}
+
+#endif // BATCHCOOKER_H
@@ -0,0 +1,325 @@
+#include "batchcooker.h"
+#include "cookfarm.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QThread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace hapi;
+
+static void usage()
+{
+    fprintf( stderr,
+             "usage: HoudiniEngineBatch [-o dir] [-a asset] [-j workers] [-p processes]\n"
+             "                          [-t trace.json] [-T seconds] [-c dir] [--no-write]\n"
+             "                          asset.hda sweep.txt\n"
+             "\n"
+             "  -o dir       write <dir>/<variation>.obj (default: current directory)\n"
+             "  -a asset     asset to instantiate (default: first in the library)\n"
+             "  -j workers   geometry export workers per engine (default: hardware\n"
+             "               threads, shared out between processes)\n"
+             "  -p processes cook variations in parallel on this many worker\n"
+             "               processes, each with its own engine (0: one per\n"
+             "               hardware thread)\n"
+             "  -t file      write a Chrome trace of every HAPI call (needs a\n"
+             "               build with CONFIG+=hapi_tracing, not with -p)\n"
+             "  -T seconds   with -p, kill a worker that takes longer than this on\n"
+             "               one variation and retry it on a fresh one (default:\n"
+             "               600, 0: never)\n"
+             "  -c dir       keep cooked geometry in a cache in dir, shared between\n"
+             "               runs and processes; variations found there are not\n"
+             "               cooked again\n"
+             "  --no-write   cook and export only\n" );
+}
+
+static void PrintHeader()
+{
+    printf( "%-24s %9s %9s %9s %9s %10s %10s\n",
+            "variation", "apply", "cook", "extract", "write", "triangles", "MB" );
+}
+
+// Prints the row of one variation and adds it to total.
+static void PrintRow( const VariationStats& stats, VariationStats& total )
+{
+    if ( !stats.ok )
+    {
+        printf( "%-24s FAILED: %s\n", stats.name.c_str(), stats.error.c_str() );
+        fflush( stdout );
+        return;
+    }
+
+    printf( "%-24s %8.1fms %8.1fms %8.1fms %8.1fms %10lu %10.2f\n",
+            stats.name.c_str(),
+            stats.apply_time * 1000.0, stats.cook_time * 1000.0,
+            stats.extract_time * 1000.0, stats.write_time * 1000.0,
+            (unsigned long)stats.triangles, stats.bytes / ( 1024.0 * 1024.0 ) );
+    fflush( stdout );
+
+    total.apply_time += stats.apply_time;
+    total.cook_time += stats.cook_time;
+    total.extract_time += stats.extract_time;
+    total.write_time += stats.write_time;
+    total.triangles += stats.triangles;
+    total.bytes += stats.bytes;
+}
+
+static void PrintSummary( int cooked, int count, double elapsed, const VariationStats& total )
+{
+    printf( "\n%d of %d variations cooked in %.2fs: %.2f cooks/s, %.2f MB/s written\n",
+            cooked, count, elapsed,
+            elapsed > 0.0 ? cooked / elapsed : 0.0,
+            elapsed > 0.0 ? total.bytes / ( 1024.0 * 1024.0 ) / elapsed : 0.0 );
+    printf( "time in apply %.2fs, cook %.2fs, extract %.2fs, write %.2fs\n",
+            total.apply_time, total.cook_time, total.extract_time, total.write_time );
+}
+
+// Worker side of CookFarm: open the asset, then cook the variations whose
+// indices arrive on stdin until it is closed.
+static int RunWorker( const SweepFile& sweep, const std::string& library_path,
+                      const std::string& asset_name, const std::string& output_directory,
+                      CookCache* cook_cache, int worker_count )
+{
+    Engine* hapi = Engine::getInstance();
+    if ( !hapi->initialize( nullptr, nullptr, false ) )
+    {
+        printf( "error\tcannot initialize Houdini Engine: %s\n", hapi->getLastError().c_str() );
+        return 1;
+    }
+    hapi->setLoadMode( Engine::LOAD_FROM_MEMORY );
+
+    const std::vector<SweepVariation>& variations = sweep.variations();
+    {
+        BatchCooker cooker( worker_count );
+        cooker.setOutputDirectory( output_directory );
+        cooker.setCookCache( cook_cache );
+        if ( !cooker.open( library_path, asset_name ) )
+        {
+            printf( "error\t%s\n", cooker.error().c_str() );
+            fflush( stdout );
+            hapi->cleanup();
+            return 1;
+        }
+        printf( "ready\n" );
+        fflush( stdout );
+
+        char line[64];
+        while ( fgets( line, sizeof(line), stdin ) )
+        {
+            int index = atoi( line );
+            if ( index < 0 || index >= int( variations.size() ) )
+                continue;
+
+            // Starts on a line of its own even when a library left one open.
+            VariationStats stats = cooker.cook( variations[ index ] );
+            printf( "\n%s\n", CookFarm::encodeResult( index, stats ).c_str() );
+            fflush( stdout );
+        }
+    }
+
+    hapi->cleanup();
+    return 0;
+}
+
+static int RunFarm( int argc, char *argv[], const SweepFile& sweep, int process_count,
+                    int job_timeout, const QStringList& worker_arguments )
+{
+    QCoreApplication app( argc, argv );
+
+    const std::vector<SweepVariation>& variations = sweep.variations();
+    CookFarm farm( QCoreApplication::applicationFilePath(), worker_arguments, process_count );
+    if ( job_timeout >= 0 )
+        farm.setJobTimeout( job_timeout * 1000 );
+
+    VariationStats total;
+    int failures = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    PrintHeader();
+    bool ok = farm.run( int( variations.size() ), [&]( int index, const VariationStats& result ) {
+        VariationStats stats( result );
+        stats.name = variations[ index ].name;
+        if ( !stats.ok )
+            ++failures;
+        PrintRow( stats, total );
+    } );
+    if ( !ok )
+    {
+        fprintf( stderr, "%s\n", farm.error().c_str() );
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start ).count();
+    PrintSummary( int( variations.size() ) - failures, int( variations.size() ), elapsed, total );
+    printf( "%d processes, %d worker crashes\n", process_count, farm.crashCount() );
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output_directory = ".";
+    std::string asset_name;
+    std::string library_path;
+    std::string sweep_path;
+    std::string trace_path;
+    std::string cache_directory;
+    int worker_count = 0;
+    int process_count = -1;
+    int job_timeout = -1;
+    bool worker = false;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( !strcmp( argv[i], "-o" ) && i + 1 < argc )
+            output_directory = argv[++i];
+        else if ( !strcmp( argv[i], "-a" ) && i + 1 < argc )
+            asset_name = argv[++i];
+        else if ( !strcmp( argv[i], "-j" ) && i + 1 < argc )
+            worker_count = atoi( argv[++i] );
+        else if ( !strcmp( argv[i], "-p" ) && i + 1 < argc )
+            process_count = atoi( argv[++i] );
+        else if ( !strcmp( argv[i], "-t" ) && i + 1 < argc )
+            trace_path = argv[++i];
+        else if ( !strcmp( argv[i], "-T" ) && i + 1 < argc )
+            job_timeout = atoi( argv[++i] );
+        else if ( !strcmp( argv[i], "-c" ) && i + 1 < argc )
+            cache_directory = argv[++i];
+        else if ( !strcmp( argv[i], "--no-write" ) )
+            output_directory.clear();
+        else if ( !strcmp( argv[i], "--worker" ) )
+            worker = true;
+        else if ( argv[i][0] == '-' )
+        {
+            usage();
+            return 2;
+        }
+        else if ( library_path.empty() )
+            library_path = argv[i];
+        else if ( sweep_path.empty() )
+            sweep_path = argv[i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if ( library_path.empty() || sweep_path.empty() )
+    {
+        usage();
+        return 2;
+    }
+
+#ifndef HAPI_ENABLE_TRACING
+    if ( !trace_path.empty() )
+    {
+        fprintf( stderr, "-t: built without HAPI_ENABLE_TRACING\n" );
+        return 2;
+    }
+#endif
+    if ( !trace_path.empty() && process_count >= 0 )
+    {
+        fprintf( stderr, "-t cannot be combined with -p\n" );
+        return 2;
+    }
+
+    SweepFile sweep;
+    if ( !sweep.load( sweep_path ) )
+    {
+        fprintf( stderr, "%s: %s\n", sweep_path.c_str(), sweep.error().c_str() );
+        return 2;
+    }
+
+    std::unique_ptr<CookCache> cook_cache;
+    if ( !cache_directory.empty() )
+    {
+        if ( !QDir().mkpath( QString::fromLocal8Bit( cache_directory.c_str() ) ) )
+        {
+            fprintf( stderr, "cannot create %s\n", cache_directory.c_str() );
+            return 2;
+        }
+        cook_cache.reset( new CookCache( cache_directory ) );
+    }
+
+    if ( worker )
+        return RunWorker( sweep, library_path, asset_name, output_directory, cook_cache.get(),
+                          worker_count );
+
+    if ( process_count >= 0 )
+    {
+        int threads = QThread::idealThreadCount() > 0 ? QThread::idealThreadCount() : 1;
+        if ( process_count == 0 )
+            process_count = threads;
+        // Don't let every process start an exporter thread per core.
+        if ( worker_count <= 0 )
+            worker_count = threads / process_count > 0 ? threads / process_count : 1;
+
+        QStringList arguments;
+        arguments << "--worker" << "-j" << QString::number( worker_count );
+        if ( !asset_name.empty() )
+            arguments << "-a" << QString::fromLocal8Bit( asset_name.c_str() );
+        if ( !cache_directory.empty() )
+            arguments << "-c" << QString::fromLocal8Bit( cache_directory.c_str() );
+        if ( output_directory.empty() )
+            arguments << "--no-write";
+        else
+            arguments << "-o" << QString::fromLocal8Bit( output_directory.c_str() );
+        arguments << QString::fromLocal8Bit( library_path.c_str() )
+                  << QString::fromLocal8Bit( sweep_path.c_str() );
+        return RunFarm( argc, argv, sweep, process_count, job_timeout, arguments );
+    }
+
+    // No cooking thread: each cook blocks until done.
+    Engine* hapi = Engine::getInstance();
+    if ( !hapi->initialize( nullptr, nullptr, false ) )
+    {
+        fprintf( stderr, "cannot initialize Houdini Engine: %s\n", hapi->getLastError().c_str() );
+        return 1;
+    }
+    hapi->setLoadMode( Engine::LOAD_FROM_MEMORY );
+
+    int failures = 0;
+    {
+        BatchCooker cooker( worker_count );
+        cooker.setOutputDirectory( output_directory );
+        cooker.setCookCache( cook_cache.get() );
+        if ( !cooker.open( library_path, asset_name ) )
+        {
+            fprintf( stderr, "%s\n", cooker.error().c_str() );
+            hapi->cleanup();
+            return 1;
+        }
+
+        const std::vector<SweepVariation>& variations = sweep.variations();
+        VariationStats total;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        PrintHeader();
+        for ( size_t i = 0; i < variations.size(); ++i )
+        {
+            VariationStats stats = cooker.cook( variations[i] );
+            if ( !stats.ok )
+                ++failures;
+            PrintRow( stats, total );
+        }
+
+        double elapsed = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start ).count();
+        PrintSummary( int( variations.size() ) - failures, int( variations.size() ), elapsed, total );
+        if ( cook_cache )
+            printf( "%d variations from the cook cache\n", cooker.cookCacheHits() );
+    }
+
+    hapi->cleanup();
+
+#ifdef HAPI_ENABLE_TRACING
+    fprintf( stderr, "\n%s", Trace::summary().c_str() );
+    if ( !trace_path.empty() && !Trace::writeChromeTrace( trace_path ) )
+        fprintf( stderr, "cannot write %s\n", trace_path.c_str() );
+#endif
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,341 @@
+#include "parametersview.h"
+#include "geoexport.h"
+#include "infocache.h"
+#include "stringcache.h"
+#include "hapistub.h"
+#include <QApplication>
+#include <QDir>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QTemporaryFile>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+
+using namespace hapi;
+
+// Every benchmark runs at least MIN_ITERATIONS times and then until
+// MIN_SECONDS of measured time or MAX_ITERATIONS are reached.
+#define MIN_ITERATIONS  (3)
+#define MAX_ITERATIONS  (1000)
+#define MIN_SECONDS     (0.25)
+
+#define STUB_ASSET_NAME "Stub::synthetic"
+
+struct Measurement
+{
+    int         iterations;
+    double      mean_us;
+    double      min_us;
+    // HAPI calls and bytes produced per iteration.
+    double      calls;
+    double      bytes;
+};
+
+static std::string sFilter;
+static std::string sLibraryPath;
+
+static bool Selected( const char* name )
+{
+    return sFilter.empty() || strstr( name, sFilter.c_str() ) != nullptr;
+}
+
+// Only body is timed; prepare runs before every iteration and restores the
+// state body expects. body returns the number of bytes it produced.
+static Measurement Measure( const std::function<void()>& prepare,
+                            const std::function<size_t()>& body )
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Measurement result;
+    memset( &result, 0, sizeof(result) );
+    result.min_us = 1e30;
+
+    double total_us = 0.0;
+    long long calls = 0;
+    double bytes = 0.0;
+    while ( result.iterations < MIN_ITERATIONS ||
+            ( total_us < MIN_SECONDS * 1e6 && result.iterations < MAX_ITERATIONS ) )
+    {
+        if ( prepare )
+            prepare();
+
+        long long calls_before = HAPI_Stub_CallCount();
+        Clock::time_point start = Clock::now();
+        bytes += double( body() );
+        double us = std::chrono::duration<double, std::micro>( Clock::now() - start ).count();
+        calls += HAPI_Stub_CallCount() - calls_before;
+
+        total_us += us;
+        if ( us < result.min_us )
+            result.min_us = us;
+        ++result.iterations;
+    }
+
+    result.mean_us = total_us / result.iterations;
+    result.calls = double( calls ) / result.iterations;
+    result.bytes = bytes / result.iterations;
+    return result;
+}
+
+// One JSON object per line.
+static void Report( const char* name, const HAPI_StubConfig& config, const Measurement& m )
+{
+    printf( "{\"benchmark\":\"%s\",\"parms\":%d,\"folder_depth\":%d,\"objects\":%d,\"parts\":%d,"
+            "\"points\":%d,\"call_latency_us\":%d,\"iterations\":%d,\"mean_us\":%.2f,"
+            "\"min_us\":%.2f,\"hapi_calls\":%.1f,\"mb_per_s\":%.2f}\n",
+            name, config.parm_count, config.folder_depth, config.object_count, config.part_count,
+            config.point_count, config.call_latency_us, m.iterations, m.mean_us, m.min_us,
+            m.calls, m.mean_us > 0.0 ? m.bytes / m.mean_us : 0.0 );
+    fflush( stdout );
+}
+
+// Instantiates a synthetic asset shaped by config. Returns -1 on failure.
+static int Instantiate( const HAPI_StubConfig& config )
+{
+    HAPI_Stub_SetConfig( &config );
+
+    Engine* hapi = Engine::getInstance();
+    if ( hapi->loadAssetLibrary( sLibraryPath.c_str() ) < 0 )
+        return -1;
+    return hapi->instantiateAsset( STUB_ASSET_NAME, true );
+}
+
+static void BenchParms( const HAPI_StubConfig& config )
+{
+    int asset_id = Instantiate( config );
+    if ( asset_id < 0 )
+    {
+        fprintf( stderr, "cannot instantiate: %s\n", Engine::getInstance()->getLastError().c_str() );
+        return;
+    }
+    Asset asset( asset_id );
+
+    if ( Selected( "parms_cold" ) )
+    {
+        Report( "parms_cold", config, Measure(
+                    []() {
+                        StringCache::getInstance()->clear();
+                        InfoCache::getInstance()->clear();
+                    },
+                    [&]() { return asset.parms().size(); } ) );
+    }
+    if ( Selected( "parms_warm" ) )
+    {
+        Report( "parms_warm", config, Measure(
+                    nullptr, [&]() { return asset.parms().size(); } ) );
+    }
+
+    ParametersView view;
+    view.resize( 400, 800 );
+
+    if ( Selected( "view_widgets" ) )
+    {
+        view.setVirtualized( false );
+        Report( "view_widgets", config, Measure(
+                    [&]() { view.clear(); },
+                    [&]() { view.setAsset( asset_id ); return size_t( 0 ); } ) );
+    }
+    if ( Selected( "view_virtualized" ) )
+    {
+        view.setVirtualized( true );
+        Report( "view_virtualized", config, Measure(
+                    [&]() { view.clear(); },
+                    [&]() { view.setAsset( asset_id ); return size_t( 0 ); } ) );
+    }
+
+    if ( Selected( "widget_sync_unchanged" ) || Selected( "widget_sync_edited" ) )
+    {
+        view.setVirtualized( false );
+        view.setAsset( asset_id );
+        QList<ParameterValue*> values = view.findChildren<ParameterValue*>();
+        QList<QSpinBox*> int_editors = view.findChildren<QSpinBox*>();
+        QList<QDoubleSpinBox*> float_editors = view.findChildren<QDoubleSpinBox*>();
+
+        std::function<size_t()> sync_all = [&]() {
+            for ( int i = 0; i < values.size(); ++i )
+                values[i]->sync();
+            return size_t( 0 );
+        };
+
+        // Nothing changed: every editor is diffed against its parm.
+        if ( Selected( "widget_sync_unchanged" ) )
+            Report( "widget_sync_unchanged", config, Measure( nullptr, sync_all ) );
+
+        // Every spin box changed: each edit becomes one transaction.
+        if ( Selected( "widget_sync_edited" ) )
+        {
+            int step = 0;
+            Report( "widget_sync_edited", config, Measure(
+                        [&]() {
+                            step = step ? -1 : 1;
+                            for ( int i = 0; i < int_editors.size(); ++i )
+                            {
+                                int_editors[i]->blockSignals( true );
+                                int_editors[i]->setValue( int_editors[i]->value() + step );
+                                int_editors[i]->blockSignals( false );
+                            }
+                            for ( int i = 0; i < float_editors.size(); ++i )
+                            {
+                                float_editors[i]->blockSignals( true );
+                                float_editors[i]->setValue( float_editors[i]->value() + step );
+                                float_editors[i]->blockSignals( false );
+                            }
+                        },
+                        sync_all ) );
+        }
+    }
+
+    view.clear();
+    asset.destroyAsset();
+}
+
+static void BenchGeometry( const HAPI_StubConfig& config )
+{
+    int asset_id = Instantiate( config );
+    if ( asset_id < 0 )
+    {
+        fprintf( stderr, "cannot instantiate: %s\n", Engine::getInstance()->getLastError().c_str() );
+        return;
+    }
+    Asset asset( asset_id );
+
+    if ( Selected( "attrib_extract" ) )
+    {
+        AttribBufferPool pool;
+        static const char* const names[] = { "P", "N", "uv" };
+        Report( "attrib_extract", config, Measure( nullptr, [&]() {
+            size_t bytes = 0;
+            std::vector<Object> objects = asset.objects();
+            for ( size_t o = 0; o < objects.size(); ++o )
+            {
+                std::vector<Geo> geos = objects[o].geos();
+                for ( size_t g = 0; g < geos.size(); ++g )
+                {
+                    std::vector<Part> parts = geos[g].parts();
+                    for ( size_t p = 0; p < parts.size(); ++p )
+                    {
+                        for ( int a = 0; a < 3; ++a )
+                        {
+                            AttribBuffer<float> data = pool.floatData(
+                                        parts[p], HAPI_ATTROWNER_POINT, names[a] );
+                            bytes += data.size() * sizeof(float);
+                        }
+                    }
+                }
+            }
+            return bytes;
+        } ) );
+    }
+
+    if ( Selected( "export_asset" ) )
+    {
+        GeometryExporter exporter;
+        Report( "export_asset", config, Measure( nullptr, [&]() {
+            size_t bytes = 0;
+            std::vector< std::shared_ptr<ExportedMesh> > meshes = exporter.exportAsset( asset );
+            for ( size_t i = 0; i < meshes.size(); ++i )
+                bytes += meshes[i]->byteSize();
+            return bytes;
+        } ) );
+    }
+
+    asset.destroyAsset();
+}
+
+static void usage()
+{
+    fprintf( stderr,
+             "usage: HoudiniEngineBench [--latency us] [--filter name]\n"
+             "\n"
+             "Runs against the stub engine and prints one JSON object per benchmark.\n"
+             "\n"
+             "  --latency us   simulated cost of every HAPI call (default: 0)\n"
+             "  --filter name  only run benchmarks whose name contains name\n" );
+}
+
+int main(int argc, char *argv[])
+{
+    int latency = 0;
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( !strcmp( argv[i], "--latency" ) && i + 1 < argc )
+            latency = atoi( argv[++i] );
+        else if ( !strcmp( argv[i], "--filter" ) && i + 1 < argc )
+            sFilter = argv[++i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+#if QT_VERSION >= 0x050000
+    // The views are never shown; don't require a display.
+    if ( qgetenv( "QT_QPA_PLATFORM" ).isEmpty() )
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+#endif
+    QApplication app( argc, argv );
+
+    // The stub ignores library contents but, like HAPI, wants the file.
+    QTemporaryFile library( QDir::tempPath() + "/HoudiniEngineBenchXXXXXX.hda" );
+    if ( !library.open() )
+    {
+        fprintf( stderr, "cannot create %s\n", qPrintable( library.fileTemplate() ) );
+        return 1;
+    }
+    sLibraryPath = library.fileName().toStdString();
+
+    Engine* hapi = Engine::getInstance();
+    if ( !hapi->initialize( nullptr, nullptr, false ) )
+    {
+        fprintf( stderr, "cannot initialize Houdini Engine: %s\n", hapi->getLastError().c_str() );
+        return 1;
+    }
+
+    HAPI_StubConfig config;
+    HAPI_Stub_GetConfig( &config );
+    config.object_count = 1;
+    config.call_latency_us = latency;
+    config.cook_latency_us = 0;
+
+    // Parm count and folder depth, on little geometry.
+    static const int parm_counts[] = { 10, 100, 1000, 5000 };
+    static const int folder_depths[] = { 0, 2, 4 };
+    for ( int d = 0; d < 3; ++d )
+    {
+        for ( int p = 0; p < 4; ++p )
+        {
+            config.parm_count = parm_counts[p];
+            config.folder_depth = folder_depths[d];
+            config.part_count = 1;
+            config.point_count = 100;
+            BenchParms( config );
+        }
+    }
+
+    // Geometry size, with few parms. Exported meshes are unwelded, so the
+    // largest sizes are only run as a single part.
+    static const int point_counts[] = { 1000, 10000, 100000, 1000000 };
+    static const int part_counts[] = { 1, 8 };
+    for ( int c = 0; c < 2; ++c )
+    {
+        for ( int p = 0; p < 4; ++p )
+        {
+            if ( point_counts[p] * part_counts[c] > 1000000 )
+                continue;
+
+            config.parm_count = 10;
+            config.folder_depth = 0;
+            config.part_count = part_counts[c];
+            config.point_count = point_counts[p];
+            BenchGeometry( config );
+        }
+    }
+
+    hapi->cleanup();
+    return 0;
+}
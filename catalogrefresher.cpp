@@ -0,0 +1,37 @@
+#include "catalogrefresher.h"
+#include "assetcatalog.h"
+#include "HAPI_cpp.h"
+
+namespace hapi {
+
+CatalogRefresher::CatalogRefresher( AssetCatalog* catalog, QObject *parent ) :
+    QThread(parent), mCatalog(catalog), mCanceled(0)
+{
+}
+
+void CatalogRefresher::cancel()
+{
+    if ( mCanceled.fetchAndStoreOrdered(1) == 0 && isRunning() )
+        HAPI_TRACE( HAPI_Interrupt() );
+}
+
+bool CatalogRefresher::isCanceled() const
+{
+    return mCanceled.fetchAndAddOrdered(0) != 0;
+}
+
+void CatalogRefresher::run()
+{
+    emit progress( tr("Scanning libraries"), 0, 0 );
+    int listed = mCatalog->refresh( [this]( int done, int total ) {
+        emit progress( tr("Listing assets"), done, total );
+        return !isCanceled();
+    } );
+
+    if ( listed < 0 || isCanceled() )
+        emit canceled();
+    else
+        emit refreshed( listed );
+}
+
+};
@@ -0,0 +1,47 @@
+#ifndef CATALOGREFRESHER_H
+#define CATALOGREFRESHER_H
+
+#include <QThread>
+#include <QString>
+#include <QAtomicInt>
+
+namespace hapi {
+
+class AssetCatalog;
+
+//
+// Runs AssetCatalog::refresh() off the GUI thread, the same way AssetLoader
+// opens an asset: libraries that changed are loaded into the engine to list
+// their assets, with a progress() stage per library. The catalog must not be
+// touched, and no other HAPI calls made, until finished() is emitted.
+//
+class CatalogRefresher : public QThread
+{
+    Q_OBJECT
+public:
+    // The catalog must outlive the refresher.
+    explicit CatalogRefresher( AssetCatalog* catalog, QObject *parent = 0 );
+
+    // Stops before the next library is listed; the index keeps its state
+    // from before the refresh.
+    void    cancel();
+    bool    isCanceled() const;
+
+signals:
+    // maximum is 0 when the stage cannot report how far along it is.
+    void    progress( const QString& stage, int value, int maximum );
+    // listed is the number of libraries that had to be loaded.
+    void    refreshed( int listed );
+    void    canceled();
+
+protected:
+    virtual void run();
+
+private:
+    AssetCatalog*   mCatalog;
+    QAtomicInt      mCanceled;
+};
+
+};
+
+#endif // CATALOGREFRESHER_H
@@ -0,0 +1,323 @@
+#include "cookcache.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace hapi {
+
+#define CACHE_VERSION       (1)
+// Blocks are aligned to this in the file; mappings start on a page boundary,
+// so the data is page aligned in memory as well.
+#define CACHE_ALIGNMENT     (4096)
+
+#define FNV_OFFSET_BASIS    (14695981039346656037ULL)
+#define FNV_PRIME           (1099511628211ULL)
+
+static const char CACHE_MAGIC[8] = { 'H', 'E', 'Q', 'C', 'O', 'O', 'K', 0 };
+
+// Numbers the temporary files of this process.
+static std::atomic<unsigned> sTempCounter( 0 );
+
+enum
+{
+    MESH_HAS_NORMALS    = 1 << 0,
+    MESH_HAS_UVS        = 1 << 1
+};
+
+struct FileHeader
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    record_size;
+    uint64_t    key;
+    uint64_t    mesh_count;
+    uint64_t    table_offset;
+    uint64_t    file_size;
+};
+
+struct MeshRecord
+{
+    int32_t     object_id;
+    int32_t     geo_id;
+    int32_t     part_id;
+    uint32_t    flags;
+    int32_t     stride;
+    uint32_t    name_length;
+    uint64_t    name_offset;
+    float       transform[16];
+    float       bounds_min[3];
+    float       bounds_max[3];
+    uint64_t    vertex_offset;
+    uint64_t    vertex_count;
+    uint64_t    index_offset;
+    uint64_t    index_count;
+};
+
+static uint64_t Fnv1a( const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS )
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+    for ( size_t i = 0; i < size; ++i )
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t AlignUp( uint64_t offset )
+{
+    return ( offset + CACHE_ALIGNMENT - 1 ) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+}
+
+static bool InFile( uint64_t offset, uint64_t count, size_t element, uint64_t file_size )
+{
+    return offset <= file_size && count <= ( file_size - offset ) / element;
+}
+
+// Pad the stream with zeros up to offset.
+static void PadTo( std::ofstream& out, uint64_t& position, uint64_t offset )
+{
+    static const char zeros[CACHE_ALIGNMENT] = { 0 };
+    while ( position < offset )
+    {
+        uint64_t count = std::min<uint64_t>( offset - position, CACHE_ALIGNMENT );
+        out.write( zeros, std::streamsize( count ) );
+        position += count;
+    }
+}
+
+std::shared_ptr<ExportedMesh> CachedMesh::toExportedMesh( int asset_id ) const
+{
+    std::shared_ptr<ExportedMesh> mesh( new ExportedMesh );
+    mesh->asset_id = asset_id;
+    mesh->object_id = object_id;
+    mesh->geo_id = geo_id;
+    mesh->part_id = part_id;
+    mesh->name = name;
+    memcpy( mesh->transform, transform, sizeof(mesh->transform) );
+    mesh->has_normals = has_normals;
+    mesh->has_uvs = has_uvs;
+    mesh->stride = stride;
+    mesh->vertices.assign( vertices, vertices + vertex_float_count );
+    mesh->indices.assign( indices, indices + index_count );
+    memcpy( mesh->bounds_min, bounds_min, sizeof(mesh->bounds_min) );
+    memcpy( mesh->bounds_max, bounds_max, sizeof(mesh->bounds_max) );
+    return mesh;
+}
+
+CookCache::CookCache( const std::string& directory ) :
+    mDirectory(directory)
+{
+}
+
+uint64_t CookCache::hashFile( const std::string& path )
+{
+    MappedFile file;
+    if ( !file.open( path ) )
+        return 0;
+    return hashData( file.data(), file.size() );
+}
+
+uint64_t CookCache::hashData( const void* data, size_t size )
+{
+    return Fnv1a( data, size );
+}
+
+uint64_t CookCache::makeKey( uint64_t library_hash, const std::string& asset_name,
+                             const ParmValueStore& values )
+{
+    uint32_t version = CACHE_VERSION;
+    uint64_t hash = Fnv1a( &version, sizeof(version) );
+    hash = Fnv1a( &library_hash, sizeof(library_hash), hash );
+    hash = Fnv1a( asset_name.c_str(), asset_name.size() + 1, hash );
+    return values.hash( hash );
+}
+
+std::string CookCache::pathFor( uint64_t key ) const
+{
+    char name[32];
+    snprintf( name, sizeof(name), "%016llx.cook", (unsigned long long)key );
+    return mDirectory + "/" + name;
+}
+
+std::shared_ptr<const CachedCook> CookCache::find( uint64_t key ) const
+{
+    std::shared_ptr<CachedCook> cook( new CachedCook );
+    if ( !cook->mFile.open( pathFor( key ) ) )
+        return std::shared_ptr<const CachedCook>();
+
+    const char* base = cook->mFile.data();
+    uint64_t size = cook->mFile.size();
+
+    if ( size < sizeof(FileHeader) )
+        return std::shared_ptr<const CachedCook>();
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>( base );
+    if ( memcmp( header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC) ) != 0 ||
+         header->version != CACHE_VERSION ||
+         header->record_size != sizeof(MeshRecord) ||
+         header->key != key ||
+         header->file_size != size ||
+         header->table_offset % alignof(MeshRecord) != 0 ||
+         !InFile( header->table_offset, header->mesh_count, sizeof(MeshRecord), size ) )
+        return std::shared_ptr<const CachedCook>();
+
+    const MeshRecord* records = reinterpret_cast<const MeshRecord*>( base + header->table_offset );
+
+    cook->mKey = key;
+    cook->mMeshes.resize( size_t( header->mesh_count ) );
+    for ( size_t i = 0; i < cook->mMeshes.size(); ++i )
+    {
+        const MeshRecord& record = records[i];
+        if ( !InFile( record.name_offset, record.name_length, 1, size ) ||
+             !InFile( record.vertex_offset, record.vertex_count, sizeof(float), size ) ||
+             !InFile( record.index_offset, record.index_count, sizeof(int), size ) ||
+             record.vertex_offset % CACHE_ALIGNMENT != 0 ||
+             record.index_offset % CACHE_ALIGNMENT != 0 )
+            return std::shared_ptr<const CachedCook>();
+
+        CachedMesh& mesh = cook->mMeshes[i];
+        mesh.object_id = record.object_id;
+        mesh.geo_id = record.geo_id;
+        mesh.part_id = record.part_id;
+        mesh.name.assign( base + record.name_offset, record.name_length );
+        mesh.transform = record.transform;
+        mesh.has_normals = ( record.flags & MESH_HAS_NORMALS ) != 0;
+        mesh.has_uvs = ( record.flags & MESH_HAS_UVS ) != 0;
+        mesh.stride = record.stride;
+        mesh.vertices = reinterpret_cast<const float*>( base + record.vertex_offset );
+        mesh.vertex_float_count = size_t( record.vertex_count );
+        mesh.indices = reinterpret_cast<const int*>( base + record.index_offset );
+        mesh.index_count = size_t( record.index_count );
+        mesh.bounds_min = record.bounds_min;
+        mesh.bounds_max = record.bounds_max;
+    }
+
+    return cook;
+}
+
+bool CookCache::store( uint64_t key, const std::vector< std::shared_ptr<ExportedMesh> >& meshes )
+{
+    // Lay everything out first: header page, mesh table, names, then one
+    // aligned block per vertex and index buffer.
+    FileHeader header;
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC) );
+    header.version = CACHE_VERSION;
+    header.record_size = sizeof(MeshRecord);
+    header.key = key;
+    header.mesh_count = meshes.size();
+    header.table_offset = CACHE_ALIGNMENT;
+
+    std::vector<MeshRecord> records( meshes.size() );
+    uint64_t offset = header.table_offset + records.size() * sizeof(MeshRecord);
+    for ( size_t i = 0; i < meshes.size(); ++i )
+    {
+        const ExportedMesh& mesh = *meshes[i];
+        MeshRecord& record = records[i];
+        memset( &record, 0, sizeof(record) );
+        record.object_id = mesh.object_id;
+        record.geo_id = mesh.geo_id;
+        record.part_id = mesh.part_id;
+        record.flags = ( mesh.has_normals ? MESH_HAS_NORMALS : 0 ) |
+                       ( mesh.has_uvs ? MESH_HAS_UVS : 0 );
+        record.stride = mesh.stride;
+        record.name_length = uint32_t( mesh.name.size() );
+        record.name_offset = offset;
+        memcpy( record.transform, mesh.transform, sizeof(record.transform) );
+        memcpy( record.bounds_min, mesh.bounds_min, sizeof(record.bounds_min) );
+        memcpy( record.bounds_max, mesh.bounds_max, sizeof(record.bounds_max) );
+        offset += mesh.name.size();
+    }
+    for ( size_t i = 0; i < meshes.size(); ++i )
+    {
+        offset = AlignUp( offset );
+        records[i].vertex_offset = offset;
+        records[i].vertex_count = meshes[i]->vertices.size();
+        offset = AlignUp( offset + meshes[i]->vertices.size() * sizeof(float) );
+        records[i].index_offset = offset;
+        records[i].index_count = meshes[i]->indices.size();
+        offset += meshes[i]->indices.size() * sizeof(int);
+    }
+    header.file_size = offset;
+
+    // Processes sharing the directory, e.g. cook farm workers, may store
+    // the same key at once; each writes its own temporary file.
+    std::string path = pathFor( key );
+    char suffix[64];
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = int( getpid() );
+#endif
+    snprintf( suffix, sizeof(suffix), ".%d.%u.tmp", pid, sTempCounter++ );
+    std::string temp_path = path + suffix;
+    {
+        std::ofstream out( temp_path.c_str(), std::ios::binary | std::ios::trunc );
+        if ( !out )
+            return false;
+
+        uint64_t position = 0;
+        out.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+        position += sizeof(header);
+
+        PadTo( out, position, header.table_offset );
+        if ( !records.empty() )
+        {
+            out.write( reinterpret_cast<const char*>( &records[0] ),
+                       std::streamsize( records.size() * sizeof(MeshRecord) ) );
+            position += records.size() * sizeof(MeshRecord);
+        }
+        for ( size_t i = 0; i < meshes.size(); ++i )
+        {
+            out.write( meshes[i]->name.c_str(), std::streamsize( meshes[i]->name.size() ) );
+            position += meshes[i]->name.size();
+        }
+        for ( size_t i = 0; i < meshes.size(); ++i )
+        {
+            const ExportedMesh& mesh = *meshes[i];
+
+            PadTo( out, position, records[i].vertex_offset );
+            if ( !mesh.vertices.empty() )
+                out.write( reinterpret_cast<const char*>( &mesh.vertices[0] ),
+                           std::streamsize( mesh.vertices.size() * sizeof(float) ) );
+            position += mesh.vertices.size() * sizeof(float);
+
+            PadTo( out, position, records[i].index_offset );
+            if ( !mesh.indices.empty() )
+                out.write( reinterpret_cast<const char*>( &mesh.indices[0] ),
+                           std::streamsize( mesh.indices.size() * sizeof(int) ) );
+            position += mesh.indices.size() * sizeof(int);
+        }
+
+        if ( !out )
+        {
+            out.close();
+            std::remove( temp_path.c_str() );
+            return false;
+        }
+    }
+
+    // rename() does not replace an existing file on Windows.
+    std::remove( path.c_str() );
+    if ( std::rename( temp_path.c_str(), path.c_str() ) != 0 )
+    {
+        std::remove( temp_path.c_str() );
+        return false;
+    }
+    return true;
+}
+
+void CookCache::remove( uint64_t key )
+{
+    std::remove( pathFor( key ).c_str() );
+}
+
+};
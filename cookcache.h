@@ -0,0 +1,95 @@
+#ifndef COOKCACHE_H
+#define COOKCACHE_H
+
+#include "HAPI_cpp.h"
+#include "geoexport.h"
+#include "mappedfile.h"
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Persistent cook cache:
+
+// A mesh served straight from a mapped cache file. The pointers stay valid
+// as long as the CachedCook it came from.
+struct CachedMesh
+{
+    int             object_id;
+    int             geo_id;
+    int             part_id;
+    std::string     name;
+
+    const float*    transform;
+    bool            has_normals;
+    bool            has_uvs;
+    int             stride;
+    const float*    vertices;
+    size_t          vertex_float_count;
+    const int*      indices;
+    size_t          index_count;
+    const float*    bounds_min;
+    const float*    bounds_max;
+
+    // Copy into an ExportedMesh for consumers that want to own the data.
+    std::shared_ptr<ExportedMesh> toExportedMesh( int asset_id ) const;
+};
+
+// The extracted output of one cook, mapped back from disk.
+class CachedCook
+{
+public:
+    uint64_t        key() const { return mKey; }
+    int             meshCount() const { return int( mMeshes.size() ); }
+    const CachedMesh& mesh( int index ) const { return mMeshes[ index ]; }
+    const std::vector<CachedMesh>& meshes() const { return mMeshes; }
+
+private:
+    friend class CookCache;
+    CachedCook() : mKey( 0 ) {}
+
+    MappedFile              mFile;
+    uint64_t                mKey;
+    std::vector<CachedMesh> mMeshes;
+};
+
+// On-disk cache of cook output keyed by a hash of the asset library bytes,
+// the asset name and every parm value. One file per key holds a header page,
+// a mesh table and page-aligned vertex and index blocks, so a hit is just
+// an mmap: nothing is parsed or copied.
+//
+// Files are written in native byte order to a temporary name and renamed
+// into place, so a crashed writer never leaves a half-written entry behind.
+// The directory must exist.
+class CookCache
+{
+public:
+    explicit CookCache( const std::string& directory );
+
+    const std::string& directory() const { return mDirectory; }
+
+    // FNV-1a over the whole file; 0 when it cannot be read.
+    static uint64_t hashFile( const std::string& path );
+    // Same hash over bytes already in memory.
+    static uint64_t hashData( const void* data, size_t size );
+    static uint64_t makeKey( uint64_t library_hash, const std::string& asset_name,
+                             const ParmValueStore& values );
+
+    std::shared_ptr<const CachedCook> find( uint64_t key ) const;
+    bool            store( uint64_t key,
+                           const std::vector< std::shared_ptr<ExportedMesh> >& meshes );
+    void            remove( uint64_t key );
+
+    std::string     pathFor( uint64_t key ) const;
+
+private:
+    std::string     mDirectory;
+};
+
+}
+
+#endif // COOKCACHE_H
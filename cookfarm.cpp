@@ -0,0 +1,343 @@
+#include "cookfarm.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Tries per variation; a variation that kills this many workers fails.
+#define MAX_ATTEMPTS        (2)
+// How long a worker gets to exit after its input is closed.
+#define STOP_TIMEOUT_MS     (5000)
+#define DEFAULT_JOB_TIMEOUT_MS  (10 * 60 * 1000)
+
+namespace hapi {
+
+CookFarm::CookFarm( const QString& program, const QStringList& arguments, int process_count,
+                    QObject *parent ) :
+    QObject(parent),
+    mProgram(program),
+    mArguments(arguments),
+    mRemaining(0),
+    mJobTimeout(DEFAULT_JOB_TIMEOUT_MS),
+    mStarts(0),
+    mCrashes(0),
+    mAborted(false)
+{
+    Worker worker;
+    worker.process = nullptr;
+    worker.timer = nullptr;
+    worker.ready = false;
+    worker.job = -1;
+    mWorkers.assign( process_count > 0 ? process_count : 1, worker );
+
+    for ( size_t i = 0; i < mWorkers.size(); ++i )
+    {
+        mWorkers[i].timer = new QTimer( this );
+        mWorkers[i].timer->setSingleShot( true );
+        connect( mWorkers[i].timer, SIGNAL(timeout()), this, SLOT(jobTimedOut()) );
+    }
+}
+
+CookFarm::~CookFarm()
+{
+    for ( size_t i = 0; i < mWorkers.size(); ++i )
+        stop( mWorkers[i] );
+}
+
+bool CookFarm::run( int job_count, const Callback& done )
+{
+    mDone = done;
+    mRemaining = job_count;
+    mStarts = 0;
+    mCrashes = 0;
+    mAborted = false;
+    mError.clear();
+    mAttempts.assign( job_count, 0 );
+    mQueue.clear();
+    for ( int i = 0; i < job_count; ++i )
+        mQueue.push_back( i );
+
+    if ( job_count > 0 )
+    {
+        for ( size_t i = 0; i < mWorkers.size(); ++i )
+            start( mWorkers[i] );
+        mLoop.exec();
+    }
+
+    for ( size_t i = 0; i < mWorkers.size(); ++i )
+        stop( mWorkers[i] );
+    mDone = Callback();
+    return !mAborted;
+}
+
+void CookFarm::start( Worker& worker )
+{
+    ++mStarts;
+    worker.ready = false;
+    worker.job = -1;
+    worker.process = new QProcess( this );
+
+    connect( worker.process, SIGNAL(readyReadStandardOutput()), this, SLOT(readOutput()) );
+    connect( worker.process, SIGNAL(readyReadStandardError()), this, SLOT(readError()) );
+    connect( worker.process, SIGNAL(finished(int,QProcess::ExitStatus)),
+             this, SLOT(processFinished(int,QProcess::ExitStatus)) );
+    connect( worker.process, SIGNAL(error(QProcess::ProcessError)),
+             this, SLOT(processError(QProcess::ProcessError)) );
+
+    worker.process->start( mProgram, mArguments );
+}
+
+void CookFarm::stop( Worker& worker )
+{
+    if ( !worker.process )
+        return;
+
+    QProcess* process = worker.process;
+    worker.process = nullptr;
+    worker.ready = false;
+    worker.timer->stop();
+
+    disconnect( process, 0, this, 0 );
+    if ( process->state() != QProcess::NotRunning )
+    {
+        process->closeWriteChannel();
+        if ( !process->waitForFinished( STOP_TIMEOUT_MS ) )
+        {
+            process->kill();
+            process->waitForFinished();
+        }
+    }
+    delete process;
+}
+
+CookFarm::Worker* CookFarm::workerFor( QObject* process )
+{
+    for ( size_t i = 0; i < mWorkers.size(); ++i )
+        if ( mWorkers[i].process && mWorkers[i].process == process )
+            return &mWorkers[i];
+    return nullptr;
+}
+
+CookFarm::Worker* CookFarm::workerForTimer( QObject* timer )
+{
+    for ( size_t i = 0; i < mWorkers.size(); ++i )
+        if ( mWorkers[i].timer == timer )
+            return &mWorkers[i];
+    return nullptr;
+}
+
+void CookFarm::dispatch( Worker& worker )
+{
+    if ( mAborted || !worker.ready || worker.job >= 0 || mQueue.empty() )
+        return;
+
+    worker.job = mQueue.front();
+    mQueue.pop_front();
+
+    QByteArray line = QByteArray::number( worker.job ) + '\n';
+    worker.process->write( line );
+    if ( mJobTimeout > 0 )
+        worker.timer->start( mJobTimeout );
+}
+
+void CookFarm::readOutput()
+{
+    Worker* worker = workerFor( sender() );
+    while ( worker && worker->process && worker->process->canReadLine() )
+    {
+        QByteArray line = worker->process->readLine().trimmed();
+        handleLine( *worker, std::string( line.constData(), line.size() ) );
+    }
+}
+
+// Worker diagnostics go straight to our stderr.
+void CookFarm::readError()
+{
+    QProcess* process = qobject_cast<QProcess*>( sender() );
+    if ( !process )
+        return;
+
+    QByteArray text = process->readAllStandardError();
+    fwrite( text.constData(), 1, text.size(), stderr );
+}
+
+void CookFarm::handleLine( Worker& worker, const std::string& line )
+{
+    if ( line == "ready" )
+    {
+        worker.ready = true;
+        dispatch( worker );
+        return;
+    }
+    if ( line.compare( 0, 6, "error\t" ) == 0 )
+    {
+        abort( line.substr( 6 ) );
+        return;
+    }
+
+    // Anything else a library printed is not ours.
+    int index;
+    VariationStats stats;
+    if ( !decodeResult( line, index, stats ) || index != worker.job )
+        return;
+
+    worker.job = -1;
+    worker.timer->stop();
+    complete( index, stats );
+    dispatch( worker );
+}
+
+void CookFarm::processError( QProcess::ProcessError error )
+{
+    if ( error != QProcess::FailedToStart || !workerFor( sender() ) )
+        return;
+
+    QProcess* process = qobject_cast<QProcess*>( sender() );
+    abort( "cannot start " + mProgram.toStdString() + ": " + process->errorString().toStdString() );
+}
+
+// The worker is stuck in the cook, or its result never came through in a
+// form we could read; either way it is not coming back.
+void CookFarm::jobTimedOut()
+{
+    Worker* worker = workerForTimer( sender() );
+    if ( !worker || !worker->process || worker->job < 0 || mAborted )
+        return;
+
+    disconnect( worker->process, 0, this, 0 );
+    worker->process->kill();
+    worker->process->waitForFinished();
+
+    char reason[64];
+    snprintf( reason, sizeof(reason), "worker timed out after %d s", mJobTimeout / 1000 );
+    lost( *worker, reason );
+}
+
+void CookFarm::processFinished( int exit_code, QProcess::ExitStatus exit_status )
+{
+    Worker* worker = workerFor( sender() );
+    if ( !worker )
+        return;
+
+    // A worker that could not open the asset says why before it exits.
+    while ( worker->process->canReadLine() )
+    {
+        QByteArray line = worker->process->readLine().trimmed();
+        handleLine( *worker, std::string( line.constData(), line.size() ) );
+    }
+    if ( mAborted )
+        return;
+
+    char reason[64];
+    if ( exit_status == QProcess::CrashExit )
+        snprintf( reason, sizeof(reason), "worker crashed" );
+    else
+        snprintf( reason, sizeof(reason), "worker exited with code %d", exit_code );
+    lost( *worker, reason );
+}
+
+void CookFarm::lost( Worker& worker, const std::string& reason )
+{
+    ++mCrashes;
+    worker.process->deleteLater();
+    worker.process = nullptr;
+    worker.ready = false;
+    worker.timer->stop();
+
+    int job = worker.job;
+    worker.job = -1;
+    if ( job >= 0 )
+    {
+        if ( ++mAttempts[ job ] < MAX_ATTEMPTS )
+            mQueue.push_front( job );
+        else
+        {
+            VariationStats stats;
+            stats.error = reason;
+            complete( job, stats );
+        }
+    }
+
+    if ( mRemaining <= 0 || mAborted )
+        return;
+
+    // Every start either cooks something or burns an attempt, except for
+    // workers that die before they are ready; don't restart those forever.
+    int max_starts = int( mWorkers.size() ) + MAX_ATTEMPTS * int( mAttempts.size() );
+    if ( mStarts < max_starts )
+    {
+        start( worker );
+        return;
+    }
+    for ( size_t i = 0; i < mWorkers.size(); ++i )
+        if ( mWorkers[i].process )
+            return;
+    abort( "no workers left: " + reason );
+}
+
+void CookFarm::complete( int job, const VariationStats& stats )
+{
+    --mRemaining;
+    if ( mDone )
+        mDone( job, stats );
+    if ( mRemaining <= 0 )
+        mLoop.quit();
+}
+
+void CookFarm::abort( const std::string& error )
+{
+    if ( mAborted )
+        return;
+
+    mAborted = true;
+    mError = error;
+    mLoop.quit();
+}
+
+std::string CookFarm::encodeResult( int index, const VariationStats& stats )
+{
+    std::string error( stats.error );
+    for ( size_t i = 0; i < error.size(); ++i )
+        if ( error[i] == '\t' || error[i] == '\n' || error[i] == '\r' )
+            error[i] = ' ';
+
+    char buffer[256];
+    snprintf( buffer, sizeof(buffer), "%d\t%d\t%.6f\t%.6f\t%.6f\t%.6f\t%d\t%d\t%llu\t%llu\t",
+              index, stats.ok ? 1 : 0,
+              stats.apply_time, stats.cook_time, stats.extract_time, stats.write_time,
+              stats.set_calls, stats.meshes,
+              (unsigned long long)stats.triangles, (unsigned long long)stats.bytes );
+    return buffer + error;
+}
+
+bool CookFarm::decodeResult( const std::string& line, int& index, VariationStats& stats )
+{
+    // Ten numbers, then the error message.
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    while ( fields.size() < 10 )
+    {
+        size_t tab = line.find( '\t', begin );
+        if ( tab == std::string::npos )
+            return false;
+        fields.push_back( line.substr( begin, tab - begin ) );
+        begin = tab + 1;
+    }
+
+    char* end;
+    index = int( strtol( fields[0].c_str(), &end, 10 ) );
+    if ( fields[0].empty() || *end )
+        return false;
+
+    stats.ok = atoi( fields[1].c_str() ) != 0;
+    stats.apply_time = atof( fields[2].c_str() );
+    stats.cook_time = atof( fields[3].c_str() );
+    stats.extract_time = atof( fields[4].c_str() );
+    stats.write_time = atof( fields[5].c_str() );
+    stats.set_calls = atoi( fields[6].c_str() );
+    stats.meshes = atoi( fields[7].c_str() );
+    stats.triangles = size_t( strtoull( fields[8].c_str(), nullptr, 10 ) );
+    stats.bytes = size_t( strtoull( fields[9].c_str(), nullptr, 10 ) );
+    stats.error = line.substr( begin );
+    return true;
+}
+
+};
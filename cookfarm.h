@@ -0,0 +1,107 @@
+#ifndef COOKFARM_H
+#define COOKFARM_H
+
+#include "batchcooker.h"
+#include <QEventLoop>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace hapi {
+
+//
+// Cooks sweep variations on a pool of worker processes, each with its own
+// engine and the asset already instantiated, so variations cook in parallel
+// and a crashing cook only takes down one worker.
+//
+// Workers are started as `program arguments` and talk over their standard
+// channels, one line per message:
+//
+//     worker:     ready                       after the asset is open
+//     worker:     error <tab> message         could not open the asset
+//     front end:  <variation index>           cook this variation
+//     worker:     <encodeResult() line>       finished it
+//
+// Closing a worker's input tells it to exit. Each worker holds one job at a
+// time and takes the next queued one as soon as it reports back, so fast
+// workers pick up the work slow ones would otherwise hold. A job whose
+// worker dies, or doesn't report back within the job timeout, is retried
+// once on a fresh worker before it is reported as failed. A hung worker is
+// killed; so is one whose result line got mixed up with other output and
+// can't be read.
+//
+class CookFarm : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<void( int, const VariationStats& )> Callback;
+
+    CookFarm( const QString& program, const QStringList& arguments, int process_count,
+              QObject *parent = 0 );
+    ~CookFarm();
+
+    // Cooks variations [0, job_count) and calls done for each one as it
+    // finishes, in completion order. Returns false when the workers could
+    // not be started or could not open the asset; see error().
+    bool    run( int job_count, const Callback& done );
+
+    // How long a worker gets for one variation, in msecs; 0 waits forever.
+    // Must be set before run().
+    void    setJobTimeout( int msec ) { mJobTimeout = msec; }
+    int     jobTimeout() const { return mJobTimeout; }
+
+    const std::string& error() const { return mError; }
+    int     crashCount() const { return mCrashes; }
+
+    static std::string encodeResult( int index, const VariationStats& stats );
+    static bool decodeResult( const std::string& line, int& index, VariationStats& stats );
+
+private slots:
+    void    readOutput();
+    void    readError();
+    void    processFinished( int exit_code, QProcess::ExitStatus exit_status );
+    void    processError( QProcess::ProcessError error );
+    void    jobTimedOut();
+
+private:
+    struct Worker
+    {
+        QProcess*   process;
+        QTimer*     timer;
+        bool        ready;
+        int         job;
+    };
+
+    void    start( Worker& worker );
+    void    stop( Worker& worker );
+    void    dispatch( Worker& worker );
+    void    handleLine( Worker& worker, const std::string& line );
+    void    lost( Worker& worker, const std::string& reason );
+    void    complete( int job, const VariationStats& stats );
+    void    abort( const std::string& error );
+    Worker* workerFor( QObject* process );
+    Worker* workerForTimer( QObject* timer );
+
+    QString             mProgram;
+    QStringList         mArguments;
+    std::vector<Worker> mWorkers;
+    std::deque<int>     mQueue;
+    std::vector<int>    mAttempts;
+    int                 mRemaining;
+    int                 mJobTimeout;
+    int                 mStarts;
+    int                 mCrashes;
+    bool                mAborted;
+    Callback            mDone;
+    QEventLoop          mLoop;
+    std::string         mError;
+};
+
+};
+
+#endif // COOKFARM_H
@@ -0,0 +1,252 @@
+#include "cookscheduler.h"
+#include "HAPI_cpp.h"
+#include "cookcache.h"
+#include "resultcache.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QTimer>
+#include <QtConcurrentRun>
+
+#define DEFAULT_DEBOUNCE_MS     (150)
+#define POLL_INTERVAL_MS        (30)
+
+namespace hapi {
+
+// Runs on a pool thread while the scheduler holds back further cooks; null
+// when the export fails.
+static std::shared_ptr<CookResult> ExportResult( GeometryExporter* exporter, int asset_id )
+{
+    try
+    {
+        std::shared_ptr<CookResult> result( new CookResult );
+        result->meshes = exporter->exportAsset( Asset( asset_id ) );
+        return result;
+    }
+    catch ( Failure& )
+    {
+        return std::shared_ptr<CookResult>();
+    }
+}
+
+CookScheduler::CookScheduler( QObject *parent ) :
+    QObject(parent),
+    mAssetId(-1),
+    mCooking(false),
+    mPending(false),
+    mQueued(0),
+    mDropped(0),
+    mCompleted(0),
+    mSkipped(0),
+    mGeneration(0),
+    mCookGeneration(0),
+    mResults(nullptr),
+    mExporter(nullptr),
+    mLibraryKey(0),
+    mCookKey(0),
+    mLastSkipped(false)
+{
+    mDebounce = new QTimer(this);
+    mDebounce->setSingleShot(true);
+    mDebounce->setInterval(DEFAULT_DEBOUNCE_MS);
+    connect( mDebounce, SIGNAL(timeout()), this, SLOT(startCook()) );
+
+    mPoll = new QTimer(this);
+    mPoll->setInterval(POLL_INTERVAL_MS);
+    connect( mPoll, SIGNAL(timeout()), this, SLOT(pollCook()) );
+
+    mExport = new QFutureWatcher< std::shared_ptr<CookResult> >(this);
+    connect( mExport, SIGNAL(finished()), this, SLOT(exportFinished()) );
+}
+
+CookScheduler::~CookScheduler()
+{
+    mExport->waitForFinished();
+    delete mExporter;
+}
+
+void CookScheduler::setAsset( int asset_id )
+{
+    cancel();
+    mExport->waitForFinished();
+    mAssetId = asset_id;
+    mResult.reset();
+}
+
+void CookScheduler::setLibrary( const QString& path )
+{
+    mLibraryKey = 0;
+    QFileInfo file( path );
+    if ( !file.exists() )
+        return;
+
+    QByteArray stamp = file.absoluteFilePath().toUtf8();
+    qint64 size = file.size();
+    qint64 modified = file.lastModified().toMSecsSinceEpoch();
+    stamp.append( reinterpret_cast<const char*>( &size ), sizeof(size) );
+    stamp.append( reinterpret_cast<const char*>( &modified ), sizeof(modified) );
+    mLibraryKey = CookCache::hashData( stamp.constData(), size_t( stamp.size() ) );
+}
+
+void CookScheduler::setResultCache( ResultCache* cache )
+{
+    mResults = cache;
+    if ( mResults && !mExporter )
+        mExporter = new GeometryExporter();
+}
+
+void CookScheduler::setDebounceInterval( int msec )
+{
+    mDebounce->setInterval( msec );
+}
+
+int CookScheduler::debounceInterval() const
+{
+    return mDebounce->interval();
+}
+
+void CookScheduler::resetCounters()
+{
+    mQueued = 0;
+    mDropped = 0;
+    mCompleted = 0;
+    mSkipped = 0;
+}
+
+void CookScheduler::requestCook()
+{
+    if ( mAssetId < 0 )
+        return;
+
+    ++mQueued;
+
+    // Latest wins: a request still waiting to start is superseded.
+    if ( mPending )
+        ++mDropped;
+    mPending = true;
+
+    // A cook in flight restarts the debounce when it finishes.
+    if ( !mCooking )
+        mDebounce->start();
+}
+
+void CookScheduler::cancel()
+{
+    mDebounce->stop();
+    if ( mPending )
+        ++mDropped;
+    mPending = false;
+    ++mGeneration;
+}
+
+void CookScheduler::startCook()
+{
+    if ( mCooking || !mPending )
+        return;
+
+    mPending = false;
+    mCooking = true;
+    mCookGeneration = mGeneration;
+    mLastSkipped = false;
+    mResult.reset();
+    emit cookStarted();
+
+    mCookKey = mResults ? stateKey() : 0;
+    if ( mCookKey )
+    {
+        std::shared_ptr<const CookResult> result = mResults->find( mCookKey );
+        if ( result )
+        {
+            mResult = result;
+            mLastSkipped = true;
+            ++mSkipped;
+            finishCook( true );
+            return;
+        }
+    }
+
+    try
+    {
+        Asset( mAssetId ).cook();
+    }
+    catch ( Failure& )
+    {
+        finishCook( false );
+        return;
+    }
+
+    // With the cooking thread enabled HAPI_CookAsset returns immediately.
+    pollCook();
+    if ( mCooking )
+        mPoll->start();
+}
+
+void CookScheduler::pollCook()
+{
+    int state = HAPI_STATE_READY;
+    if ( HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) ) != HAPI_RESULT_SUCCESS )
+    {
+        finishCook( false );
+        return;
+    }
+
+    if ( state > HAPI_STATE_MAX_READY_STATE )
+        return;
+
+    mPoll->stop();
+    bool success = state != HAPI_STATE_READY_WITH_FATAL_ERRORS;
+
+    // A request that came in mid-cook may have changed parms the cook
+    // already read, so the state key would not match the geometry.
+    if ( success && mCookKey && !mPending && mCookGeneration == mGeneration )
+        mExport->setFuture( QtConcurrent::run( ExportResult, mExporter, mAssetId ) );
+    else
+        finishCook( success );
+}
+
+void CookScheduler::exportFinished()
+{
+    std::shared_ptr<CookResult> result = mExport->result();
+    if ( result )
+        mResults->insert( mCookKey, result );
+    if ( mCookGeneration == mGeneration )
+        mResult = result;
+    finishCook( true );
+}
+
+// The library, asset name and parm values; 0 without a library or when
+// the asset cannot be read.
+uint64_t CookScheduler::stateKey() const
+{
+    if ( !mLibraryKey )
+        return 0;
+
+    try
+    {
+        Asset asset( mAssetId );
+        return CookCache::makeKey( mLibraryKey, asset.name(), *asset.parmValues() );
+    }
+    catch ( Failure& )
+    {
+        return 0;
+    }
+}
+
+void CookScheduler::finishCook( bool success )
+{
+    mPoll->stop();
+    mCooking = false;
+
+    // Cooked for an asset, or parm values, the caller has moved away from.
+    if ( mCookGeneration != mGeneration )
+        ++mDropped;
+    else
+    {
+        ++mCompleted;
+        emit cookFinished( success );
+    }
+
+    if ( mPending )
+        mDebounce->start();
+}
+
+};
@@ -0,0 +1,113 @@
+#ifndef COOKSCHEDULER_H
+#define COOKSCHEDULER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <memory>
+#include <stdint.h>
+
+class QTimer;
+
+namespace hapi {
+
+class ResultCache;
+struct CookResult;
+class GeometryExporter;
+
+//
+// Coalesces bursts of cook requests for one asset. A request (re)starts the
+// debounce timer; when it fires a single cook is started, and requests that
+// arrive while that cook is in flight collapse into one follow-up cook.
+// Requests superseded this way are counted as dropped.
+//
+// cancel() and setAsset() also invalidate a cook already in flight: it is
+// left to finish, since it cannot be stopped, but counts as dropped and
+// does not emit cookFinished(). Until it has, a new request waits for it.
+//
+// With a result cache set, the parameter state is keyed by the library,
+// the asset name and the parm values before cooking. If a recent cook with
+// the same key is cached, its geometry becomes lastResult() and the engine
+// cook is skipped, so the asset's own geometry still shows its last real
+// cook. Otherwise the cook runs and its geometry is exported into the
+// cache on a pool thread; the cook only finishes once that is done.
+//
+class CookScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CookScheduler( QObject *parent = 0 );
+    ~CookScheduler();
+
+    // Waits for an export of the previous asset, so it may be destroyed
+    // once this returns.
+    void    setAsset( int asset_id );
+    int     assetId() const { return mAssetId; }
+
+    // The library the next assets come from; its path, size and time stamp
+    // stand in for its bytes in the cache key. Without one nothing is cached.
+    void    setLibrary( const QString& path );
+
+    void    setDebounceInterval( int msec );
+    int     debounceInterval() const;
+
+    bool    isCooking() const { return mCooking; }
+    bool    isPending() const { return mPending; }
+
+    int     queuedCount() const { return mQueued; }
+    int     droppedCount() const { return mDropped; }
+    int     completedCount() const { return mCompleted; }
+    int     skippedCount() const { return mSkipped; }
+    void    resetCounters();
+
+    // The cache must outlive the scheduler; null turns caching off.
+    void    setResultCache( ResultCache* cache );
+    ResultCache* resultCache() const { return mResults; }
+
+    // Geometry of the last finished cook, or null when caching is off, the
+    // cook failed or its geometry could not be exported.
+    std::shared_ptr<const CookResult> lastResult() const { return mResult; }
+    // True when the last cook was answered from the result cache.
+    bool    lastCookSkipped() const { return mLastSkipped; }
+
+signals:
+    void    cookStarted();
+    void    cookFinished( bool success );
+
+public slots:
+    void    requestCook();
+    void    cancel();
+
+private slots:
+    void    startCook();
+    void    pollCook();
+    void    exportFinished();
+
+private:
+    void    finishCook( bool success );
+    uint64_t stateKey() const;
+
+    int         mAssetId;
+    QTimer*     mDebounce;
+    QTimer*     mPoll;
+    bool        mCooking;
+    bool        mPending;
+    int         mQueued;
+    int         mDropped;
+    int         mCompleted;
+    int         mSkipped;
+    // Bumped by cancel(); a cook started under an older one is stale.
+    unsigned    mGeneration;
+    unsigned    mCookGeneration;
+
+    ResultCache*        mResults;
+    GeometryExporter*   mExporter;
+    QFutureWatcher< std::shared_ptr<CookResult> >* mExport;
+    uint64_t            mLibraryKey;
+    uint64_t            mCookKey;
+    bool                mLastSkipped;
+    std::shared_ptr<const CookResult> mResult;
+};
+
+};
+
+#endif // COOKSCHEDULER_H
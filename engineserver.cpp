@@ -0,0 +1,119 @@
+#include "engineserver.h"
+#include <QCoreApplication>
+#include <cstdio>
+#include <cstring>
+
+// How long listen() waits to find out whether a server is already running.
+#define PROBE_TIMEOUT_MS    (500)
+#define EVICT_INTERVAL_MS   (5000)
+
+namespace hapi {
+
+EngineServer::EngineServer( QObject *parent ) :
+    QObject(parent),
+    mNextId(1)
+{
+    connect( &mServer, SIGNAL(newConnection()), this, SLOT(newConnection()) );
+    connect( &mEvictTimer, SIGNAL(timeout()), this, SLOT(evict()) );
+}
+
+bool EngineServer::listen( const QString& name )
+{
+    QLocalSocket probe;
+    probe.connectToServer( name );
+    if ( probe.waitForConnected( PROBE_TIMEOUT_MS ) )
+    {
+        mError = "a server is already listening on " + name;
+        return false;
+    }
+
+    // Left behind by a server that crashed.
+    QLocalServer::removeServer( name );
+
+#if QT_VERSION >= 0x050000
+    mServer.setSocketOptions( QLocalServer::UserAccessOption );
+#endif
+    if ( !mServer.listen( name ) )
+    {
+        mError = name + ": " + mServer.errorString();
+        return false;
+    }
+
+    mEvictTimer.start( EVICT_INTERVAL_MS );
+    return true;
+}
+
+void EngineServer::newConnection()
+{
+    while ( QLocalSocket* socket = mServer.nextPendingConnection() )
+    {
+        Connection connection;
+        connection.id = mNextId++;
+        mConnections.insert( socket, connection );
+
+        connect( socket, SIGNAL(readyRead()), this, SLOT(readClient()) );
+        connect( socket, SIGNAL(disconnected()), this, SLOT(clientDisconnected()) );
+    }
+}
+
+void EngineServer::readClient()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>( sender() );
+    QHash<QLocalSocket*, Connection>::iterator it = mConnections.find( socket );
+    if ( it == mConnections.end() )
+        return;
+
+    Connection& connection = it.value();
+    connection.input += socket->readAll();
+
+    int offset = 0;
+    while ( connection.input.size() - offset >= int( sizeof(uint32_t) ) )
+    {
+        uint32_t size;
+        memcpy( &size, connection.input.constData() + offset, sizeof(size) );
+        if ( size > REMOTE_MAX_MESSAGE_SIZE )
+        {
+            socket->abort();
+            return;
+        }
+        if ( uint32_t( connection.input.size() - offset ) - sizeof(size) < size )
+            break;
+
+        RemoteMessage request( connection.input.constData() + offset + sizeof(size), size );
+        offset += int( sizeof(size) + size );
+
+        RemoteMessage reply;
+        mEngine.handle( connection.id, request, reply );
+
+        uint32_t reply_size = uint32_t( reply.size() );
+        socket->write( reinterpret_cast<const char*>( &reply_size ), sizeof(reply_size) );
+        socket->write( reply.data(), qint64( reply.size() ) );
+    }
+    connection.input.remove( 0, offset );
+}
+
+void EngineServer::clientDisconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>( sender() );
+    QHash<QLocalSocket*, Connection>::iterator it = mConnections.find( socket );
+    if ( it == mConnections.end() )
+        return;
+
+    mEngine.disconnected( it.value().id );
+    mConnections.erase( it );
+    socket->deleteLater();
+    evict();
+}
+
+void EngineServer::evict()
+{
+    mEngine.evict();
+    if ( mEngine.isFailed() )
+    {
+        fprintf( stderr, "HoudiniEngineServer: cannot restart Houdini Engine: %s\n",
+                 mEngine.error().c_str() );
+        QCoreApplication::exit( 1 );
+    }
+}
+
+};
@@ -0,0 +1,60 @@
+#ifndef ENGINESERVER_H
+#define ENGINESERVER_H
+
+#include "remoteengine.h"
+#include <QByteArray>
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QTimer>
+
+namespace hapi {
+
+//
+// Serves a RemoteEngine to the clients that connect to a local socket, see
+// remoteprotocol.h. Requests are answered one at a time on the event loop,
+// in the order they arrive; a client waits for its reply before it sends
+// the next request, so clients interleave between calls.
+//
+// listen() comes before RemoteEngine::initialize(): clients that started
+// the server connect right away and get their first reply once the engine
+// is up.
+//
+class EngineServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EngineServer( QObject *parent = 0 );
+
+    RemoteEngine&   engine() { return mEngine; }
+
+    // False when another server already listens on name, or when it cannot
+    // be listened on; see error().
+    bool            listen( const QString& name );
+    const QString&  error() const { return mError; }
+
+private slots:
+    void            newConnection();
+    void            readClient();
+    void            clientDisconnected();
+    void            evict();
+
+private:
+    struct Connection
+    {
+        int         id;
+        QByteArray  input;
+    };
+
+    QLocalServer    mServer;
+    QTimer          mEvictTimer;
+    RemoteEngine    mEngine;
+    QHash<QLocalSocket*, Connection> mConnections;
+    int             mNextId;
+    QString         mError;
+};
+
+};
+
+#endif // ENGINESERVER_H
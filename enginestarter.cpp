@@ -0,0 +1,40 @@
+#include "enginestarter.h"
+#include "HAPI_cpp.h"
+
+namespace hapi {
+
+EngineStarter::EngineStarter( QObject *parent ) :
+    QThread(parent), mState(STARTING), mFinishTime(-1)
+{
+    mClock.start();
+
+    // Create the singleton here rather than racing the GUI thread for it.
+    Engine::getInstance();
+}
+
+EngineStarter::State EngineStarter::state() const
+{
+    return State( mState.fetchAndAddOrdered(0) );
+}
+
+void EngineStarter::run()
+{
+    Engine* hapi = Engine::getInstance();
+
+    bool ok = hapi->initialize( nullptr, nullptr, true, -1 );
+    if ( ok )
+        hapi->setLoadMode( Engine::LOAD_FROM_MEMORY );
+    else
+        mError = QString::fromStdString( hapi->getLastError() );
+
+    // Publish the results before the state that guards them.
+    mFinishTime = mClock.elapsed();
+    mState.fetchAndStoreOrdered( ok ? READY : FAILED );
+
+    if ( ok )
+        emit ready();
+    else
+        emit failed( mError );
+}
+
+};
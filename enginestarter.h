@@ -0,0 +1,58 @@
+#ifndef ENGINESTARTER_H
+#define ENGINESTARTER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QString>
+#include <QThread>
+
+namespace hapi {
+
+//
+// Initializes Houdini Engine off the GUI thread. HAPI_Initialize loads
+// Houdini's libraries and can take seconds, so main() starts this before
+// building the window. No other HAPI call may be made until ready() was
+// emitted or state() says READY.
+//
+// The starter's clock starts when it is created, so elapsed() and
+// finishTime() measure from application startup.
+//
+class EngineStarter : public QThread
+{
+    Q_OBJECT
+public:
+    enum State
+    {
+        STARTING,
+        READY,
+        FAILED
+    };
+
+    explicit EngineStarter( QObject *parent = 0 );
+
+    State   state() const;
+    // Why initialization failed, once state() is FAILED.
+    QString errorMessage() const { return mError; }
+
+    // Milliseconds since the starter was created.
+    qint64  elapsed() const { return mClock.elapsed(); }
+    // elapsed() when initialization finished, -1 before.
+    qint64  finishTime() const { return mFinishTime; }
+
+signals:
+    void    ready();
+    void    failed( const QString& message );
+
+protected:
+    virtual void run();
+
+private:
+    QElapsedTimer   mClock;
+    QAtomicInt      mState;
+    qint64          mFinishTime;
+    QString         mError;
+};
+
+};
+
+#endif // ENGINESTARTER_H
@@ -0,0 +1,242 @@
+#include "geoexport.h"
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+
+namespace hapi {
+
+static const float IDENTITY[16] = { 1, 0, 0, 0,
+                                    0, 1, 0, 0,
+                                    0, 0, 1, 0,
+                                    0, 0, 0, 1 };
+
+ExportedMesh::ExportedMesh() :
+    asset_id(-1), object_id(-1), geo_id(-1), part_id(-1),
+    has_normals(false), has_uvs(false), stride(3)
+{
+    memcpy( transform, IDENTITY, sizeof(transform) );
+    for ( int i = 0; i < 3; ++i )
+    {
+        bounds_min[i] = 0.f;
+        bounds_max[i] = 0.f;
+    }
+}
+
+size_t ExportedMesh::byteSize() const
+{
+    return vertices.size() * sizeof(float) + indices.size() * sizeof(int);
+}
+
+// Raw buffers of one part, filled on the HAPI thread.
+struct GeometryExporter::FetchedPart
+{
+    AttribBuffer<int>   face_counts;
+    AttribBuffer<int>   vertex_list;
+    AttribBuffer<float> positions;
+    AttribBuffer<float> normals;
+    AttribBuffer<float> uvs;
+};
+
+static bool HasAttrib( const Part& part, HAPI_AttributeOwner owner, const char* name,
+                       HAPI_AttributeInfo& info )
+{
+    info = part.attribInfo( owner, name );
+    return info.exists && info.storage == HAPI_STORAGETYPE_FLOAT;
+}
+
+// Prefer the vertex attribute over the point one, like Houdini does.
+static AttribBuffer<float> FetchVaryingAttrib( AttribBufferPool& pool, const Part& part,
+                                               const char* name, int min_tuple )
+{
+    HAPI_AttributeInfo info;
+    if ( ( HasAttrib( part, HAPI_ATTROWNER_VERTEX, name, info ) ||
+           HasAttrib( part, HAPI_ATTROWNER_POINT, name, info ) ) &&
+         info.tupleSize >= min_tuple )
+        return pool.floatData( part, info, name );
+    return AttribBuffer<float>();
+}
+
+GeometryExporter::GeometryExporter( int worker_count ) :
+    mWorkers(worker_count),
+    mMaxInFlight(0)
+{
+    mMaxInFlight = mWorkers.threadCount() * 2;
+}
+
+std::shared_ptr<ExportedMesh> GeometryExporter::exportPart( const Part& part, const float transform[16] )
+{
+    std::shared_ptr<ExportedMesh> mesh( new ExportedMesh );
+    mesh->asset_id = part.asset_id;
+    mesh->object_id = part.object_id;
+    mesh->geo_id = part.geo_id;
+    mesh->part_id = part.id;
+    mesh->name = part.name();
+    memcpy( mesh->transform, transform, sizeof(mesh->transform) );
+
+    const HAPI_PartInfo& info = part.info();
+    if ( info.hasVolume || info.isCurve || info.faceCount == 0 )
+        return mesh;
+
+    std::shared_ptr<FetchedPart> fetched( new FetchedPart );
+
+    fetched->face_counts = mPool.acquire<int>( info.faceCount );
+    part.getFaceCounts( fetched->face_counts.data() );
+
+    fetched->vertex_list = mPool.acquire<int>( info.vertexCount );
+    part.getVertexList( fetched->vertex_list.data() );
+
+    fetched->positions = mPool.floatData( part, HAPI_ATTROWNER_POINT, "P" );
+    fetched->normals = FetchVaryingAttrib( mPool, part, "N", 3 );
+    fetched->uvs = FetchVaryingAttrib( mPool, part, "uv", 2 );
+
+    // Keep the number of parts waiting for conversion bounded.
+    mWorkers.waitForPending( mMaxInFlight );
+
+    mWorkers.submit( [fetched, mesh]() { convert( *fetched, *mesh ); } );
+    return mesh;
+}
+
+void GeometryExporter::wait()
+{
+    mWorkers.wait();
+}
+
+std::vector< std::shared_ptr<ExportedMesh> > GeometryExporter::exportAsset( const Asset& asset )
+{
+    std::vector< std::shared_ptr<ExportedMesh> > result;
+
+    std::vector<Object> objects = asset.objects();
+    std::vector<float> transforms( objects.size() * 16 );
+    asset.getObjectTransformsAsMatrices( transforms.data(), 0, int( objects.size() ) );
+
+    for ( size_t o = 0; o < objects.size(); ++o )
+    {
+        const float* transform = &transforms[ o * 16 ];
+
+        std::vector<Geo> geos = objects[o].geos();
+        for ( size_t g = 0; g < geos.size(); ++g )
+        {
+            std::vector<Part> parts = geos[g].parts();
+            for ( size_t p = 0; p < parts.size(); ++p )
+                result.push_back( exportPart( parts[p], transform ) );
+        }
+    }
+
+    wait();
+    return result;
+}
+
+ChangeSet GeometryExporter::syncAsset( const Asset& asset, SyncState& state, MeshMap& meshes )
+{
+    ChangeSet changes = asset.sync( state );
+
+    for ( size_t i = 0; i < changes.removed_parts.size(); ++i )
+    {
+        const Part& part = changes.removed_parts[i];
+        meshes.erase( std::make_tuple( part.object_id, part.geo_id, part.id ) );
+    }
+
+    // The transforms are cached until an object moves, so this is free for
+    // pure geometry changes.
+    int object_count = int( asset.objects().size() );
+    std::vector<float> transforms( object_count * 16 );
+    asset.getObjectTransformsAsMatrices( transforms.data(), 0, object_count );
+
+    for ( size_t i = 0; i < changes.changed_parts.size(); ++i )
+    {
+        const Part& part = changes.changed_parts[i];
+        meshes[ std::make_tuple( part.object_id, part.geo_id, part.id ) ] =
+                exportPart( part, &transforms[ part.object_id * 16 ] );
+    }
+
+    for ( size_t i = 0; i < changes.unchanged_parts.size(); ++i )
+    {
+        const Part& part = changes.unchanged_parts[i];
+        const float* transform = &transforms[ part.object_id * 16 ];
+
+        std::shared_ptr<ExportedMesh>& mesh =
+                meshes[ std::make_tuple( part.object_id, part.geo_id, part.id ) ];
+        if ( !mesh )
+            mesh = exportPart( part, transform );
+        else
+            memcpy( mesh->transform, transform, sizeof(mesh->transform) );
+    }
+
+    wait();
+    return changes;
+}
+
+// Runs on a worker: fan-triangulate every face into an unwelded, interleaved
+// vertex buffer and compute the bounds.
+void GeometryExporter::convert( FetchedPart& fetched, ExportedMesh& mesh )
+{
+    const int* face_counts = fetched.face_counts.data();
+    const int* vertex_list = fetched.vertex_list.data();
+    const float* positions = fetched.positions.data();
+    int face_count = fetched.face_counts.count();
+    int vertex_count = fetched.vertex_list.count();
+    if ( !positions || !vertex_count )
+        return;
+
+    bool vertex_normals = fetched.normals.info().owner == HAPI_ATTROWNER_VERTEX;
+    bool vertex_uvs = fetched.uvs.info().owner == HAPI_ATTROWNER_VERTEX;
+    mesh.has_normals = !fetched.normals.empty();
+    mesh.has_uvs = !fetched.uvs.empty();
+    mesh.stride = 3 + ( mesh.has_normals ? 3 : 0 ) + ( mesh.has_uvs ? 2 : 0 );
+
+    int p_tuple = fetched.positions.tupleSize();
+    int n_tuple = fetched.normals.tupleSize();
+    int uv_tuple = fetched.uvs.tupleSize();
+
+    mesh.vertices.resize( size_t( vertex_count ) * mesh.stride );
+    for ( int i = 0; i < 3; ++i )
+    {
+        mesh.bounds_min[i] = FLT_MAX;
+        mesh.bounds_max[i] = -FLT_MAX;
+    }
+
+    float* out = mesh.vertices.empty() ? nullptr : &mesh.vertices[0];
+    for ( int v = 0; v < vertex_count; ++v )
+    {
+        int point = vertex_list[v];
+        const float* p = positions + point * p_tuple;
+        for ( int i = 0; i < 3; ++i )
+        {
+            *out++ = p[i];
+            mesh.bounds_min[i] = std::min( mesh.bounds_min[i], p[i] );
+            mesh.bounds_max[i] = std::max( mesh.bounds_max[i], p[i] );
+        }
+        if ( mesh.has_normals )
+        {
+            const float* n = fetched.normals.data() + ( vertex_normals ? v : point ) * n_tuple;
+            *out++ = n[0]; *out++ = n[1]; *out++ = n[2];
+        }
+        if ( mesh.has_uvs )
+        {
+            const float* uv = fetched.uvs.data() + ( vertex_uvs ? v : point ) * uv_tuple;
+            *out++ = uv[0]; *out++ = uv[1];
+        }
+    }
+
+    size_t triangles = 0;
+    for ( int f = 0; f < face_count; ++f )
+        triangles += face_counts[f] > 2 ? face_counts[f] - 2 : 0;
+    mesh.indices.reserve( triangles * 3 );
+
+    int first = 0;
+    for ( int f = 0; f < face_count; ++f )
+    {
+        for ( int i = 1; i + 1 < face_counts[f]; ++i )
+        {
+            mesh.indices.push_back( first );
+            mesh.indices.push_back( first + i );
+            mesh.indices.push_back( first + i + 1 );
+        }
+        first += face_counts[f];
+    }
+
+    // Return the raw buffers to the pool as soon as they are consumed.
+    fetched = FetchedPart();
+}
+
+};
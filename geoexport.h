@@ -0,0 +1,89 @@
+#ifndef GEOEXPORT_H
+#define GEOEXPORT_H
+
+#include "HAPI_cpp.h"
+#include "attribbuffer.h"
+#include "workpool.h"
+#include <memory>
+#include <map>
+#include <tuple>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Geometry export:
+
+// A part converted into render-ready form: triangle indices into an
+// interleaved, unwelded vertex buffer (position, then normal and uv when the
+// part has them), plus its object transform and bounds.
+struct ExportedMesh
+{
+    ExportedMesh();
+
+    int asset_id;
+    int object_id;
+    int geo_id;
+    int part_id;
+    std::string name;
+
+    float transform[16];
+
+    bool has_normals;
+    bool has_uvs;
+    // Floats per vertex: 3, plus 3 for normals, plus 2 for uvs.
+    int stride;
+    std::vector<float> vertices;
+    std::vector<int> indices;
+
+    float bounds_min[3];
+    float bounds_max[3];
+
+    size_t byteSize() const;
+};
+
+// Exported meshes of one asset keyed by (object id, geo id, part id).
+typedef std::map< std::tuple<int, int, int>, std::shared_ptr<ExportedMesh> > MeshMap;
+
+// Exports every part of an asset as ExportedMeshes. The calling thread owns
+// all HAPI traffic: it walks objects, geos and parts and fetches the raw
+// buffers. Triangulation, interleaving and bounds run concurrently on a
+// work-stealing pool, overlapping with the next part's fetch.
+class GeometryExporter
+{
+public:
+    // A worker count of 0 uses one worker per hardware thread.
+    explicit GeometryExporter( int worker_count = 0 );
+
+    std::vector< std::shared_ptr<ExportedMesh> > exportAsset( const Asset& asset );
+
+    // Bring meshes up to date after a recook: changed parts are exported
+    // again, removed ones are erased and unchanged meshes keep their buffers,
+    // only getting a new transform when their object moved.
+    ChangeSet       syncAsset( const Asset& asset, SyncState& state, MeshMap& meshes );
+
+    // Fetch on the calling thread and convert on the pool. The returned mesh
+    // is only complete after wait().
+    std::shared_ptr<ExportedMesh> exportPart( const Part& part, const float transform[16] );
+    void            wait();
+
+    // Maximum number of fetched parts waiting for conversion; bounds the
+    // memory held by the pipeline.
+    void            setMaxInFlight( size_t count ) { mMaxInFlight = count; }
+
+    AttribBufferPool&   pool() { return mPool; }
+    WorkPool&           workers() { return mWorkers; }
+
+private:
+    struct FetchedPart;
+
+    static void     convert( FetchedPart& fetched, ExportedMesh& mesh );
+
+    AttribBufferPool    mPool;
+    WorkPool            mWorkers;
+    size_t              mMaxInFlight;
+};
+
+}
+
+#endif // GEOEXPORT_H
@@ -0,0 +1,55 @@
+# Houdini Engine wrapper, geometry export and caches. Shared by the viewer
+# and the batch cooker; needs no Qt.
+
+CONFIG   += c++11
+
+# qmake CONFIG+=hapi_tracing records every HAPI call, see hapitrace.h.
+hapi_tracing: DEFINES += HAPI_ENABLE_TRACING
+
+SOURCES += $$PWD/HAPI_cpp.cpp \
+    $$PWD/hapitrace.cpp \
+    $$PWD/stringcache.cpp \
+    $$PWD/infocache.cpp \
+    $$PWD/attribbuffer.cpp \
+    $$PWD/attribstream.cpp \
+    $$PWD/workpool.cpp \
+    $$PWD/geoexport.cpp \
+    $$PWD/mappedfile.cpp \
+    $$PWD/cookcache.cpp \
+    $$PWD/resultcache.cpp \
+    $$PWD/parmpreset.cpp
+
+HEADERS += $$PWD/HAPI_cpp.h \
+    $$PWD/hapitrace.h \
+    $$PWD/stringcache.h \
+    $$PWD/infocache.h \
+    $$PWD/attribbuffer.h \
+    $$PWD/attribstream.h \
+    $$PWD/workpool.h \
+    $$PWD/geoexport.h \
+    $$PWD/mappedfile.h \
+    $$PWD/cookcache.h \
+    $$PWD/resultcache.h \
+    $$PWD/parmpreset.h
+
+INCLUDEPATH += $$PWD
+
+# qmake CONFIG+=hapi_stub builds against the synthetic engine in stub/
+# instead of Houdini, see stub/hapistub.h.
+hapi_stub {
+    INCLUDEPATH += $$PWD/stub
+    SOURCES += $$PWD/stub/hapistub.cpp
+    HEADERS += $$PWD/stub/hapistub.h \
+        $$PWD/stub/HAPI/HAPI.h
+} else:hapi_remote {
+    # qmake CONFIG+=hapi_remote runs every call on HoudiniEngineServer
+    # instead, see remoteclient.cpp.
+    INCLUDEPATH += "$$(HOUDINI_ROOT)/toolkit/include"
+    SOURCES += $$PWD/remoteclient.cpp \
+        $$PWD/remoteprotocol.cpp
+    HEADERS += $$PWD/remoteprotocol.h
+} else {
+    INCLUDEPATH += "$$(HOUDINI_ROOT)/toolkit/include"
+    LIBS += "$$(HOUDINI_ROOT)/custom/houdini/dsolib/libHAPI.a"
+}
+unix: LIBS += -lpthread
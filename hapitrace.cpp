@@ -0,0 +1,323 @@
+#include "hapitrace.h"
+
+#ifdef HAPI_ENABLE_TRACING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace hapi {
+
+// Sites past this are not recorded; the wrapper has well under a hundred.
+#define MAX_SITES           (256)
+// Bucket i holds calls that took [2^(i-1), 2^i) ns; the last one is open.
+#define HISTOGRAM_BUCKETS   (40)
+// Events are stored in fixed chunks so a buffer never moves while it is
+// being read; calls past the last chunk are counted but not stored.
+#define CHUNK_EVENTS        (4096)
+#define MAX_CHUNKS          (256)
+
+struct Site
+{
+    std::string     name;
+    std::string     tag;
+};
+
+struct SiteStats
+{
+    std::atomic<uint64_t>   count;
+    std::atomic<uint64_t>   total;
+    std::atomic<uint64_t>   buckets[HISTOGRAM_BUCKETS];
+};
+
+struct Event
+{
+    int32_t         site;
+    uint64_t        start;
+    uint64_t        duration;
+};
+
+// Written only by its thread. Readers see every event below event_count,
+// which is published after the event itself.
+struct ThreadBuffer
+{
+    int                     thread_index;
+    SiteStats               stats[MAX_SITES];
+    std::atomic<Event*>     chunks[MAX_CHUNKS];
+    std::atomic<size_t>     event_count;
+    std::atomic<size_t>     dropped;
+};
+
+static std::mutex                   sMutex;
+static std::vector<Site>            sSites;
+// Buffers outlive their threads so a dump still covers finished workers.
+static std::vector<ThreadBuffer*>   sBuffers;
+
+static const std::chrono::steady_clock::time_point sEpoch = std::chrono::steady_clock::now();
+
+static void Clear( ThreadBuffer& buffer )
+{
+    for ( int s = 0; s < MAX_SITES; ++s )
+    {
+        buffer.stats[s].count.store( 0, std::memory_order_relaxed );
+        buffer.stats[s].total.store( 0, std::memory_order_relaxed );
+        for ( int b = 0; b < HISTOGRAM_BUCKETS; ++b )
+            buffer.stats[s].buckets[b].store( 0, std::memory_order_relaxed );
+    }
+    buffer.event_count.store( 0, std::memory_order_release );
+    buffer.dropped.store( 0, std::memory_order_relaxed );
+}
+
+static ThreadBuffer* CurrentBuffer()
+{
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if ( !buffer )
+    {
+        buffer = new ThreadBuffer;
+        for ( int c = 0; c < MAX_CHUNKS; ++c )
+            buffer->chunks[c].store( nullptr, std::memory_order_relaxed );
+        Clear( *buffer );
+
+        std::lock_guard<std::mutex> lock( sMutex );
+        buffer->thread_index = int( sBuffers.size() ) + 1;
+        sBuffers.push_back( buffer );
+    }
+    return buffer;
+}
+
+static int Bucket( uint64_t duration )
+{
+    int bucket = 0;
+    while ( duration && bucket < HISTOGRAM_BUCKETS - 1 )
+    {
+        duration >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+static std::string Escape( const std::string& text )
+{
+    std::string result;
+    result.reserve( text.size() );
+    for ( size_t i = 0; i < text.size(); ++i )
+    {
+        if ( text[i] == '"' || text[i] == '\\' )
+            result += '\\';
+        result += text[i];
+    }
+    return result;
+}
+
+int Trace::site( const char* call, const char* file, int line )
+{
+    Site site;
+
+    const char* begin = call;
+    while ( *begin == ' ' || *begin == '(' )
+        ++begin;
+    const char* end = begin;
+    while ( *end == '_' || ( *end >= 'a' && *end <= 'z' ) || ( *end >= 'A' && *end <= 'Z' ) ||
+            ( *end >= '0' && *end <= '9' ) )
+        ++end;
+    site.name.assign( begin, end );
+
+    const char* base = std::max( strrchr( file, '/' ), strrchr( file, '\\' ) );
+    char tag[32];
+    snprintf( tag, sizeof(tag), ":%d", line );
+    site.tag = std::string( base ? base + 1 : file ) + tag;
+
+    std::lock_guard<std::mutex> lock( sMutex );
+    if ( sSites.size() >= MAX_SITES )
+        return -1;
+    sSites.push_back( site );
+    return int( sSites.size() ) - 1;
+}
+
+uint64_t Trace::now()
+{
+    return uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - sEpoch ).count() );
+}
+
+void Trace::record( int site, uint64_t start, uint64_t end )
+{
+    if ( site < 0 )
+        return;
+
+    ThreadBuffer* buffer = CurrentBuffer();
+    uint64_t duration = end - start;
+
+    SiteStats& stats = buffer->stats[ site ];
+    stats.count.store( stats.count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    stats.total.store( stats.total.load( std::memory_order_relaxed ) + duration, std::memory_order_relaxed );
+    std::atomic<uint64_t>& bucket = stats.buckets[ Bucket( duration ) ];
+    bucket.store( bucket.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+
+    size_t index = buffer->event_count.load( std::memory_order_relaxed );
+    size_t chunk_index = index / CHUNK_EVENTS;
+    if ( chunk_index >= MAX_CHUNKS )
+    {
+        buffer->dropped.store( buffer->dropped.load( std::memory_order_relaxed ) + 1,
+                               std::memory_order_relaxed );
+        return;
+    }
+
+    Event* chunk = buffer->chunks[ chunk_index ].load( std::memory_order_relaxed );
+    if ( !chunk )
+    {
+        chunk = new Event[ CHUNK_EVENTS ];
+        buffer->chunks[ chunk_index ].store( chunk, std::memory_order_release );
+    }
+
+    Event& event = chunk[ index % CHUNK_EVENTS ];
+    event.site = site;
+    event.start = start;
+    event.duration = duration;
+    buffer->event_count.store( index + 1, std::memory_order_release );
+}
+
+bool Trace::writeChromeTrace( const std::string& path )
+{
+    FILE* file = fopen( path.c_str(), "wb" );
+    if ( !file )
+        return false;
+
+    std::vector<Site> sites;
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock( sMutex );
+        sites = sSites;
+        buffers = sBuffers;
+    }
+
+    fprintf( file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" );
+    bool first = true;
+    for ( size_t b = 0; b < buffers.size(); ++b )
+    {
+        const ThreadBuffer& buffer = *buffers[b];
+        fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                       "\"args\":{\"name\":\"thread %d\"}}",
+                 first ? "" : ",\n", buffer.thread_index, buffer.thread_index );
+        first = false;
+
+        size_t count = buffer.event_count.load( std::memory_order_acquire );
+        for ( size_t i = 0; i < count; ++i )
+        {
+            const Event* chunk = buffer.chunks[ i / CHUNK_EVENTS ].load( std::memory_order_acquire );
+            const Event& event = chunk[ i % CHUNK_EVENTS ];
+            if ( event.site < 0 || event.site >= int( sites.size() ) )
+                continue;
+
+            const Site& site = sites[ event.site ];
+            fprintf( file, ",\n{\"name\":\"%s\",\"cat\":\"hapi\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                           "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"site\":\"%s\"}}",
+                     Escape( site.name ).c_str(), buffer.thread_index,
+                     event.start / 1000.0, event.duration / 1000.0,
+                     Escape( site.tag ).c_str() );
+        }
+    }
+    fprintf( file, "\n]}\n" );
+
+    bool ok = !ferror( file );
+    ok = fclose( file ) == 0 && ok;
+    return ok;
+}
+
+std::string Trace::summary()
+{
+    struct Row
+    {
+        int         site;
+        uint64_t    count;
+        uint64_t    total;
+        uint64_t    buckets[HISTOGRAM_BUCKETS];
+    };
+
+    std::vector<Site> sites;
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock( sMutex );
+        sites = sSites;
+        buffers = sBuffers;
+    }
+
+    std::vector<Row> rows( sites.size() );
+    size_t dropped = 0;
+    for ( size_t s = 0; s < rows.size(); ++s )
+    {
+        memset( &rows[s], 0, sizeof(Row) );
+        rows[s].site = int( s );
+    }
+    for ( size_t b = 0; b < buffers.size(); ++b )
+    {
+        for ( size_t s = 0; s < rows.size(); ++s )
+        {
+            const SiteStats& stats = buffers[b]->stats[s];
+            rows[s].count += stats.count.load( std::memory_order_relaxed );
+            rows[s].total += stats.total.load( std::memory_order_relaxed );
+            for ( int k = 0; k < HISTOGRAM_BUCKETS; ++k )
+                rows[s].buckets[k] += stats.buckets[k].load( std::memory_order_relaxed );
+        }
+        dropped += buffers[b]->dropped.load( std::memory_order_relaxed );
+    }
+
+    std::sort( rows.begin(), rows.end(),
+               []( const Row& a, const Row& b ) { return a.total > b.total; } );
+
+    std::ostringstream out;
+    char line[256];
+    snprintf( line, sizeof(line), "%-36s %-24s %10s %12s %10s %10s %10s\n",
+              "call", "site", "count", "total ms", "mean us", "p50 us", "p99 us" );
+    out << line;
+    for ( size_t r = 0; r < rows.size(); ++r )
+    {
+        const Row& row = rows[r];
+        if ( !row.count )
+            continue;
+
+        // Upper bound of the bucket holding the percentile.
+        double percentiles[2] = { 0.5, 0.99 };
+        double bounds[2] = { 0, 0 };
+        for ( int p = 0; p < 2; ++p )
+        {
+            uint64_t target = uint64_t( percentiles[p] * double( row.count - 1 ) ) + 1;
+            uint64_t seen = 0;
+            for ( int k = 0; k < HISTOGRAM_BUCKETS; ++k )
+            {
+                seen += row.buckets[k];
+                if ( seen >= target )
+                {
+                    bounds[p] = double( uint64_t( 1 ) << k ) / 1000.0;
+                    break;
+                }
+            }
+        }
+
+        snprintf( line, sizeof(line), "%-36s %-24s %10llu %12.3f %10.2f %10.2f %10.2f\n",
+                  sites[ row.site ].name.c_str(), sites[ row.site ].tag.c_str(),
+                  (unsigned long long)row.count, row.total / 1e6,
+                  row.total / 1e3 / double( row.count ), bounds[0], bounds[1] );
+        out << line;
+    }
+    if ( dropped )
+        out << dropped << " events not stored in the trace (buffers full)\n";
+    return out.str();
+}
+
+void Trace::reset()
+{
+    std::lock_guard<std::mutex> lock( sMutex );
+    for ( size_t b = 0; b < sBuffers.size(); ++b )
+        Clear( *sBuffers[b] );
+}
+
+};
+
+#endif // HAPI_ENABLE_TRACING
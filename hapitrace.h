@@ -0,0 +1,77 @@
+#ifndef HAPITRACE_H
+#define HAPITRACE_H
+
+//----------------------------------------------------------------------------
+// HAPI call tracing:
+//
+// Every HAPI call in the wrapper and the widgets goes through HAPI_TRACE().
+// When built with HAPI_ENABLE_TRACING (qmake CONFIG+=hapi_tracing) each call
+// is timed and recorded against its call site: per-site call counts and
+// log2 latency histograms, plus one event per call for a Chrome trace
+// (chrome://tracing or Perfetto). Otherwise HAPI_TRACE() is just the call.
+//
+// Each thread records into its own buffer, so the hot path takes no locks;
+// a mutex is only taken the first time a call site or a thread is seen.
+
+#ifdef HAPI_ENABLE_TRACING
+
+#include <stdint.h>
+#include <string>
+
+namespace hapi
+{
+
+class Trace
+{
+public:
+    // Registers a call site. call is the traced expression; its leading
+    // identifier becomes the event name and file:line the site tag.
+    static int      site( const char* call, const char* file, int line );
+
+    // Nanoseconds on a steady clock.
+    static uint64_t now();
+    static void     record( int site, uint64_t start, uint64_t end );
+
+    // Every recorded call as trace-event JSON. Returns false when the file
+    // cannot be written.
+    static bool     writeChromeTrace( const std::string& path );
+
+    // One line per call site: count, total, mean and histogram percentiles,
+    // most expensive first.
+    static std::string summary();
+
+    // Drops everything recorded so far. Not synchronized with recording
+    // threads; call it while no HAPI calls are in flight.
+    static void     reset();
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope( int site ) : mSite( site ), mStart( Trace::now() ) {}
+    ~TraceScope() { Trace::record( mSite, mStart, Trace::now() ); }
+
+private:
+    TraceScope( const TraceScope& );
+    TraceScope& operator=( const TraceScope& );
+
+    int         mSite;
+    uint64_t    mStart;
+};
+
+}
+
+#define HAPI_TRACE( call ) \
+    ( [&]() { \
+        static const int hapi_trace_site = ::hapi::Trace::site( #call, __FILE__, __LINE__ ); \
+        ::hapi::TraceScope hapi_trace_scope( hapi_trace_site ); \
+        return call; \
+    }() )
+
+#else
+
+#define HAPI_TRACE( call ) ( call )
+
+#endif // HAPI_ENABLE_TRACING
+
+#endif // HAPITRACE_H
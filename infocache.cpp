@@ -0,0 +1,361 @@
+#include "infocache.h"
+#include "HAPI_cpp.h"
+
+namespace hapi {
+
+static void check( HAPI_Result result )
+{
+    if ( result != HAPI_RESULT_SUCCESS )
+        throw Failure( result );
+}
+
+InfoCache::InfoCache() : mHits(0), mMisses(0), mStamp(0)
+{
+}
+
+InfoCache* InfoCache::getInstance()
+{
+    static InfoCache instance;
+    return &instance;
+}
+
+InfoCache::AssetEntry& InfoCache::entry( int asset_id )
+{
+    AssetEntry& result = mAssets[ asset_id ];
+    if ( result.dirty )
+        revalidate( asset_id, result );
+    return result;
+}
+
+void InfoCache::revalidate( int asset_id, AssetEntry& entry )
+{
+    // While the cooking thread is still busy nothing read now would survive
+    // the end of the cook, so fall back to fetching everything again.
+    int state = HAPI_STATE_READY;
+    HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) );
+    if ( state > HAPI_STATE_MAX_READY_STATE )
+    {
+        entry = AssetEntry();
+        entry.dirty = true;
+        return;
+    }
+
+    ++mMisses;
+    std::shared_ptr<HAPI_AssetInfo> info = std::make_shared<HAPI_AssetInfo>();
+    check( HAPI_TRACE( HAPI_GetAssetInfo( asset_id, info.get() ) ) );
+
+    std::shared_ptr<const std::vector<HAPI_ObjectInfo> > old_objects = entry.objects;
+    bool same_asset = entry.info && entry.info->validationId == info->validationId;
+
+    entry.dirty = false;
+    entry.info = info;
+    entry.nodeInfo.reset();
+    entry.objects.reset();
+
+    if ( !same_asset || !old_objects )
+    {
+        entry.transforms.reset();
+        entry.transformStamps.clear();
+        entry.geos.clear();
+        return;
+    }
+
+    ensureObjects( asset_id, entry );
+    const std::vector<HAPI_ObjectInfo>& objects = *entry.objects;
+
+    bool moved = objects.size() != old_objects->size();
+    for ( size_t i = 0; i < objects.size(); ++i )
+    {
+        if ( objects[i].hasTransformChanged )
+        {
+            entry.transformStamps[i] = ++mStamp;
+            moved = true;
+        }
+    }
+    if ( moved )
+        entry.transforms.reset();
+
+    std::map<GeoKey, GeoEntry>::iterator it = entry.geos.begin();
+    while ( it != entry.geos.end() )
+    {
+        int object_id = it->first.first;
+        int geo_id = it->first.second;
+
+        if ( object_id >= int( objects.size() ) || geo_id >= objects[object_id].geoCount )
+        {
+            it = entry.geos.erase( it );
+            continue;
+        }
+        if ( object_id >= int( old_objects->size() ) ||
+             objects[object_id].haveGeosChanged ||
+             objects[object_id].geoCount != (*old_objects)[object_id].geoCount )
+        {
+            // Keep the part infos until the geo says whether they moved.
+            it->second.info.reset();
+        }
+        ++it;
+    }
+}
+
+void InfoCache::ensureInfo( int asset_id, AssetEntry& entry )
+{
+    if ( entry.info )
+        return;
+
+    ++mMisses;
+    std::shared_ptr<HAPI_AssetInfo> info = std::make_shared<HAPI_AssetInfo>();
+    check( HAPI_TRACE( HAPI_GetAssetInfo( asset_id, info.get() ) ) );
+    entry.info = info;
+}
+
+void InfoCache::ensureObjects( int asset_id, AssetEntry& entry )
+{
+    if ( entry.objects )
+        return;
+
+    ensureInfo( asset_id, entry );
+    int count = entry.info->objectCount;
+
+    std::shared_ptr<std::vector<HAPI_ObjectInfo> > objects =
+            std::make_shared<std::vector<HAPI_ObjectInfo> >( count );
+    if ( count > 0 )
+    {
+        ++mMisses;
+        check( HAPI_TRACE( HAPI_GetObjects( asset_id, &(*objects)[0], /*start=*/0, count ) ) );
+    }
+    entry.objects = objects;
+
+    // Objects seen for the first time get a fresh transform stamp.
+    while ( int( entry.transformStamps.size() ) < count )
+        entry.transformStamps.push_back( ++mStamp );
+    entry.transformStamps.resize( count );
+}
+
+InfoCache::GeoEntry& InfoCache::ensureGeo( int asset_id, AssetEntry& entry,
+                                           int object_id, int geo_id )
+{
+    ensureObjects( asset_id, entry );
+
+    GeoEntry& geo = entry.geos[ GeoKey( object_id, geo_id ) ];
+    if ( geo.info )
+        return geo;
+
+    ++mMisses;
+    std::shared_ptr<HAPI_GeoInfo> info = std::make_shared<HAPI_GeoInfo>();
+    HAPI_Result result = HAPI_TRACE( HAPI_GetGeoInfo( asset_id, object_id, geo_id, info.get() ) );
+    if ( result != HAPI_RESULT_SUCCESS )
+    {
+        entry.geos.erase( GeoKey( object_id, geo_id ) );
+        throw Failure( result );
+    }
+
+    if ( geo.stamp == 0 || info->hasGeoChanged || int( geo.parts.size() ) != info->partCount )
+    {
+        geo.parts.clear();
+        geo.parts.resize( info->partCount );
+        geo.stamp = ++mStamp;
+    }
+    geo.info = info;
+    return geo;
+}
+
+std::shared_ptr<const HAPI_AssetInfo> InfoCache::assetInfo( int asset_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    AssetEntry& asset = entry( asset_id );
+    ensureInfo( asset_id, asset );
+
+    if ( misses == mMisses )
+        ++mHits;
+    return asset.info;
+}
+
+std::shared_ptr<const HAPI_NodeInfo> InfoCache::nodeInfo( int asset_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    AssetEntry& asset = entry( asset_id );
+    if ( !asset.nodeInfo )
+    {
+        ensureInfo( asset_id, asset );
+
+        ++mMisses;
+        std::shared_ptr<HAPI_NodeInfo> info = std::make_shared<HAPI_NodeInfo>();
+        check( HAPI_TRACE( HAPI_GetNodeInfo( asset.info->nodeId, info.get() ) ) );
+        asset.nodeInfo = info;
+    }
+
+    if ( misses == mMisses )
+        ++mHits;
+    return asset.nodeInfo;
+}
+
+std::shared_ptr<const std::vector<HAPI_ObjectInfo> > InfoCache::objectInfos( int asset_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    AssetEntry& asset = entry( asset_id );
+    ensureObjects( asset_id, asset );
+
+    if ( misses == mMisses )
+        ++mHits;
+    return asset.objects;
+}
+
+std::shared_ptr<const HAPI_ObjectInfo> InfoCache::objectInfo( int asset_id, int object_id )
+{
+    std::shared_ptr<const std::vector<HAPI_ObjectInfo> > objects = objectInfos( asset_id );
+    if ( object_id < 0 || object_id >= int( objects->size() ) )
+        throw Failure( HAPI_RESULT_INVALID_ARGUMENT );
+
+    // Share ownership of the whole array rather than copying one element.
+    return std::shared_ptr<const HAPI_ObjectInfo>( objects, &(*objects)[object_id] );
+}
+
+std::shared_ptr<const std::vector<HAPI_Transform> > InfoCache::objectTransforms( int asset_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    AssetEntry& asset = entry( asset_id );
+    if ( !asset.transforms )
+    {
+        ensureInfo( asset_id, asset );
+        int count = asset.info->objectCount;
+
+        std::shared_ptr<std::vector<HAPI_Transform> > transforms =
+                std::make_shared<std::vector<HAPI_Transform> >( count );
+        if ( count > 0 )
+        {
+            ++mMisses;
+            check( HAPI_TRACE( HAPI_GetObjectTransforms( asset_id, HAPI_SRT, &(*transforms)[0],
+                                                         /*start=*/0, count ) ) );
+        }
+        asset.transforms = transforms;
+    }
+
+    if ( misses == mMisses )
+        ++mHits;
+    return asset.transforms;
+}
+
+std::shared_ptr<const HAPI_GeoInfo> InfoCache::geoInfo( int asset_id, int object_id, int geo_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    GeoEntry& geo = ensureGeo( asset_id, entry( asset_id ), object_id, geo_id );
+
+    if ( misses == mMisses )
+        ++mHits;
+    return geo.info;
+}
+
+std::shared_ptr<const HAPI_PartInfo> InfoCache::partInfo( int asset_id, int object_id,
+                                                          int geo_id, int part_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    GeoEntry& geo = ensureGeo( asset_id, entry( asset_id ), object_id, geo_id );
+    if ( part_id < 0 || part_id >= int( geo.parts.size() ) )
+        throw Failure( HAPI_RESULT_INVALID_ARGUMENT );
+
+    std::shared_ptr<const HAPI_PartInfo>& part = geo.parts[ part_id ];
+    if ( !part )
+    {
+        ++mMisses;
+        std::shared_ptr<HAPI_PartInfo> info = std::make_shared<HAPI_PartInfo>();
+        check( HAPI_TRACE( HAPI_GetPartInfo( asset_id, object_id, geo_id, part_id, info.get() ) ) );
+        part = info;
+    }
+
+    if ( misses == mMisses )
+        ++mHits;
+    return part;
+}
+
+unsigned InfoCache::transformStamp( int asset_id, int object_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    AssetEntry& asset = entry( asset_id );
+    ensureObjects( asset_id, asset );
+    if ( object_id < 0 || object_id >= int( asset.transformStamps.size() ) )
+        throw Failure( HAPI_RESULT_INVALID_ARGUMENT );
+
+    if ( misses == mMisses )
+        ++mHits;
+    return asset.transformStamps[ object_id ];
+}
+
+unsigned InfoCache::geoStamp( int asset_id, int object_id, int geo_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    size_t misses = mMisses;
+
+    GeoEntry& geo = ensureGeo( asset_id, entry( asset_id ), object_id, geo_id );
+
+    if ( misses == mMisses )
+        ++mHits;
+    return geo.stamp;
+}
+
+void InfoCache::cooked( int asset_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::unordered_map<int, AssetEntry>::iterator it = mAssets.find( asset_id );
+    if ( it != mAssets.end() )
+        it->second.dirty = true;
+}
+
+void InfoCache::invalidateNode( int node_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::unordered_map<int, AssetEntry>::iterator it = mAssets.begin();
+    for ( ; it != mAssets.end(); ++it )
+    {
+        if ( it->second.info && it->second.info->nodeId == node_id )
+            it->second.nodeInfo.reset();
+    }
+}
+
+void InfoCache::remove( int asset_id )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mAssets.erase( asset_id );
+}
+
+void InfoCache::clear()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mAssets.clear();
+}
+
+size_t InfoCache::hits() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mHits;
+}
+
+size_t InfoCache::misses() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mMisses;
+}
+
+void InfoCache::resetCounters()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mHits = 0;
+    mMisses = 0;
+}
+
+};
@@ -0,0 +1,117 @@
+#ifndef INFOCACHE_H
+#define INFOCACHE_H
+
+#include <HAPI/HAPI.h>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <mutex>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Info cache:
+
+// Holds the asset, node, object, geo and part infos of every asset, keyed by
+// (asset, object, geo, part), so handles can be created freely and repeated
+// traversals between cooks never go back to the engine.
+//
+// Cooking an asset only marks its entry for revalidation. The next lookup
+// re-reads the asset info and, with one ranged call, all object infos:
+//  - a different validationId means the asset was recreated and everything
+//    is dropped,
+//  - haveGeosChanged marks the geo infos of that object stale,
+//  - a refetched geo that reports hasGeoChanged drops its part infos,
+//  - hasTransformChanged on any object drops the cached object transforms.
+// Everything else is kept.
+//
+// Because HAPI clears those flags once they are read, the cache also keeps
+// change stamps: a geo's stamp is bumped whenever its geometry changed and
+// an object's transform stamp whenever it moved. Consumers that remember
+// the stamps they last saw, like Asset::sync(), can tell what changed
+// without reading the flags themselves.
+//
+// Infos are handed out as shared pointers, so a caller keeps a consistent
+// copy even if the entry is invalidated meanwhile. Failing HAPI calls throw
+// hapi::Failure.
+class InfoCache
+{
+private:
+    InfoCache();
+public:
+    static InfoCache* getInstance();
+
+    std::shared_ptr<const HAPI_AssetInfo>   assetInfo( int asset_id );
+    std::shared_ptr<const HAPI_NodeInfo>    nodeInfo( int asset_id );
+    std::shared_ptr<const HAPI_ObjectInfo>  objectInfo( int asset_id, int object_id );
+    std::shared_ptr<const HAPI_GeoInfo>     geoInfo( int asset_id, int object_id, int geo_id );
+    std::shared_ptr<const HAPI_PartInfo>    partInfo( int asset_id, int object_id, int geo_id,
+                                                      int part_id );
+
+    // All object infos / HAPI_SRT object transforms of an asset, indexed by
+    // object id.
+    std::shared_ptr<const std::vector<HAPI_ObjectInfo> > objectInfos( int asset_id );
+    std::shared_ptr<const std::vector<HAPI_Transform> >  objectTransforms( int asset_id );
+
+    // Change stamps; never 0 and unique across all assets.
+    unsigned        transformStamp( int asset_id, int object_id );
+    unsigned        geoStamp( int asset_id, int object_id, int geo_id );
+
+    // Marks the asset for revalidation on its next lookup.
+    void            cooked( int asset_id );
+    // Parm edits can add or remove multiparm instances, which changes the
+    // node's parm counts but nothing else.
+    void            invalidateNode( int node_id );
+    void            remove( int asset_id );
+    void            clear();
+
+    size_t          hits() const;
+    size_t          misses() const;
+    void            resetCounters();
+
+private:
+    typedef std::pair<int, int> GeoKey;
+
+    struct GeoEntry
+    {
+        GeoEntry() : stamp( 0 ) {}
+
+        // Null when the owning object reported haveGeosChanged.
+        std::shared_ptr<const HAPI_GeoInfo>                 info;
+        std::vector<std::shared_ptr<const HAPI_PartInfo> >  parts;
+        unsigned                                            stamp;
+    };
+
+    struct AssetEntry
+    {
+        AssetEntry() : dirty( false ) {}
+
+        std::shared_ptr<const HAPI_AssetInfo>                   info;
+        std::shared_ptr<const HAPI_NodeInfo>                    nodeInfo;
+        std::shared_ptr<const std::vector<HAPI_ObjectInfo> >    objects;
+        std::shared_ptr<const std::vector<HAPI_Transform> >     transforms;
+        std::vector<unsigned>                                   transformStamps;
+        std::map<GeoKey, GeoEntry>                              geos;
+        bool                                                    dirty;
+    };
+
+    // All of these must be called with mMutex held.
+    AssetEntry&     entry( int asset_id );
+    void            revalidate( int asset_id, AssetEntry& entry );
+    void            ensureInfo( int asset_id, AssetEntry& entry );
+    void            ensureObjects( int asset_id, AssetEntry& entry );
+    GeoEntry&       ensureGeo( int asset_id, AssetEntry& entry, int object_id, int geo_id );
+
+    mutable std::mutex                      mMutex;
+    std::unordered_map<int, AssetEntry>     mAssets;
+    size_t                                  mHits;
+    size_t                                  mMisses;
+    unsigned                                mStamp;
+};
+
+}
+
+#endif // INFOCACHE_H
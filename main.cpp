@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "enginestarter.h"
 #include <QApplication>
 
 void setStyle( QApplication* app, QWidget* mainwindow )
@@ -40,12 +41,19 @@ int main(int argc, char *argv[])
 {
 
     QApplication a(argc, argv);
-    MainWindow* mainWindow = new MainWindow();
+
+    // Houdini loads while the window is built and shown.
+    hapi::EngineStarter* starter = new hapi::EngineStarter();
+    starter->start();
+
+    MainWindow* mainWindow = new MainWindow( starter );
     setStyle( &a, mainWindow );
     mainWindow->show();
 
     int result = a.exec();
     delete mainWindow;
+    starter->wait();
+    delete starter;
 
     return result;
 }
@@ -1,62 +1,425 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "assetcatalog.h"
+#include "assetloader.h"
+#include "catalogrefresher.h"
+#include "enginestarter.h"
+#include "parmpreset.h"
+#include "resultcache.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QStatusBar>
+#include <cstdio>
 
 using namespace hapi;
 
-MainWindow::MainWindow(QWidget *parent) :
+MainWindow::MainWindow(EngineStarter* starter, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
-    mParameterView(nullptr)
+    mStarter(starter),
+    mEngineReady(false),
+    mFirstPaintTime(-1),
+    mParameterView(nullptr),
+    mLoader(nullptr),
+    mRefresher(nullptr),
+    mPickAsset(false),
+    mResultCache(nullptr),
+    mCatalog(nullptr)
 {
     ui->setupUi(this);
 
-
-    Engine* hapi = Engine::getInstance();
-
-    hapi->initialize(nullptr, nullptr, true, -1);
-
     currentAssetId = -1;
 
+    // The index of the last session; libraries are only looked at again
+    // when the catalog is opened.
+    mCatalog = new AssetCatalog();
+    mCatalogPath = QDir::homePath() + "/.houdiniengineqt/assetindex";
+    if ( QFile::exists( mCatalogPath ) && !mCatalog->load( mCatalogPath ) )
+        fprintf( stderr, "%s\n", qPrintable( mCatalog->error() ) );
+
     mParameterView = new ParametersView(this);
     setCentralWidget( mParameterView );
 
+    // Recent cook results, so flipping parms back and forth skips the cook.
+    mResultCache = new ResultCache();
+    mParameterView->cookScheduler()->setResultCache( mResultCache );
+
+    mProgress = new QProgressBar(this);
+    mProgress->setMaximumWidth(160);
+    mProgress->hide();
+    mCancelButton = new QPushButton(tr("Cancel"), this);
+    mCancelButton->hide();
+    statusBar()->addPermanentWidget( mProgress );
+    statusBar()->addPermanentWidget( mCancelButton );
+
     connect( ui->actionOpen, SIGNAL(triggered()), this, SLOT(openAsset()) );
+    connect( ui->actionOpenFromCatalog, SIGNAL(triggered()), this, SLOT(openFromCatalog()) );
+    connect( mCancelButton, SIGNAL(clicked()), this, SLOT(cancelOpen()) );
+    connect( ui->actionVirtualize, SIGNAL(toggled(bool)), this, SLOT(setVirtualized(bool)) );
+    connect( ui->actionLoadPreset, SIGNAL(triggered()), this, SLOT(loadPreset()) );
+    connect( ui->actionSavePreset, SIGNAL(triggered()), this, SLOT(savePreset()) );
+    connect( mParameterView->cookScheduler(), SIGNAL(cookFinished(bool)), this, SLOT(cookFinished(bool)) );
+
+    // Nothing touches the engine until the starter is done with it.
+    ui->actionOpen->setEnabled( false );
+    ui->actionOpenFromCatalog->setEnabled( false );
+    statusBar()->showMessage( tr("Starting Houdini Engine...") );
+    connect( mStarter, SIGNAL(ready()), this, SLOT(engineReady()) );
+    connect( mStarter, SIGNAL(failed(QString)), this, SLOT(engineFailed(QString)) );
+
+    // It may have finished before the connections were made.
+    if ( mStarter->state() == EngineStarter::READY )
+        engineReady();
+    else if ( mStarter->state() == EngineStarter::FAILED )
+        engineFailed( mStarter->errorMessage() );
 }
 
 MainWindow::~MainWindow()
 {
-    HAPI_DestroyAsset( currentAssetId );
+    mStarter->wait();
+
+    if ( mLoader )
+    {
+        mLoader->cancel();
+        mLoader->wait();
+    }
+    if ( mRefresher )
+    {
+        mRefresher->cancel();
+        mRefresher->wait();
+    }
+
+    HAPI_TRACE( HAPI_DestroyAsset( currentAssetId ) );
+
+    if ( mCatalog->isDirty() && QDir().mkpath( QDir::homePath() + "/.houdiniengineqt" ) )
+        mCatalog->save( mCatalogPath );
+    delete mCatalog;
 
     if (mParameterView) delete mParameterView;
+    delete mResultCache;
     delete ui;
 
     Engine* hapi = Engine::getInstance();
     hapi->cleanup();
+
+#ifdef HAPI_ENABLE_TRACING
+    QString trace_path = QDir::homePath() + "/.houdiniengineqt/hapi_trace.json";
+    if ( QDir().mkpath( QDir::homePath() + "/.houdiniengineqt" ) &&
+         Trace::writeChromeTrace( trace_path.toStdString() ) )
+        fprintf( stderr, "HAPI trace written to %s\n", qPrintable( trace_path ) );
+    fprintf( stderr, "%s", Trace::summary().c_str() );
+#endif
+}
+
+
+bool MainWindow::event( QEvent* e )
+{
+    if ( e->type() == QEvent::Paint && mFirstPaintTime < 0 )
+    {
+        mFirstPaintTime = mStarter->elapsed();
+        reportStartup();
+    }
+    return QMainWindow::event( e );
 }
 
+void MainWindow::engineReady()
+{
+    if ( mEngineReady )
+        return;
+
+    mEngineReady = true;
+    ui->actionOpen->setEnabled( !mLoader && !mRefresher );
+    ui->actionOpenFromCatalog->setEnabled( !mLoader && !mRefresher );
+    statusBar()->showMessage( tr("Houdini Engine ready in %1 ms").arg( mStarter->finishTime() ), 3000 );
+    reportStartup();
+}
+
+void MainWindow::engineFailed( const QString& message )
+{
+    statusBar()->showMessage( tr("Houdini Engine failed to start: ") + message );
+}
+
+// Once both are known: how long the window took to appear versus the engine.
+void MainWindow::reportStartup()
+{
+    if ( mFirstPaintTime < 0 || !mEngineReady )
+        return;
+
+    fprintf( stderr, "startup: first paint after %lld ms, engine ready after %lld ms\n",
+             (long long)mFirstPaintTime, (long long)mStarter->finishTime() );
+}
 
 void MainWindow::openAsset()
 {
+    if ( mLoader || mRefresher )
+        return;
 
     QString filename = QFileDialog::getOpenFileName(this,
          tr("Open Digital Asset"), "", tr("Digital Asset (*.otl *.hda)"));
 
     if ( filename.size() )
     {
-        Engine* hapi = Engine::getInstance();
-        HAPI_DestroyAsset( currentAssetId );
-        int library_id = hapi->loadAssetLibrary( filename.toStdString().c_str() ) ;
-        if ( library_id >= 0 )
-        {
-            std::string name = hapi->getAssetName( library_id, 0);
-            int asset_id = hapi->instantiateAsset( name.c_str(), true );
-            if ( asset_id >= 0 )
-            {
-                currentAssetId = asset_id;
-                mParameterView->setAsset( asset_id );
-            }
-        }
+        mCatalog->addLibrary( filename );
+        startLoad( filename, QString() );
+    }
+}
+
+void MainWindow::openFromCatalog()
+{
+    if ( mLoader || mRefresher )
+        return;
+
+    // Only libraries that changed since the last refresh are loaded to list
+    // their assets, on the refresher's thread. The engine is its own until
+    // it finishes, so the parameters are not edited meanwhile.
+    mParameterView->cookScheduler()->cancel();
+    mParameterView->setEnabled( false );
+
+    mRefresher = new CatalogRefresher( mCatalog, this );
+    connect( mRefresher, SIGNAL(progress(QString,int,int)), this, SLOT(loadProgress(QString,int,int)) );
+    connect( mRefresher, SIGNAL(refreshed(int)), this, SLOT(catalogRefreshed(int)) );
+    connect( mRefresher, SIGNAL(canceled()), this, SLOT(loadCanceled()) );
+    connect( mRefresher, SIGNAL(finished()), this, SLOT(refresherFinished()) );
+
+    ui->actionOpen->setEnabled( false );
+    ui->actionOpenFromCatalog->setEnabled( false );
+    ui->actionLoadPreset->setEnabled( false );
+    ui->actionSavePreset->setEnabled( false );
+    mProgress->setRange( 0, 0 );
+    mProgress->show();
+    mCancelButton->setEnabled( true );
+    mCancelButton->show();
+    mRefreshTimer.start();
+    mRefresher->start();
+}
+
+void MainWindow::catalogRefreshed( int listed )
+{
+    if ( mCatalog->isDirty() && QDir().mkpath( QDir::homePath() + "/.houdiniengineqt" ) )
+        mCatalog->save( mCatalogPath );
+
+    statusBar()->showMessage( tr("Indexed %1 libraries in %2 ms (%3 listed)")
+                              .arg( mCatalog->libraryCount() )
+                              .arg( mRefreshTimer.elapsed() )
+                              .arg( listed ), 3000 );
+    mPickAsset = true;
+}
+
+// The picker only comes up once the refresher is gone, so opening the chosen
+// asset can start a loader right away.
+void MainWindow::refresherFinished()
+{
+    mRefresher->deleteLater();
+    mRefresher = nullptr;
+
+    mProgress->hide();
+    mCancelButton->hide();
+    mParameterView->setEnabled( true );
+    ui->actionOpen->setEnabled( true );
+    ui->actionOpenFromCatalog->setEnabled( true );
+    ui->actionLoadPreset->setEnabled( currentAssetId >= 0 );
+    ui->actionSavePreset->setEnabled( currentAssetId >= 0 );
+
+    if ( !mPickAsset )
+        return;
+    mPickAsset = false;
+
+    QStringList names = mCatalog->names();
+    if ( names.isEmpty() )
+    {
+        statusBar()->showMessage( tr("No assets found; open a library or set HOUDINI_OTLSCAN_PATH") );
+        return;
+    }
+
+    bool ok = false;
+    QString name = QInputDialog::getItem( this, tr("Open from Catalog"), tr("Asset:"),
+                                          names, 0, false, &ok );
+    const AssetCatalog::Entry* entry = ok ? mCatalog->find( name ) : nullptr;
+    if ( entry )
+        startLoad( entry->file, entry->name );
+}
+
+void MainWindow::startLoad( const QString& filename, const QString& asset_name )
+{
+    mParameterView->clear();
+    HAPI_TRACE( HAPI_DestroyAsset( currentAssetId ) );
+    currentAssetId = -1;
+
+    // The loader owns all HAPI traffic until it finishes.
+    mLoader = new AssetLoader( filename, this );
+    mLoader->setAssetName( asset_name );
+    connect( mLoader, SIGNAL(progress(QString,int,int)), this, SLOT(loadProgress(QString,int,int)) );
+    connect( mLoader, SIGNAL(loaded(int)), this, SLOT(assetLoaded(int)) );
+    connect( mLoader, SIGNAL(failed(QString)), this, SLOT(loadFailed(QString)) );
+    connect( mLoader, SIGNAL(canceled()), this, SLOT(loadCanceled()) );
+    connect( mLoader, SIGNAL(finished()), this, SLOT(loaderFinished()) );
+
+    ui->actionOpen->setEnabled( false );
+    ui->actionOpenFromCatalog->setEnabled( false );
+    ui->actionLoadPreset->setEnabled( false );
+    ui->actionSavePreset->setEnabled( false );
+    mProgress->setRange( 0, 0 );
+    mProgress->show();
+    mCancelButton->setEnabled( true );
+    mCancelButton->show();
+    mLoader->start();
+}
+
+void MainWindow::cancelOpen()
+{
+    if ( mLoader || mRefresher )
+    {
+        mCancelButton->setEnabled( false );
+        statusBar()->showMessage( tr("Canceling...") );
+        if ( mLoader )
+            mLoader->cancel();
+        else
+            mRefresher->cancel();
     }
 }
 
+void MainWindow::setVirtualized( bool virtualized )
+{
+    mParameterView->setVirtualized( virtualized );
+    if ( currentAssetId >= 0 && !mLoader && !mRefresher )
+        mParameterView->setAsset( currentAssetId );
+}
+
+void MainWindow::loadPreset()
+{
+    if ( currentAssetId < 0 || mLoader || mRefresher )
+        return;
+
+    QString filename = QFileDialog::getOpenFileName(this,
+         tr("Load Preset"), "", tr("Parameter Preset (*.hpreset)"));
+    if ( filename.isEmpty() )
+        return;
+
+    ParmPreset preset;
+    if ( !preset.load( filename.toStdString() ) )
+    {
+        statusBar()->showMessage( tr("Failed to load preset: ") + QString::fromStdString( preset.error() ) );
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int calls = 0;
+    try
+    {
+        // One bulk apply; the scheduler does the single cook and the view
+        // refreshes when it finishes.
+        calls = preset.apply( Asset( currentAssetId ), false );
+    }
+    catch ( Failure& )
+    {
+        statusBar()->showMessage( tr("Failed to apply preset: ") +
+                                  QString::fromStdString( Failure::lastErrorMessage() ) );
+        return;
+    }
+    mParameterView->cookScheduler()->requestCook();
+
+    statusBar()->showMessage( tr("Applied %1 parameters in %2 ms (%3 set calls, %4 skipped)")
+                              .arg( preset.entryCount() - preset.skippedCount() )
+                              .arg( timer.elapsed() )
+                              .arg( calls )
+                              .arg( preset.skippedCount() ), 3000 );
+}
+
+void MainWindow::savePreset()
+{
+    if ( currentAssetId < 0 || mLoader || mRefresher )
+        return;
+
+    QString filename = QFileDialog::getSaveFileName(this,
+         tr("Save Preset"), "", tr("Parameter Preset (*.hpreset)"));
+    if ( filename.isEmpty() )
+        return;
+    if ( !filename.endsWith( ".hpreset" ) )
+        filename += ".hpreset";
+
+    ParmPreset preset;
+    try
+    {
+        preset.capture( Asset( currentAssetId ) );
+    }
+    catch ( Failure& )
+    {
+        statusBar()->showMessage( tr("Failed to read parameters: ") +
+                                  QString::fromStdString( Failure::lastErrorMessage() ) );
+        return;
+    }
+
+    if ( preset.save( filename.toStdString() ) )
+        statusBar()->showMessage( tr("Saved %1 parameters").arg( preset.entryCount() ), 2000 );
+    else
+        statusBar()->showMessage( tr("Failed to write ") + filename );
+}
+
+void MainWindow::loadProgress( const QString& stage, int value, int maximum )
+{
+    statusBar()->showMessage( stage + "..." );
+    mProgress->setRange( 0, maximum );
+    mProgress->setValue( value );
+}
+
+void MainWindow::assetLoaded( int asset_id )
+{
+    statusBar()->showMessage( tr("Building parameters...") );
+    currentAssetId = asset_id;
+    mParameterView->cookScheduler()->setLibrary( mLoader->filename() );
+    mParameterView->setAsset( asset_id );
+    ui->actionLoadPreset->setEnabled( true );
+    ui->actionSavePreset->setEnabled( true );
+    statusBar()->showMessage( tr("Ready"), 2000 );
+}
+
+void MainWindow::loadFailed( const QString& message )
+{
+    statusBar()->showMessage( tr("Failed to open asset: ") + message );
+}
+
+void MainWindow::loadCanceled()
+{
+    statusBar()->showMessage( tr("Open canceled"), 2000 );
+}
+
+void MainWindow::loaderFinished()
+{
+    mLoader->deleteLater();
+    mLoader = nullptr;
+
+    mProgress->hide();
+    mCancelButton->hide();
+    ui->actionOpen->setEnabled( true );
+    ui->actionOpenFromCatalog->setEnabled( true );
+}
+
+void MainWindow::cookFinished( bool success )
+{
+    if ( !success )
+    {
+        statusBar()->showMessage( tr("Cook failed") );
+        return;
+    }
+
+    std::shared_ptr<const CookResult> result = mParameterView->cookScheduler()->lastResult();
+    if ( !result )
+    {
+        statusBar()->showMessage( tr("Cooked"), 3000 );
+        return;
+    }
+
+    size_t triangles = 0;
+    for ( size_t i = 0; i < result->meshes.size(); ++i )
+        triangles += result->meshes[i]->indices.size() / 3;
+    statusBar()->showMessage( tr("%1: %2 meshes, %3 triangles")
+                              .arg( mParameterView->cookScheduler()->lastCookSkipped() ? tr("From result cache") : tr("Cooked") )
+                              .arg( qulonglong( result->meshes.size() ) )
+                              .arg( qulonglong( triangles ) ), 3000 );
+}
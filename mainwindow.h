@@ -1,26 +1,77 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include "parametersview.h"
 
+class QProgressBar;
+class QPushButton;
+
 namespace Ui {
 class MainWindow;
 }
 
+namespace hapi {
+class AssetCatalog;
+class EngineStarter;
+class AssetLoader;
+class CatalogRefresher;
+class ResultCache;
+}
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = 0);
+    // The starter must outlive the window.
+    explicit MainWindow(hapi::EngineStarter* starter, QWidget *parent = 0);
     ~MainWindow();
 
 public slots:
     void    openAsset();
+    void    openFromCatalog();
+    void    cancelOpen();
+    void    setVirtualized( bool virtualized );
+    void    loadPreset();
+    void    savePreset();
+
+protected:
+    virtual bool event( QEvent* e );
+
+private slots:
+    void    engineReady();
+    void    engineFailed( const QString& message );
+    void    loadProgress( const QString& stage, int value, int maximum );
+    void    assetLoaded( int asset_id );
+    void    loadFailed( const QString& message );
+    void    loadCanceled();
+    void    loaderFinished();
+    void    catalogRefreshed( int listed );
+    void    refresherFinished();
+    void    cookFinished( bool success );
+
 private:
+    void    startLoad( const QString& filename, const QString& asset_name );
+    void    reportStartup();
+
     Ui::MainWindow *ui;
+    hapi::EngineStarter*  mStarter;
+    bool                  mEngineReady;
+    // Milliseconds from startup to the window's first paint, -1 before.
+    qint64                mFirstPaintTime;
     hapi::ParametersView* mParameterView;
+    hapi::AssetLoader*    mLoader;
+    hapi::CatalogRefresher* mRefresher;
+    QElapsedTimer         mRefreshTimer;
+    // Set once a refresh succeeded, so its asset picker comes up after it.
+    bool                  mPickAsset;
+    hapi::ResultCache*    mResultCache;
+    hapi::AssetCatalog*   mCatalog;
+    QString               mCatalogPath;
+    QProgressBar*         mProgress;
+    QPushButton*          mCancelButton;
     int     currentAssetId;
 };
 
@@ -0,0 +1,150 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace hapi {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() :
+    mData(NULL), mSize(0), mModified(0), mDevice(0), mFileNumber(0), mFile(NULL), mMapping(NULL)
+{
+}
+
+bool MappedFile::open( const std::string& path )
+{
+    close();
+
+    HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( file == INVALID_HANDLE_VALUE )
+        return false;
+
+    LARGE_INTEGER size;
+    BY_HANDLE_FILE_INFORMATION info;
+    if ( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 ||
+         !GetFileInformationByHandle( file, &info ) )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if ( !mapping )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    const void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( !data )
+    {
+        CloseHandle( mapping );
+        CloseHandle( file );
+        return false;
+    }
+
+    mFile = file;
+    mMapping = mapping;
+    mData = static_cast<const char*>( data );
+    mSize = size_t( size.QuadPart );
+    // FILETIME counts 100ns intervals since 1601.
+    uint64_t written = ( uint64_t( info.ftLastWriteTime.dwHighDateTime ) << 32 ) |
+                       info.ftLastWriteTime.dwLowDateTime;
+    mModified = ( int64_t( written ) - 116444736000000000LL ) * 100;
+    mDevice = info.dwVolumeSerialNumber;
+    mFileNumber = ( uint64_t( info.nFileIndexHigh ) << 32 ) | info.nFileIndexLow;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if ( mData )
+        UnmapViewOfFile( mData );
+    if ( mMapping )
+        CloseHandle( mMapping );
+    if ( mFile )
+        CloseHandle( mFile );
+
+    mData = NULL;
+    mSize = 0;
+    mModified = 0;
+    mDevice = 0;
+    mFileNumber = 0;
+    mFile = NULL;
+    mMapping = NULL;
+}
+
+#else
+
+MappedFile::MappedFile() :
+    mData(NULL), mSize(0), mModified(0), mDevice(0), mFileNumber(0)
+{
+}
+
+bool MappedFile::open( const std::string& path )
+{
+    close();
+
+    int fd = ::open( path.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        return false;
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || st.st_size == 0 )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    void* data = mmap( NULL, size_t( st.st_size ), PROT_READ, MAP_SHARED, fd, 0 );
+    // The mapping keeps its own reference to the file.
+    ::close( fd );
+    if ( data == MAP_FAILED )
+        return false;
+
+    mData = static_cast<const char*>( data );
+    mSize = size_t( st.st_size );
+#ifdef __APPLE__
+    mModified = int64_t( st.st_mtimespec.tv_sec ) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    mModified = int64_t( st.st_mtim.tv_sec ) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    mDevice = uint64_t( st.st_dev );
+    mFileNumber = uint64_t( st.st_ino );
+    return true;
+}
+
+void MappedFile::close()
+{
+    if ( mData )
+        munmap( const_cast<char*>( mData ), mSize );
+
+    mData = NULL;
+    mSize = 0;
+    mModified = 0;
+    mDevice = 0;
+    mFileNumber = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::isSameFile( const MappedFile& other ) const
+{
+    return isOpen() && other.isOpen() && mSize == other.mSize && mModified == other.mModified &&
+           mDevice == other.mDevice && mFileNumber == other.mFileNumber;
+}
+
+};
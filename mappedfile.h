@@ -0,0 +1,52 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Memory-mapped file:
+
+// Read-only view of a whole file. The mapping lives as long as the object;
+// pages are loaded by the OS on first access, so opening even a large file
+// is cheap.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool            open( const std::string& path );
+    void            close();
+
+    bool            isOpen() const { return mData != NULL; }
+    const char*     data() const { return mData; }
+    size_t          size() const { return mSize; }
+
+    // True when both map the same, unchanged file: same device and file
+    // number, size and modification time as when they were opened. Much
+    // cheaper to tell than by comparing the contents.
+    bool            isSameFile( const MappedFile& other ) const;
+
+private:
+    MappedFile( const MappedFile& );
+    MappedFile& operator=( const MappedFile& );
+
+    const char*     mData;
+    size_t          mSize;
+    int64_t         mModified;
+    uint64_t        mDevice;
+    uint64_t        mFileNumber;
+#ifdef _WIN32
+    void*           mFile;
+    void*           mMapping;
+#endif
+};
+
+}
+
+#endif // MAPPEDFILE_H
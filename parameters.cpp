@@ -1,4 +1,5 @@
 #include "parameters.h"
+#include <QApplication>
 #include <QVBoxLayout>
 #include <QLineEdit>
 #include <QComboBox>
@@ -50,8 +51,63 @@ ParameterWidget::ParameterWidget( const Parm& parm, QWidget *parent ) : QWidget(
 
 }
 
+// The editors are the direct children of the value widget; spin boxes and
+// combo boxes keep focus in children of their own.
+static QList<QWidget*> Editors( QWidget* value )
+{
+    QList<QWidget*> editors;
+    if ( !value )
+        return editors;
+
+    QList<QWidget*> children = value->findChildren<QWidget*>();
+    for ( int i = 0; i < children.size(); ++i )
+    {
+        if ( children[i]->parentWidget() == value )
+            editors << children[i];
+    }
+    return editors;
+}
+
+int ParameterWidget::focusedEditor() const
+{
+    QWidget* focus = QApplication::focusWidget();
+    QList<QWidget*> editors = Editors( mWidget );
+    for ( int i = 0; focus && i < editors.size(); ++i )
+    {
+        if ( editors[i] == focus || editors[i]->isAncestorOf( focus ) )
+            return i;
+    }
+    return -1;
+}
+
+void ParameterWidget::focusEditor( int index )
+{
+    QList<QWidget*> editors = Editors( mWidget );
+    if ( index >= 0 && !editors.isEmpty() )
+        editors[ qMin( index, editors.size() - 1 ) ]->setFocus( Qt::OtherFocusReason );
+}
+
 void ParameterWidget::editorChanged()
 {
+    emit valueUpdated( this );
+}
+
+// Rebind to a fresh snapshot of the same parm, or to another parm with the
+// same type, size and menu length. The caller must make sure the shape is
+// unchanged; the editors are kept, another parm's labels, ranges and menus
+// are applied to them and their values are refreshed.
+void ParameterWidget::setParm( const Parm& parm )
+{
+    bool other = parm.node_id != mParm.node_id || parm.info().id != mParm.info().id;
+    mParm = parm;
+    if ( mWidget )
+    {
+        mWidget->blockSignals( true );
+        if ( other )
+            mWidget->rebind();
+        mWidget->refresh();
+        mWidget->blockSignals( false );
+    }
 }
 
 //
@@ -120,6 +176,46 @@ void ParameterInt::create()
     }
 }
 
+void ParameterInt::refresh()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        int value = p.getIntValue(i);
+        if ( value == getIntValue(i) )
+            continue;
+
+        mEditor[i]->blockSignals( true );
+        if ( mEditor[i]->objectName() == "choice" )
+            dynamic_cast< QComboBox* >(mEditor[i])->setCurrentIndex( value );
+        else
+            dynamic_cast< QSpinBox* >(mEditor[i])->setValue( value );
+        mEditor[i]->blockSignals( false );
+    }
+}
+
+void ParameterInt::rebind()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        mEditor[i]->blockSignals( true );
+        if ( mEditor[i]->objectName() == "choice" )
+        {
+            QComboBox* cb = dynamic_cast< QComboBox* >(mEditor[i]);
+            for ( int j = 0; j < cb->count(); ++j )
+                cb->setItemText( j, QString( p.choices[j].label().c_str() ) );
+        }
+        else
+        {
+            double imin = p.info().hasMin ? p.info().min : -99999999;
+            double imax = p.info().hasMax ? p.info().max : 99999999;
+            dynamic_cast< QSpinBox* >(mEditor[i])->setRange( imin, imax );
+        }
+        mEditor[i]->blockSignals( false );
+    }
+}
+
 void ParameterInt::valueEdited( int value )
 {
     Q_UNUSED (value);
@@ -134,20 +230,20 @@ void ParameterInt::currentIndexChanged( int value )
 
 void ParameterInt::sync()
 {
-    bool emitting = false;
-    Parm p = owner()->parm();
+    const Parm& p = owner()->parm();
+    ParmTransaction transaction( p );
     int count = size();
     for ( int i =0 ; i < count; ++i )
     {
         int val = this->getIntValue(i);
         if ( val != p.getIntValue(i) )
-        {
-            p.setIntValue( i, val );
-            emitting = true;
-        }
+            transaction.setIntValue( p, i, val );
     }
-    if ( emitting )
+    if ( !transaction.empty() )
+    {
+        transaction.commit();
         emit valueUpdated();
+    }
 }
 
 //
@@ -190,6 +286,34 @@ void ParameterFloat::create()
         l->addStretch();
 }
 
+void ParameterFloat::refresh()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        float value = p.getFloatValue(i);
+        if ( value == getFloatValue(i) )
+            continue;
+
+        mEditor[i]->blockSignals( true );
+        dynamic_cast< QDoubleSpinBox* >(mEditor[i])->setValue( value );
+        mEditor[i]->blockSignals( false );
+    }
+}
+
+void ParameterFloat::rebind()
+{
+    const Parm& p = owner()->parm();
+    double imin = p.info().hasMin ? p.info().min : -99999999;
+    double imax = p.info().hasMin ? p.info().max : 99999999;
+    for ( int i = 0; i < size(); ++i )
+    {
+        mEditor[i]->blockSignals( true );
+        dynamic_cast< QDoubleSpinBox* >(mEditor[i])->setRange( imin, imax );
+        mEditor[i]->blockSignals( false );
+    }
+}
+
 void ParameterFloat::valueEdited( double value )
 {
     Q_UNUSED (value);
@@ -198,20 +322,20 @@ void ParameterFloat::valueEdited( double value )
 
 void ParameterFloat::sync()
 {
-    bool emitting = false;
-    Parm p = owner()->parm();
+    const Parm& p = owner()->parm();
+    ParmTransaction transaction( p );
     int count = size();
     for ( int i =0 ; i < count; ++i )
     {
         float val = this->getFloatValue(i);
         if ( val != p.getFloatValue(i) )
-        {
-            p.setFloatValue( i, val );
-            emitting = true;
-        }
+            transaction.setFloatValue( p, i, val );
     }
-    if ( emitting )
+    if ( !transaction.empty() )
+    {
+        transaction.commit();
         emit valueUpdated();
+    }
 }
 
 //
@@ -256,6 +380,27 @@ void ParameterBool::create()
     }
 }
 
+void ParameterBool::refresh()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        bool value = p.getIntValue(i) != 0;
+        if ( value == getBoolValue(i) )
+            continue;
+
+        mEditor[i]->blockSignals( true );
+        dynamic_cast<QCheckBox*>(mEditor[i])->setChecked( value );
+        mEditor[i]->blockSignals( false );
+    }
+}
+
+void ParameterBool::rebind()
+{
+    if ( size() )
+        dynamic_cast<QCheckBox*>(mEditor[0])->setText( owner()->parm().label().c_str() );
+}
+
 void ParameterBool::valueEdited( bool value )
 {
     Q_UNUSED (value);
@@ -264,20 +409,20 @@ void ParameterBool::valueEdited( bool value )
 
 void ParameterBool::sync()
 {
-    bool emitting = false;
-    Parm p = owner()->parm();
+    const Parm& p = owner()->parm();
+    ParmTransaction transaction( p );
     int count = size();
     for ( int i =0 ; i < count; ++i )
     {
         bool val = this->getBoolValue(i);
         if ( val != (p.getIntValue(i) != 0) )
-        {
-            p.setIntValue( i, val ? 1 : 0 );
-            emitting = true;
-        }
+            transaction.setIntValue( p, i, val ? 1 : 0 );
     }
-    if ( emitting )
+    if ( !transaction.empty() )
+    {
+        transaction.commit();
         emit valueUpdated();
+    }
 }
 
 //
@@ -358,6 +503,46 @@ void ParameterString::create()
     }
 }
 
+void ParameterString::refresh()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        std::string value = p.getStringValue(i);
+        if ( value == getStringValue(i) )
+            continue;
+
+        mEditor[i]->blockSignals( true );
+        if ( mEditor[i]->objectName() == "choice" )
+        {
+            for ( int j = 0; j < p.choices.size(); ++j )
+            {
+                if ( value == p.choices[j].value() )
+                    dynamic_cast< QComboBox* >(mEditor[i])->setCurrentIndex( j );
+            }
+        }
+        else
+        {
+            dynamic_cast< QLineEdit* >(mEditor[i])->setText( value.c_str() );
+        }
+        mEditor[i]->blockSignals( false );
+    }
+}
+
+void ParameterString::rebind()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        if ( mEditor[i]->objectName() != "choice" )
+            continue;
+
+        QComboBox* cb = dynamic_cast< QComboBox* >(mEditor[i]);
+        for ( int j = 0; j < cb->count(); ++j )
+            cb->setItemText( j, QString( p.choices[j].label().c_str() ) );
+    }
+}
+
 void ParameterString::valueEdited()
 {
     sync();
@@ -371,20 +556,20 @@ void ParameterString::currentIndexChanged( int value )
 
 void ParameterString::sync()
 {
-    bool emitting = false;
-    Parm p = owner()->parm();
+    const Parm& p = owner()->parm();
+    ParmTransaction transaction( p );
     int count = size();
     for ( int i =0 ; i < count; ++i )
     {
         std::string val = this->getStringValue(i);
         if ( val != p.getStringValue(i) )
-        {
-            p.setStringValue( i, val.c_str() );
-            emitting = true;
-        }
+            transaction.setStringValue( p, i, val.c_str() );
     }
-    if ( emitting )
+    if ( !transaction.empty() )
+    {
+        transaction.commit();
         emit valueUpdated();
+    }
 }
 
 
@@ -417,6 +602,20 @@ void ParameterButton::create()
     l->addStretch();
 }
 
+void ParameterButton::refresh()
+{
+}
+
+void ParameterButton::rebind()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        mEditor[i]->setObjectName( p.label().c_str() );
+        dynamic_cast< QPushButton* >(mEditor[i])->setText( p.label().c_str() );
+    }
+}
+
 void ParameterButton::valueEdited()
 {
     sync();
@@ -472,6 +671,21 @@ void ParameterFile::create()
     }
 }
 
+void ParameterFile::refresh()
+{
+    const Parm& p = owner()->parm();
+    for ( int i = 0; i < size(); ++i )
+    {
+        std::string value = p.getStringValue(i);
+        if ( value == getStringValue(i) )
+            continue;
+
+        mEditor[i]->blockSignals( true );
+        dynamic_cast< FileSelector* >(mEditor[i])->setFilename( value.c_str() );
+        mEditor[i]->blockSignals( false );
+    }
+}
+
 void ParameterFile::valueEdited()
 {
     sync();
@@ -479,20 +693,20 @@ void ParameterFile::valueEdited()
 
 void ParameterFile::sync()
 {
-    bool emitting = false;
-    Parm p = owner()->parm();
+    const Parm& p = owner()->parm();
+    ParmTransaction transaction( p );
     int count = size();
     for ( int i =0 ; i < count; ++i )
     {
         std::string val = this->getStringValue(i);
         if ( val != p.getStringValue(i) )
-        {
-            p.setStringValue( i, val.c_str() );
-            emitting = true;
-        }
+            transaction.setStringValue( p, i, val.c_str() );
     }
-    if ( emitting )
+    if ( !transaction.empty() )
+    {
+        transaction.commit();
         emit valueUpdated();
+    }
 }
 
 
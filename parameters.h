@@ -28,6 +28,12 @@ public:
 
     virtual void create() {}
     virtual void sync() {}
+    // Pull the current parm values into the editors without emitting.
+    virtual void refresh() {}
+    // Re-apply what create() took from the parm besides its values, such as
+    // labels, ranges and menu entries, after the owner switched to another
+    // parm of the same shape.
+    virtual void rebind() {}
 
     ParameterWidget* owner() const { return mOwner; }
 
@@ -47,12 +53,19 @@ class ParameterWidget : public QWidget
     Q_OBJECT
 public:
     explicit ParameterWidget( const Parm& parm, QWidget *parent = 0 );
+
+    // Position of the editor holding keyboard focus among this parm's
+    // editors, or -1.
+    int     focusedEditor() const;
+    // Focus the editor at index, or the last one when there are fewer.
+    void    focusEditor( int index );
 signals:
     void    valueUpdated(ParameterWidget*);
 public slots:
     void    editorChanged();
 
     const Parm& parm() { return mParm; }
+    void    setParm( const Parm& parm );
 
 private:
     Parm                mParm;
@@ -73,6 +86,8 @@ public:
     virtual int size()  const { return mEditor.size(); }
     virtual void create();
     virtual void sync();
+    virtual void refresh();
+    virtual void rebind();
 
 public slots:
     void    valueEdited(int);
@@ -94,6 +109,8 @@ public:
     virtual int size()  const { return mEditor.size(); }
     virtual void create();
     virtual void sync();
+    virtual void refresh();
+    virtual void rebind();
 
 public slots:
     void    valueEdited(double);
@@ -114,6 +131,8 @@ public:
     virtual int size()  const { return mEditor.size(); }
     virtual void create();
     virtual void sync();
+    virtual void refresh();
+    virtual void rebind();
 
 public slots:
     void    valueEdited(bool);
@@ -134,6 +153,8 @@ public:
     virtual int size()  const { return mEditor.size(); }
     virtual void create();
     virtual void sync();
+    virtual void refresh();
+    virtual void rebind();
 
 public slots:
     void    valueEdited();
@@ -154,6 +175,8 @@ public:
     virtual int size()  const { return mEditor.size(); }
     virtual void create();
     virtual void sync();
+    virtual void refresh();
+    virtual void rebind();
 
 public slots:
     void    valueEdited();
@@ -174,6 +197,7 @@ public:
     virtual int size()  const { return mEditor.size(); }
     virtual void create();
     virtual void sync();
+    virtual void refresh();
 
 public slots:
     void    valueEdited();
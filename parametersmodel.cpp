@@ -0,0 +1,377 @@
+#include "parametersmodel.h"
+#include "parameters.h"
+#include <QHeaderView>
+#include <QSet>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#define ROW_HEIGHT          (26)
+#define LABEL_WIDTH         (140)
+
+namespace hapi {
+
+// Editors are laid out by parm type, tuple size and menu length; one built
+// for a parm can be rebound to any other of the same shape.
+static qint64 EditorShape( const Parm& parm )
+{
+    return ( qint64( parm.info().type ) << 40 ) | ( qint64( parm.info().size ) << 20 ) |
+           qint64( parm.choices.size() );
+}
+
+static bool ParmHasEditor( const Parm& parm )
+{
+    switch ( parm.info().type )
+    {
+    case HAPI_PARMTYPE_FOLDERLIST:
+    case HAPI_PARMTYPE_FOLDER:
+    case HAPI_PARMTYPE_SEPARATOR:
+        return false;
+    default:
+        return true;
+    }
+}
+
+//
+//
+//
+ParametersModel::ParametersModel( QObject *parent ) :
+    QAbstractItemModel(parent), mTree(nullptr)
+{
+}
+
+void ParametersModel::setTree( const ParmTree* tree )
+{
+    beginResetModel();
+
+    mTree = tree;
+    mRootRows.clear();
+    mRows.clear();
+    mRowOf.clear();
+
+    if ( mTree )
+    {
+        int count = mTree->size();
+        mRows.resize( count );
+        mRowOf.assign( count, -1 );
+
+        for ( int i = 0; i < count; ++i )
+        {
+            if ( mTree->isHidden( i ) )
+                continue;
+
+            int parent = mTree->parent( i );
+            std::vector<int>& rows = parent < 0 ? mRootRows : mRows[parent];
+            mRowOf[i] = int( rows.size() );
+            rows.push_back( i );
+        }
+    }
+
+    endResetModel();
+}
+
+void ParametersModel::refresh()
+{
+    if ( !mTree )
+        return;
+
+    if ( !mRootRows.empty() )
+        emit dataChanged( index( 0, 0 ), index( int( mRootRows.size() ) - 1, 1 ) );
+
+    for ( int i = 0; i < int( mRows.size() ); ++i )
+    {
+        if ( mRows[i].empty() || mRowOf[i] < 0 )
+            continue;
+        QModelIndex parent = indexOf( i );
+        emit dataChanged( index( 0, 0, parent ), index( int( mRows[i].size() ) - 1, 1, parent ) );
+    }
+}
+
+const std::vector<int>& ParametersModel::rowsOf( int tree_index ) const
+{
+    return tree_index < 0 ? mRootRows : mRows[tree_index];
+}
+
+int ParametersModel::treeIndex( const QModelIndex& index ) const
+{
+    return index.isValid() ? int( index.internalId() ) : -1;
+}
+
+QModelIndex ParametersModel::indexOf( int tree_index, int column ) const
+{
+    if ( !mTree || tree_index < 0 || mRowOf[tree_index] < 0 )
+        return QModelIndex();
+    return createIndex( mRowOf[tree_index], column, tree_index );
+}
+
+bool ParametersModel::hasEditor( const QModelIndex& index ) const
+{
+    int tree_index = treeIndex( index );
+    return tree_index >= 0 && ParmHasEditor( mTree->parm( tree_index ) );
+}
+
+QModelIndex ParametersModel::index( int row, int column, const QModelIndex& parent ) const
+{
+    if ( !mTree || column < 0 || column >= 2 )
+        return QModelIndex();
+
+    const std::vector<int>& rows = rowsOf( treeIndex( parent ) );
+    if ( row < 0 || row >= int( rows.size() ) )
+        return QModelIndex();
+
+    return createIndex( row, column, rows[row] );
+}
+
+QModelIndex ParametersModel::parent( const QModelIndex& child ) const
+{
+    int tree_index = treeIndex( child );
+    if ( tree_index < 0 )
+        return QModelIndex();
+    return indexOf( mTree->parent( tree_index ) );
+}
+
+int ParametersModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( !mTree || parent.column() > 0 )
+        return 0;
+    return int( rowsOf( treeIndex( parent ) ).size() );
+}
+
+int ParametersModel::columnCount( const QModelIndex& parent ) const
+{
+    Q_UNUSED (parent);
+    return 2;
+}
+
+QVariant ParametersModel::data( const QModelIndex& index, int role ) const
+{
+    int tree_index = treeIndex( index );
+    if ( tree_index < 0 )
+        return QVariant();
+
+    const Parm& parm = mTree->parm( tree_index );
+
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+        if ( index.column() != 0 ||
+             parm.info().type == HAPI_PARMTYPE_TOGGLE ||
+             parm.info().type == HAPI_PARMTYPE_BUTTON ||
+             parm.info().type == HAPI_PARMTYPE_SEPARATOR )
+            return QVariant();
+        return QString( parm.label().c_str() );
+    case Qt::ToolTipRole:
+        return QString( parm.name().c_str() );
+    case Qt::SizeHintRole:
+        return QSize( index.column() == 0 ? LABEL_WIDTH : -1, ROW_HEIGHT );
+    case ParmIndexRole:
+        return tree_index;
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags ParametersModel::flags( const QModelIndex& index ) const
+{
+    int tree_index = treeIndex( index );
+    if ( tree_index < 0 )
+        return Qt::NoItemFlags;
+    if ( mTree->parm( tree_index ).info().disabled )
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled;
+}
+
+//
+//
+//
+ParametersTreeView::ParametersTreeView( QWidget *parent ) :
+    QTreeView(parent), mModel(nullptr), mUpdateScheduled(false), mFocusParm(-1),
+    mFocusEditor(-1)
+{
+    setUniformRowHeights( true );
+    setSelectionMode( QAbstractItemView::NoSelection );
+    setEditTriggers( QAbstractItemView::NoEditTriggers );
+    setFocusPolicy( Qt::NoFocus );
+    header()->hide();
+
+    connect( this, SIGNAL(expanded(QModelIndex)), this, SLOT(scheduleUpdate()) );
+    connect( this, SIGNAL(collapsed(QModelIndex)), this, SLOT(scheduleUpdate()) );
+}
+
+void ParametersTreeView::setParametersModel( ParametersModel* model )
+{
+    releaseEditors();
+    if ( mModel )
+        disconnect( mModel, SIGNAL(modelAboutToBeReset()), this, SLOT(releaseEditors()) );
+    mModel = model;
+    setModel( model );
+    // A reset lets go of every index widget; take the editors back first.
+    if ( mModel )
+        connect( mModel, SIGNAL(modelAboutToBeReset()), this, SLOT(releaseEditors()) );
+
+    header()->resizeSection( 0, LABEL_WIDTH );
+    header()->setStretchLastSection( true );
+
+    if ( mModel )
+        expandDefaultFolders( QModelIndex() );
+    scheduleUpdate();
+}
+
+// Mirror the tab layout of the widget view: folder lists are open and their
+// first folder is the active one.
+void ParametersTreeView::expandDefaultFolders( const QModelIndex& parent )
+{
+    bool first_folder = true;
+    int rows = mModel->rowCount( parent );
+    for ( int row = 0; row < rows; ++row )
+    {
+        QModelIndex index = mModel->index( row, 0, parent );
+        const Parm& parm = mModel->tree()->parm( mModel->treeIndex( index ) );
+
+        if ( parm.info().type == HAPI_PARMTYPE_FOLDERLIST )
+        {
+            expand( index );
+            expandDefaultFolders( index );
+        }
+        else if ( parm.info().type == HAPI_PARMTYPE_FOLDER && first_folder )
+        {
+            first_folder = false;
+            expand( index );
+            expandDefaultFolders( index );
+        }
+    }
+}
+
+void ParametersTreeView::refreshEditors()
+{
+    QHash<int, ParameterWidget*>::iterator it = mEditors.begin();
+    for ( ; it != mEditors.end(); ++it )
+    {
+        const Parm& parm = mModel->tree()->parm( it.key() );
+        it.value()->setEnabled( !parm.info().disabled );
+        it.value()->setParm( parm );
+    }
+}
+
+void ParametersTreeView::focusParm( int parm_id, int editor )
+{
+    mFocusParm = parm_id;
+    mFocusEditor = editor;
+    scheduleUpdate();
+}
+
+void ParametersTreeView::resizeEvent( QResizeEvent* event )
+{
+    QTreeView::resizeEvent( event );
+    scheduleUpdate();
+}
+
+void ParametersTreeView::scrollContentsBy( int dx, int dy )
+{
+    QTreeView::scrollContentsBy( dx, dy );
+    scheduleUpdate();
+}
+
+void ParametersTreeView::scheduleUpdate()
+{
+    if ( !mUpdateScheduled )
+    {
+        mUpdateScheduled = true;
+        QTimer::singleShot( 0, this, SLOT(updateEditors()) );
+    }
+}
+
+void ParametersTreeView::updateEditors()
+{
+    mUpdateScheduled = false;
+    if ( !mModel )
+        return;
+
+    // Walk the rows from the top of the viewport down to its bottom edge.
+    QSet<int> visible;
+    int bottom = viewport()->height();
+    QModelIndex index = indexAt( QPoint( 0, 0 ) );
+    while ( index.isValid() && visualRect( index ).top() < bottom )
+    {
+        int tree_index = mModel->treeIndex( index );
+        if ( mModel->hasEditor( index ) )
+        {
+            visible.insert( tree_index );
+            if ( !mEditors.contains( tree_index ) )
+            {
+                ParameterWidget* widget = acquireEditor( mModel->tree()->parm( tree_index ) );
+                setIndexWidget( mModel->indexOf( tree_index, 1 ), widget->parentWidget() );
+                mEditors.insert( tree_index, widget );
+            }
+        }
+        index = indexBelow( index );
+    }
+
+    // Release the editors that are no longer on screen.
+    QHash<int, ParameterWidget*>::iterator it = mEditors.begin();
+    while ( it != mEditors.end() )
+    {
+        if ( visible.contains( it.key() ) )
+        {
+            ++it;
+            continue;
+        }
+        setIndexWidget( mModel->indexOf( it.key(), 1 ), nullptr );
+        releaseEditor( it.value() );
+        it = mEditors.erase( it );
+    }
+
+    if ( mFocusParm >= 0 )
+    {
+        int tree_index = mModel->tree()->indexOf( mFocusParm );
+        if ( ParameterWidget* widget = mEditors.value( tree_index, nullptr ) )
+            widget->focusEditor( mFocusEditor );
+        mFocusParm = -1;
+    }
+}
+
+// Index widgets belong to the view, and whether it deletes one it lets go
+// of depends on the Qt version. Editors therefore sit in a bare holder that
+// becomes the index widget, so they can always be taken back out.
+ParameterWidget* ParametersTreeView::acquireEditor( const Parm& parm )
+{
+    ParameterWidget* widget = nullptr;
+    QList<ParameterWidget*>& free = mFreeEditors[ EditorShape( parm ) ];
+    if ( !free.isEmpty() )
+    {
+        widget = free.takeLast();
+        widget->setParm( parm );
+    }
+    else
+    {
+        widget = new ParameterWidget( parm );
+        connect( widget, SIGNAL(valueUpdated(ParameterWidget*)), this, SIGNAL(valueUpdated(ParameterWidget*)) );
+    }
+    widget->setEnabled( !parm.info().disabled );
+
+    QWidget* holder = new QWidget();
+    QVBoxLayout* layout = new QVBoxLayout( holder );
+    layout->setMargin( 0 );
+    layout->addWidget( widget );
+    widget->show();
+    return widget;
+}
+
+// The holder may already have been let go of by the view; deleting it
+// later once more is harmless.
+void ParametersTreeView::releaseEditor( ParameterWidget* widget )
+{
+    QWidget* holder = widget->parentWidget();
+    widget->hide();
+    widget->setParent( this );
+    mFreeEditors[ EditorShape( widget->parm() ) ] << widget;
+    holder->deleteLater();
+}
+
+void ParametersTreeView::releaseEditors()
+{
+    QHash<int, ParameterWidget*>::iterator it = mEditors.begin();
+    for ( ; it != mEditors.end(); ++it )
+        releaseEditor( it.value() );
+    mEditors.clear();
+}
+
+};
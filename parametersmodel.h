@@ -0,0 +1,103 @@
+#ifndef PARAMETERSMODEL_H
+#define PARAMETERSMODEL_H
+
+#include <QAbstractItemModel>
+#include <QTreeView>
+#include <QHash>
+#include <QList>
+#include <vector>
+#include "parmtree.h"
+
+namespace hapi {
+
+class ParameterWidget;
+
+//
+// Item model over a ParmTree. Only parms that are not hidden become rows;
+// folders and folder lists are rows with children. Column 0 holds the
+// label, column 1 is where the view places the editor.
+//
+class ParametersModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum { ParmIndexRole = Qt::UserRole };
+
+    explicit ParametersModel( QObject *parent = 0 );
+
+    void        setTree( const ParmTree* tree );
+    // Notify views that values changed while the rows stayed the same.
+    void        refresh();
+    const ParmTree* tree() const { return mTree; }
+
+    int         treeIndex( const QModelIndex& index ) const;
+    QModelIndex indexOf( int tree_index, int column = 0 ) const;
+    bool        hasEditor( const QModelIndex& index ) const;
+
+    virtual QModelIndex index( int row, int column, const QModelIndex& parent = QModelIndex() ) const;
+    virtual QModelIndex parent( const QModelIndex& child ) const;
+    virtual int         rowCount( const QModelIndex& parent = QModelIndex() ) const;
+    virtual int         columnCount( const QModelIndex& parent = QModelIndex() ) const;
+    virtual QVariant    data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+    virtual Qt::ItemFlags flags( const QModelIndex& index ) const;
+
+private:
+    const std::vector<int>& rowsOf( int tree_index ) const;
+
+    const ParmTree*                 mTree;
+    std::vector<int>                mRootRows;
+    std::vector< std::vector<int> > mRows;
+    std::vector<int>                mRowOf;
+};
+
+//
+// Tree view that materializes ParameterWidget editors only for the rows
+// currently inside the viewport. Editors that scroll out or are collapsed
+// away go back to a free list by shape and are rebound to the next parm of
+// that shape that comes into view, so the number of live widgets is bounded
+// by the viewport height rather than the parm count, and scrolling mostly
+// reuses editors instead of building new ones.
+//
+class ParametersTreeView : public QTreeView
+{
+    Q_OBJECT
+public:
+    explicit ParametersTreeView( QWidget *parent = 0 );
+
+    void    setParametersModel( ParametersModel* model );
+    int     editorCount() const { return mEditors.size(); }
+    // Rebind the live editors to the model's current parms.
+    void    refreshEditors();
+    // Focus editor (see ParameterWidget::focusEditor()) of the parm with
+    // parm_id on the next editor update, if its row is on screen by then.
+    void    focusParm( int parm_id, int editor );
+
+signals:
+    void    valueUpdated( ParameterWidget* );
+
+protected:
+    virtual void resizeEvent( QResizeEvent* event );
+    virtual void scrollContentsBy( int dx, int dy );
+
+private slots:
+    void    scheduleUpdate();
+    void    updateEditors();
+    void    releaseEditors();
+
+private:
+    void    expandDefaultFolders( const QModelIndex& parent );
+    ParameterWidget* acquireEditor( const Parm& parm );
+    void    releaseEditor( ParameterWidget* widget );
+
+    ParametersModel*                mModel;
+    QHash<int, ParameterWidget*>    mEditors;
+    // Hidden editors no row uses, by EditorShape().
+    QHash< qint64, QList<ParameterWidget*> > mFreeEditors;
+    bool                            mUpdateScheduled;
+    int                             mFocusParm;
+    int                             mFocusEditor;
+};
+
+};
+
+#endif // PARAMETERSMODEL_H
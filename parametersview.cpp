@@ -1,8 +1,11 @@
+#include <QApplication>
 #include <QFormLayout>
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QToolButton>
 #include <QTabWidget>
+#include <QScrollBar>
+#include <QPointer>
 #include "parametersview.h"
 #include <QDebug>
 
@@ -11,29 +14,43 @@ namespace hapi {
 #define LAYOUT_MARGIN       (2)
 
 
-bool GetParmParentVisible( std::vector<hapi::Parm>& parms, int id )
+static bool IsFolderParm( const Parm& parm )
 {
-    if ( id < 0 )
-        return false;
+    return parm.info().type == HAPI_PARMTYPE_FOLDER ||
+           parm.info().type == HAPI_PARMTYPE_FOLDERLIST;
+}
 
-    for (int i=0; i < int(parms.size()); ++i)
-    {
-        hapi::Parm &parm = parms[i];
-        if ( parm.info().id == id )
-        {
-            if ( parm.info().invisible )
-                return true;
+// Rows can be patched in place as long as the editor layout they were built
+// with still fits the parm.
+static bool IsSameShape( const Parm& a, const Parm& b )
+{
+    return a.info().type == b.info().type &&
+           a.info().size == b.info().size &&
+           a.info().parentId == b.info().parentId &&
+           a.choices.size() == b.choices.size();
+}
 
-            if ( parm.info().parentId >= 0 && GetParmParentVisible( parms, parm.info().parentId ) )
-                return true;
-        }
+// The editor of view that holds keyboard focus, or null.
+static ParameterWidget* FocusedEditor( QWidget* view )
+{
+    QWidget* focus = QApplication::focusWidget();
+    if ( !focus || !view->isAncestorOf( focus ) )
+        return nullptr;
+
+    for ( QWidget* w = focus; w && w != view; w = w->parentWidget() )
+    {
+        if ( ParameterWidget* editor = qobject_cast<ParameterWidget*>( w ) )
+            return editor;
     }
-    return false;
+    return nullptr;
 }
 
 ParametersView::ParametersView(QWidget *parent) :
-    QScrollArea(parent), mAsset(nullptr), mBase(nullptr)
+    QScrollArea(parent), mAsset(nullptr), mBase(nullptr), mLayout(nullptr),
+    mModel(nullptr), mVirtualized(false)
 {
+    mScheduler = new CookScheduler(this);
+    connect( mScheduler, SIGNAL(cookFinished(bool)), this, SLOT(refresh()) );
 }
 
 ParametersView::~ParametersView()
@@ -49,152 +66,379 @@ void ParametersView::setAsset( int asset_id )
 
     if ( mAsset->isValid() )
     {
-        // Create Base Widget
-        mBase = new QWidget(this);
-        mLayout = new QVBoxLayout();
-        mLayout->setMargin(LAYOUT_MARGIN);
-        mLayout->setSpacing(0);
-        mBase->setLayout(mLayout);
-        mBase->setMinimumWidth(300);
-        setWidget(mBase);
-        setWidgetResizable(true);
+        mScheduler->setAsset( asset_id );
+        mTree.build( mAsset->parms() );
 
-        QVBoxLayout* l = dynamic_cast<QVBoxLayout*>(mLayout);
+        if ( mVirtualized )
+            buildModelView();
+        else
+            buildWidgets();
+    }
+}
 
-        std::vector<hapi::Parm> parms = mAsset->parms();
-        for (int i=0; i < int(parms.size()); ++i)
-        {
-            hapi::Parm parm = parms[i];
+QVBoxLayout* ParametersView::layoutFor( int parent_id )
+{
+    if ( mFolders.find(parent_id) != mFolders.end() )
+        return dynamic_cast<QVBoxLayout*>( mFolders[parent_id]->layout() );
+    return mLayout;
+}
 
-            if ( parm.info().invisible || GetParmParentVisible( parms, parm.info().parentId ) )
-                continue;
+QWidget* ParametersView::createRow( const Parm& parm )
+{
+    if ( parm.info().type == HAPI_PARMTYPE_SEPARATOR )
+    {
+        QFrame* line = new QFrame(mBase);
+        line->setFrameShape(QFrame::HLine);
+        line->setFrameShadow(QFrame::Sunken);
+        mRows[ parm.info().id ] = line;
+        return line;
+    }
 
+    std::string label = parm.label();
+    std::string name  = parm.name();
 
-            std::string label = parm.label();
-            std::string name  = parm.name();
+    QWidget* base = new QWidget(mBase);
+    ParameterWidget* widget = new ParameterWidget( parm, base);
 
-            switch(parm.info().type)
-            {
-            case HAPI_PARMTYPE_SEPARATOR:
-            {
-                QVBoxLayout* layout = l;
-                if ( mFolders.find(parm.info().parentId) != mFolders.end() )
-                {
-                     layout = dynamic_cast<QVBoxLayout*>( mFolders[parm.info().parentId]->layout() );
-                }
-                QFrame* line = new QFrame(mBase);
-                line->setFrameShape(QFrame::HLine);
-                line->setFrameShadow(QFrame::Sunken);
-                layout->addWidget( line );
-                break;
-            }
-            case HAPI_PARMTYPE_FOLDERLIST:
-            {
-                if ( parm.info().size )
-                {
+    connect( widget, SIGNAL(valueUpdated(ParameterWidget*)), this, SLOT(parameterEdited(ParameterWidget*)) );
+    QLabel* namewidget = new QLabel(QString(label.c_str()), base);
 
-                    QTabWidget* tab = new QTabWidget(mBase);
+    if ( parm.info().type == HAPI_PARMTYPE_TOGGLE ||
+         parm.info().type == HAPI_PARMTYPE_BUTTON )
+    {
+        namewidget->setText("");
+    }
+    namewidget->setToolTip( QString(name.c_str()) );
+    namewidget->setMinimumWidth(120);
+    namewidget->setMaximumWidth(120);
+    namewidget->setAlignment( Qt::AlignRight|Qt::AlignCenter );
+    namewidget->setScaledContents( true );
+    QHBoxLayout* lo = new QHBoxLayout();
+    lo->setSpacing(8);
+    lo->setMargin(LAYOUT_MARGIN);
+    lo->addWidget(namewidget);
+    lo->addWidget(widget);
+    base->setLayout(lo);
+    base->setEnabled( !parm.info().disabled );
 
-                    if ( mFolders.find(parm.info().parentId) == mFolders.end() )
-                    {
-                        l->addWidget( tab );
-                    }
-                    else
-                    {
-                        mFolders[parm.info().parentId]->layout()->addWidget( tab );
-                    }
-                    mFolderList[ parm.info().id ] = tab;
+    mRows[ parm.info().id ] = base;
+    mEditors[ parm.info().id ] = widget;
+    return base;
+}
 
-                    for ( int parm_idx = 0; parm_idx < parm.info().size; ++parm_idx )
-                    {
-                        hapi::Parm pp = parms[parm_idx+i+1];
-                        if ( pp.info().type == HAPI_PARMTYPE_FOLDER &&
-                             !pp.info().invisible )
-                        {
-                            QWidget* folder = new QWidget(mBase);
-                            QVBoxLayout* lo = new QVBoxLayout();
-                            lo->setSpacing(0);
-                            lo->setMargin(LAYOUT_MARGIN);
-                            lo->setAlignment(Qt::AlignTop);
-                            folder->setLayout( lo );
-                            mFolders[ pp.info().id ] = folder;
-                            tab->addTab( folder, QString( pp.label().c_str() ) );
-                        }
-                    }
-                }
+void ParametersView::buildWidgets()
+{
+    // Create Base Widget
+    mBase = new QWidget(this);
+    mLayout = new QVBoxLayout();
+    mLayout->setMargin(LAYOUT_MARGIN);
+    mLayout->setSpacing(0);
+    mBase->setLayout(mLayout);
+    mBase->setMinimumWidth(300);
+    setWidget(mBase);
+    setWidgetResizable(true);
 
-                break;
-            }
-            case HAPI_PARMTYPE_FOLDER:
-            {
-                // pass
-                break;
-            }
-            default:
+    const std::vector<hapi::Parm>& parms = mTree.parms();
+    for (int i=0; i < int(parms.size()); ++i)
+    {
+        const hapi::Parm& parm = parms[i];
+
+        if ( mTree.isHidden( i ) )
+            continue;
+
+        switch(parm.info().type)
+        {
+        case HAPI_PARMTYPE_FOLDERLIST:
+        {
+            if ( parm.info().size )
             {
-                QWidget* base = new QWidget(mBase);
-                ParameterWidget* widget = new ParameterWidget( parm, base);
 
-                if ( widget )
-                {
-                    QVBoxLayout* layout = l;
-                    if ( mFolders.find(parm.info().parentId) != mFolders.end() )
-                    {
-                         layout = dynamic_cast<QVBoxLayout*>( mFolders[parm.info().parentId]->layout() );
-                    }
-                    connect( widget, SIGNAL(valueUpdated(ParameterWidget*)), this, SLOT(parameterEdited(ParameterWidget*)) );
-                    QLabel* namewidget = new QLabel(QString(label.c_str()), base);
+                QTabWidget* tab = new QTabWidget(mBase);
 
-                    if ( parm.info().type == HAPI_PARMTYPE_TOGGLE ||
-                         parm.info().type == HAPI_PARMTYPE_BUTTON )
+                layoutFor( parm.info().parentId )->addWidget( tab );
+                mFolderList[ parm.info().id ] = tab;
+
+                for ( int parm_idx = 0; parm_idx < parm.info().size; ++parm_idx )
+                {
+                    const hapi::Parm& pp = parms[parm_idx+i+1];
+                    if ( pp.info().type == HAPI_PARMTYPE_FOLDER &&
+                         !pp.info().invisible )
                     {
-                        namewidget->setText("");
+                        QWidget* folder = new QWidget(mBase);
+                        QVBoxLayout* lo = new QVBoxLayout();
+                        lo->setSpacing(0);
+                        lo->setMargin(LAYOUT_MARGIN);
+                        lo->setAlignment(Qt::AlignTop);
+                        folder->setLayout( lo );
+                        mFolders[ pp.info().id ] = folder;
+                        tab->addTab( folder, QString( pp.label().c_str() ) );
                     }
-                    namewidget->setToolTip( QString(name.c_str()) );
-                    namewidget->setMinimumWidth(120);
-                    namewidget->setMaximumWidth(120);
-                    namewidget->setAlignment( Qt::AlignRight|Qt::AlignCenter );
-                    namewidget->setScaledContents( true );
-                    QHBoxLayout* lo = new QHBoxLayout();
-                    lo->setSpacing(8);
-                    lo->setMargin(LAYOUT_MARGIN);
-                    lo->addWidget(namewidget);
-                    lo->addWidget(widget);
-                    base->setLayout(lo);
-                    layout->addWidget(base);
                 }
-                else
-                {
-                    delete base;
-                }
-            }
             }
+
+            break;
+        }
+        case HAPI_PARMTYPE_FOLDER:
+        {
+            // pass
+            break;
+        }
+        default:
+        {
+            layoutFor( parm.info().parentId )->addWidget( createRow( parm ) );
+        }
         }
-        update();
     }
+    update();
 }
 
-void ParametersView::clear()
+void ParametersView::buildModelView()
 {
-    if ( mAsset )
+    mModel = new ParametersModel(this);
+    mModel->setTree( &mTree );
+
+    ParametersTreeView* view = new ParametersTreeView(this);
+    view->setMinimumWidth(300);
+    connect( view, SIGNAL(valueUpdated(ParameterWidget*)), this, SLOT(parameterEdited(ParameterWidget*)) );
+
+    // The tree view scrolls itself; the scroll area only hosts it.
+    mBase = view;
+    setWidget(mBase);
+    setWidgetResizable(true);
+    view->setParametersModel( mModel );
+    update();
+}
+
+void ParametersView::refresh()
+{
+    if ( !mAsset || !mBase )
+        return;
+
+    // Use a fresh handle: mAsset keeps the node info it was opened with,
+    // which is stale once multiparm instances are added or removed.
+    Asset asset( mAsset->id );
+    if ( !asset.isValid() )
+        return;
+
+    ParmTree tree( asset.parms() );
+
+    // Rebuilt or rebound editors lose keyboard focus; it goes back to the
+    // same editor of the same parm afterwards.
+    QPointer<QWidget> focus = QApplication::focusWidget();
+    ParameterWidget* focused = FocusedEditor( this );
+    int focus_parm = focused ? focused->parm().info().id : -1;
+    int focus_editor = focused ? focused->focusedEditor() : -1;
+
+    if ( mVirtualized )
     {
-        delete mAsset;
-        mAsset = nullptr;
+        refreshModelView( tree );
+        // Editors only come back once the view updates them.
+        if ( focus_parm >= 0 && ( !focus || QApplication::focusWidget() != focus ) )
+            dynamic_cast<ParametersTreeView*>( mBase )->focusParm( focus_parm, focus_editor );
+        return;
+    }
+
+    int vscroll = verticalScrollBar()->value();
+    int hscroll = horizontalScrollBar()->value();
+
+    if ( !refreshWidgets( tree ) )
+    {
+        // The folder layout changed, so the tabs have to be rebuilt.
+        clearWidgets();
+        mTree = std::move( tree );
+        buildWidgets();
+    }
+    else
+    {
+        mTree = std::move( tree );
+    }
+
+    mBase->layout()->activate();
+    verticalScrollBar()->setValue( vscroll );
+    horizontalScrollBar()->setValue( hscroll );
+
+    if ( focus_parm >= 0 && ( !focus || QApplication::focusWidget() != focus ) )
+    {
+        if ( ParameterWidget* widget = mEditors.value( focus_parm, nullptr ) )
+            widget->focusEditor( focus_editor );
+    }
+}
+
+bool ParametersView::refreshWidgets( const ParmTree& tree )
+{
+    // Folders and folder lists own tabs; any change to them means a rebuild.
+    for ( int i = 0; i < tree.size(); ++i )
+    {
+        const Parm& parm = tree.parm( i );
+        if ( !IsFolderParm( parm ) )
+            continue;
+
+        int old = mTree.indexOf( parm.info().id );
+        if ( old < 0 || !IsSameShape( mTree.parm( old ), parm ) ||
+             mTree.isHidden( old ) != tree.isHidden( i ) )
+            return false;
+    }
+    for ( int i = 0; i < mTree.size(); ++i )
+    {
+        if ( IsFolderParm( mTree.parm( i ) ) && tree.indexOf( mTree.parm( i ).info().id ) < 0 )
+            return false;
+    }
+
+    // Drop the rows of parms that went away, e.g. removed multiparm instances.
+    QMap<int, QWidget*>::iterator it = mRows.begin();
+    while ( it != mRows.end() )
+    {
+        if ( tree.indexOf( it.key() ) >= 0 )
+        {
+            ++it;
+            continue;
+        }
+        delete it.value();
+        mEditors.remove( it.key() );
+        it = mRows.erase( it );
+    }
+
+    // Patch the remaining rows and create the new ones in parm order.
+    for ( int i = 0; i < tree.size(); ++i )
+    {
+        const Parm& parm = tree.parm( i );
+        if ( IsFolderParm( parm ) )
+            continue;
+
+        int id = parm.info().id;
+        QWidget* row = mRows.value( id, nullptr );
+
+        int old = mTree.indexOf( id );
+        if ( row && old >= 0 && !IsSameShape( mTree.parm( old ), parm ) )
+        {
+            delete row;
+            mRows.remove( id );
+            mEditors.remove( id );
+            row = nullptr;
+        }
+
+        if ( tree.isHidden( i ) )
+        {
+            if ( row )
+                row->hide();
+            continue;
+        }
+
+        if ( !row )
+        {
+            insertRow( tree, i, createRow( parm ) );
+            continue;
+        }
+
+        row->show();
+        row->setEnabled( !parm.info().disabled );
+        if ( ParameterWidget* widget = mEditors.value( id, nullptr ) )
+            widget->setParm( parm );
+    }
+
+    return true;
+}
+
+// Place a new row right after the closest preceding sibling that is already
+// in the layout.
+void ParametersView::insertRow( const ParmTree& tree, int index, QWidget* row )
+{
+    int parent_id = tree.parm( index ).info().parentId;
+    QVBoxLayout* layout = layoutFor( parent_id );
+
+    int position = 0;
+    for ( int i = index - 1; i >= 0; --i )
+    {
+        const Parm& sibling = tree.parm( i );
+        if ( sibling.info().parentId != parent_id )
+            continue;
+
+        QWidget* widget = mRows.value( sibling.info().id, nullptr );
+        if ( !widget )
+            widget = mFolderList.value( sibling.info().id, nullptr );
+
+        int at = widget ? layout->indexOf( widget ) : -1;
+        if ( at >= 0 )
+        {
+            position = at + 1;
+            break;
+        }
+    }
+    layout->insertWidget( position, row );
+}
+
+void ParametersView::refreshModelView( ParmTree& tree )
+{
+    ParametersTreeView* view = dynamic_cast<ParametersTreeView*>( mBase );
+
+    bool same_rows = tree.size() == mTree.size();
+    for ( int i = 0; same_rows && i < tree.size(); ++i )
+    {
+        // Editors are only refreshed in place, so a parm whose type, size or
+        // menu changed needs the model rebuilt like a moved one.
+        same_rows = tree.parm( i ).info().id == mTree.parm( i ).info().id &&
+                    IsSameShape( mTree.parm( i ), tree.parm( i ) ) &&
+                    tree.parent( i ) == mTree.parent( i ) &&
+                    tree.isHidden( i ) == mTree.isHidden( i );
+    }
+
+    mTree = std::move( tree );
+
+    if ( same_rows )
+    {
+        mModel->refresh();
+        view->refreshEditors();
+    }
+    else
+    {
+        int vscroll = view->verticalScrollBar()->value();
+        mModel->setTree( &mTree );
+        view->setParametersModel( mModel );
+        view->verticalScrollBar()->setValue( vscroll );
     }
+}
 
+void ParametersView::clearWidgets()
+{
     if ( mBase )
     {
         delete mLayout;
         delete mBase;
         mBase = nullptr;
+        mLayout = nullptr;
+    }
+
+    if ( mModel )
+    {
+        delete mModel;
+        mModel = nullptr;
     }
 
+    mFolderList.clear();
+    mFolders.clear();
+    mRows.clear();
+    mEditors.clear();
+}
+
+void ParametersView::clear()
+{
+    mScheduler->setAsset( -1 );
+    mTree.clear();
+
+    if ( mAsset )
+    {
+        delete mAsset;
+        mAsset = nullptr;
+    }
+
+    clearWidgets();
+
     update();
 }
 
 void ParametersView::parameterEdited(ParameterWidget*)
 {
-
+    mScheduler->requestCook();
 }
 
 
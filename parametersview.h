@@ -9,6 +9,9 @@
 #include <QMap>
 #include <QTabWidget>
 #include "parameters.h"
+#include "cookscheduler.h"
+#include "parmtree.h"
+#include "parametersmodel.h"
 
 
 namespace hapi {
@@ -23,17 +26,45 @@ public:
 
     void    setAsset( int asset_id );
     void    clear();
+
+    // In virtualized mode parms are shown through a ParametersModel and
+    // editors only exist for the rows on screen. Takes effect on the next
+    // setAsset().
+    void    setVirtualized( bool virtualized ) { mVirtualized = virtualized; }
+    bool    isVirtualized() const { return mVirtualized; }
+
+    CookScheduler*  cookScheduler() const { return mScheduler; }
+    const ParmTree& parmTree() const { return mTree; }
 signals:
     void    updateParameters( const QString& );
 public slots:
     void    parameterEdited( ParameterWidget* );
 
+    // Re-query the parms after a cook or multiparm change and patch only
+    // the rows that changed. Scroll position and focus are kept.
+    void    refresh();
+
 private:
+    void    buildWidgets();
+    void    buildModelView();
+    void    clearWidgets();
+    QVBoxLayout* layoutFor( int parent_id );
+    QWidget* createRow( const Parm& parm );
+    void    insertRow( const ParmTree& tree, int index, QWidget* row );
+    bool    refreshWidgets( const ParmTree& tree );
+    void    refreshModelView( ParmTree& tree );
+
     Asset*              mAsset;
+    CookScheduler*      mScheduler;
+    ParmTree            mTree;
     QWidget*            mBase;
     QVBoxLayout*        mLayout;
     QMap<int, QTabWidget*>  mFolderList;
     QMap<int, QWidget*>     mFolders;
+    QMap<int, QWidget*>     mRows;
+    QMap<int, ParameterWidget*> mEditors;
+    ParametersModel*    mModel;
+    bool                mVirtualized;
 };
 
 };
@@ -0,0 +1,358 @@
+#include "parmpreset.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace hapi {
+
+#define PRESET_VERSION      (1)
+// Multiparms nested deeper than this keep the instance counts they have.
+#define MAX_INSTANCE_PASSES (8)
+
+static const char PRESET_MAGIC[8] = { 'H', 'E', 'Q', 'P', 'R', 'S', 'E', 'T' };
+
+// Followed by the entry table, the text offsets, the int, float and string
+// value arrays and finally the text itself. Everything before the text is
+// made of 4 byte fields, so every array is naturally aligned.
+struct FileHeader
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    entry_count;
+    uint32_t    int_count;
+    uint32_t    float_count;
+    uint32_t    string_count;
+    uint32_t    text_count;
+    uint32_t    text_bytes;
+    uint32_t    reserved;
+};
+
+// -1 for parms without values (folders, separators, buttons...).
+static int ValueTypeOf( const HAPI_ParmInfo& info )
+{
+    switch ( info.type )
+    {
+    case HAPI_PARMTYPE_INT:
+    case HAPI_PARMTYPE_TOGGLE:
+    case HAPI_PARMTYPE_MULTIPARMLIST:
+        return ParmPreset::INT_VALUES;
+    case HAPI_PARMTYPE_FLOAT:
+    case HAPI_PARMTYPE_COLOR:
+        return ParmPreset::FLOAT_VALUES;
+    case HAPI_PARMTYPE_STRING:
+    case HAPI_PARMTYPE_PATH_FILE:
+    case HAPI_PARMTYPE_PATH_FILE_GEO:
+    case HAPI_PARMTYPE_PATH_FILE_IMAGE:
+    case HAPI_PARMTYPE_PATH_NODE:
+        return ParmPreset::STRING_VALUES;
+    default:
+        return -1;
+    }
+}
+
+template <typename T>
+static const T* ArrayAt( const char* base, size_t& offset, size_t count, size_t size )
+{
+    if ( offset > size || count > ( size - offset ) / sizeof(T) )
+        return nullptr;
+    const T* result = reinterpret_cast<const T*>( base + offset );
+    offset += count * sizeof(T);
+    return result;
+}
+
+template <typename T>
+static void WriteArray( std::ofstream& out, const std::vector<T>& values )
+{
+    if ( !values.empty() )
+        out.write( reinterpret_cast<const char*>( &values[0] ),
+                   std::streamsize( values.size() * sizeof(T) ) );
+}
+
+ParmPreset::ParmPreset() :
+    mSkipped(0)
+{
+}
+
+void ParmPreset::clear()
+{
+    mEntries.clear();
+    mInts.clear();
+    mFloats.clear();
+    mStrings.clear();
+    mTextOffsets.clear();
+    mText.clear();
+    mSkipped = 0;
+}
+
+std::string ParmPreset::entryName( int index ) const
+{
+    return text( mEntries[ index ].name );
+}
+
+uint32_t ParmPreset::intern( const std::string& value,
+                             std::unordered_map<std::string, uint32_t>& index )
+{
+    std::unordered_map<std::string, uint32_t>::const_iterator it = index.find( value );
+    if ( it != index.end() )
+        return it->second;
+
+    uint32_t id = uint32_t( mTextOffsets.size() );
+    mTextOffsets.push_back( uint32_t( mText.size() ) );
+    mText.insert( mText.end(), value.c_str(), value.c_str() + value.size() + 1 );
+    index.insert( std::make_pair( value, id ) );
+    return id;
+}
+
+void ParmPreset::capture( const Asset& asset )
+{
+    clear();
+
+    std::vector<Parm> parms = asset.parms();
+    if ( parms.empty() )
+        return;
+    const ParmValueStore& values = *parms[0].values;
+
+    std::unordered_map<std::string, uint32_t> index;
+    mEntries.reserve( parms.size() );
+    for ( size_t i = 0; i < parms.size(); ++i )
+    {
+        const HAPI_ParmInfo& info = parms[i].info();
+        int type = ValueTypeOf( info );
+        if ( type < 0 || info.size <= 0 )
+            continue;
+
+        Entry entry;
+        entry.name = intern( parms[i].name(), index );
+        entry.type = uint16_t( type );
+        entry.size = uint16_t( info.size );
+
+        if ( type == INT_VALUES )
+        {
+            entry.first = uint32_t( mInts.size() );
+            for ( int c = 0; c < info.size; ++c )
+                mInts.push_back( values.intValue( info.intValuesIndex + c ) );
+        }
+        else if ( type == FLOAT_VALUES )
+        {
+            entry.first = uint32_t( mFloats.size() );
+            for ( int c = 0; c < info.size; ++c )
+                mFloats.push_back( values.floatValue( info.floatValuesIndex + c ) );
+        }
+        else
+        {
+            entry.first = uint32_t( mStrings.size() );
+            for ( int c = 0; c < info.size; ++c )
+                mStrings.push_back( intern( values.stringValue( info.stringValuesIndex + c ), index ) );
+        }
+        mEntries.push_back( entry );
+    }
+}
+
+bool ParmPreset::save( const std::string& path ) const
+{
+    FileHeader header;
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, PRESET_MAGIC, sizeof(PRESET_MAGIC) );
+    header.version = PRESET_VERSION;
+    header.entry_count = uint32_t( mEntries.size() );
+    header.int_count = uint32_t( mInts.size() );
+    header.float_count = uint32_t( mFloats.size() );
+    header.string_count = uint32_t( mStrings.size() );
+    header.text_count = uint32_t( mTextOffsets.size() );
+    header.text_bytes = uint32_t( mText.size() );
+
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out( temp_path.c_str(), std::ios::binary | std::ios::trunc );
+        if ( !out )
+            return false;
+
+        out.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+        WriteArray( out, mEntries );
+        WriteArray( out, mTextOffsets );
+        WriteArray( out, mInts );
+        WriteArray( out, mFloats );
+        WriteArray( out, mStrings );
+        WriteArray( out, mText );
+
+        out.flush();
+        if ( !out )
+        {
+            out.close();
+            remove( temp_path.c_str() );
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    remove( path.c_str() );
+#endif
+    if ( rename( temp_path.c_str(), path.c_str() ) != 0 )
+    {
+        remove( temp_path.c_str() );
+        return false;
+    }
+    return true;
+}
+
+bool ParmPreset::load( const std::string& path )
+{
+    clear();
+    mError.clear();
+
+    MappedFile file;
+    if ( !file.open( path ) )
+    {
+        mError = "cannot open " + path;
+        return false;
+    }
+
+    const char* base = file.data();
+    size_t size = file.size();
+    size_t offset = 0;
+
+    const FileHeader* header = ArrayAt<FileHeader>( base, offset, 1, size );
+    if ( !header || memcmp( header->magic, PRESET_MAGIC, sizeof(PRESET_MAGIC) ) != 0 )
+    {
+        mError = path + " is not a parm preset";
+        return false;
+    }
+    if ( header->version != PRESET_VERSION )
+    {
+        mError = path + " was written by a different version";
+        return false;
+    }
+
+    const Entry* entries = ArrayAt<Entry>( base, offset, header->entry_count, size );
+    const uint32_t* text_offsets = ArrayAt<uint32_t>( base, offset, header->text_count, size );
+    const int32_t* ints = ArrayAt<int32_t>( base, offset, header->int_count, size );
+    const float* floats = ArrayAt<float>( base, offset, header->float_count, size );
+    const uint32_t* strings = ArrayAt<uint32_t>( base, offset, header->string_count, size );
+    const char* text = ArrayAt<char>( base, offset, header->text_bytes, size );
+
+    bool valid = entries && text_offsets && ints && floats && strings && text &&
+                 offset == size &&
+                 ( header->text_bytes == 0 || text[ header->text_bytes - 1 ] == '\0' );
+
+    // Every reference has to stay inside its table.
+    for ( uint32_t i = 0; valid && i < header->text_count; ++i )
+        valid = text_offsets[i] < header->text_bytes;
+    for ( uint32_t i = 0; valid && i < header->string_count; ++i )
+        valid = strings[i] < header->text_count;
+    for ( uint32_t i = 0; valid && i < header->entry_count; ++i )
+    {
+        const Entry& entry = entries[i];
+        uint32_t count = entry.type == INT_VALUES ? header->int_count :
+                         entry.type == FLOAT_VALUES ? header->float_count :
+                         entry.type == STRING_VALUES ? header->string_count : 0;
+        valid = entry.name < header->text_count && entry.size > 0 &&
+                entry.first <= count && entry.size <= count - entry.first;
+    }
+    if ( !valid )
+    {
+        mError = path + " is damaged";
+        return false;
+    }
+
+    mEntries.assign( entries, entries + header->entry_count );
+    mTextOffsets.assign( text_offsets, text_offsets + header->text_count );
+    mInts.assign( ints, ints + header->int_count );
+    mFloats.assign( floats, floats + header->float_count );
+    mStrings.assign( strings, strings + header->string_count );
+    mText.assign( text, text + header->text_bytes );
+    return true;
+}
+
+static void IndexParms( const std::vector<Parm>& parms,
+                        std::unordered_map<std::string, size_t>& index )
+{
+    index.clear();
+    index.reserve( parms.size() );
+    for ( size_t i = 0; i < parms.size(); ++i )
+        index[ parms[i].name() ] = i;
+}
+
+int ParmPreset::apply( const Asset& asset, bool cook )
+{
+    mSkipped = 0;
+
+    std::vector<Parm> parms = asset.parms();
+    std::unordered_map<std::string, size_t> index;
+    IndexParms( parms, index );
+    int calls = 0;
+
+    // Instance counts first: changing one adds or removes parms and shifts
+    // the value indices of everything after it. Each pass commits its own
+    // transaction and re-reads the parms, since a transaction stays bound
+    // to the values it was started on. The instances of a nested multiparm
+    // only exist once its parent's count is set, so this repeats until
+    // nothing changes, at most MAX_INSTANCE_PASSES levels deep.
+    for ( int pass = 0; pass < MAX_INSTANCE_PASSES; ++pass )
+    {
+        ParmTransaction resize( asset );
+        bool instances_changed = false;
+        for ( size_t e = 0; e < mEntries.size(); ++e )
+        {
+            const Entry& entry = mEntries[e];
+            std::unordered_map<std::string, size_t>::const_iterator it = index.find( text( entry.name ) );
+            if ( entry.type != INT_VALUES || it == index.end() )
+                continue;
+
+            const Parm& parm = parms[ it->second ];
+            if ( parm.info().type == HAPI_PARMTYPE_MULTIPARMLIST &&
+                 parm.getIntValue( 0 ) != mInts[ entry.first ] )
+            {
+                resize.setIntValue( parm, 0, mInts[ entry.first ] );
+                instances_changed = true;
+            }
+        }
+        if ( !instances_changed )
+            break;
+
+        calls += resize.commit( false );
+        parms = asset.parms();
+        IndexParms( parms, index );
+    }
+
+    ParmTransaction transaction( asset );
+    for ( size_t e = 0; e < mEntries.size(); ++e )
+    {
+        const Entry& entry = mEntries[e];
+        std::unordered_map<std::string, size_t>::const_iterator it = index.find( text( entry.name ) );
+        if ( it == index.end() || ValueTypeOf( parms[ it->second ].info() ) != int( entry.type ) )
+        {
+            ++mSkipped;
+            continue;
+        }
+
+        const Parm& parm = parms[ it->second ];
+        const HAPI_ParmInfo& info = parm.info();
+        if ( info.type == HAPI_PARMTYPE_MULTIPARMLIST )
+            continue;
+
+        int size = std::min( int( entry.size ), info.size );
+        for ( int c = 0; c < size; ++c )
+        {
+            if ( entry.type == INT_VALUES )
+                transaction.setIntValue( parm, c, mInts[ entry.first + c ] );
+            else if ( entry.type == FLOAT_VALUES )
+                transaction.setFloatValue( parm, c, mFloats[ entry.first + c ] );
+            else
+            {
+                // Strings have no ranged setter; only send the ones that differ.
+                const char* value = text( mStrings[ entry.first + c ] );
+                if ( parm.getStringValue( c ) != value )
+                    transaction.setStringValue( parm, c, value );
+            }
+        }
+    }
+
+    calls += transaction.commit( false );
+    if ( cook )
+        asset.cook();
+    return calls;
+}
+
+};
@@ -0,0 +1,80 @@
+#ifndef PARMPRESET_H
+#define PARMPRESET_H
+
+#include "HAPI_cpp.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Binary parm presets:
+
+// Snapshot of an asset's parm values in a compact binary file. Parm names
+// and string values are interned into one text table; values are stored as
+// flat int, float and string arrays, so a preset loads with a single read
+// and no parsing beyond bounds checks.
+//
+// Applying resolves names through a hash index over the asset's parms and
+// queues everything in one ParmTransaction, so adjacent values go out as
+// ranged HAPI calls and the asset cooks once at most. Multiparm instance
+// counts are set first so the instance parms exist when they are applied.
+// Parms missing from the asset, or whose type changed, are skipped.
+class ParmPreset
+{
+public:
+    enum ValueType
+    {
+        INT_VALUES,
+        FLOAT_VALUES,
+        STRING_VALUES
+    };
+
+    struct Entry
+    {
+        uint32_t    name;       // index into the text table
+        uint16_t    type;       // ValueType
+        uint16_t    size;
+        uint32_t    first;      // first value in the typed array
+    };
+
+    ParmPreset();
+
+    // Throws Failure when the parms cannot be read.
+    void            capture( const Asset& asset );
+    void            clear();
+
+    bool            load( const std::string& path );
+    bool            save( const std::string& path ) const;
+    const std::string& error() const { return mError; }
+
+    int             entryCount() const { return int( mEntries.size() ); }
+    std::string     entryName( int index ) const;
+
+    // Returns the number of HAPI set calls issued. Without cook the caller
+    // is expected to cook, e.g. through a CookScheduler. Throws Failure.
+    int             apply( const Asset& asset, bool cook = true );
+    // Entries skipped by the last apply().
+    int             skippedCount() const { return mSkipped; }
+
+private:
+    uint32_t        intern( const std::string& text,
+                            std::unordered_map<std::string, uint32_t>& index );
+    const char*     text( uint32_t index ) const { return &mText[ mTextOffsets[ index ] ]; }
+
+    std::vector<Entry>      mEntries;
+    std::vector<int32_t>    mInts;
+    std::vector<float>      mFloats;
+    std::vector<uint32_t>   mStrings;
+    std::vector<uint32_t>   mTextOffsets;
+    std::vector<char>       mText;
+    int                     mSkipped;
+    std::string             mError;
+};
+
+}
+
+#endif // PARMPRESET_H
@@ -0,0 +1,80 @@
+#include "parmtree.h"
+
+namespace hapi {
+
+ParmTree::ParmTree()
+{
+}
+
+ParmTree::ParmTree( const std::vector<Parm>& parms )
+{
+    build( parms );
+}
+
+void ParmTree::clear()
+{
+    mParms.clear();
+    mIndex.clear();
+    mParent.clear();
+    mChildren.clear();
+    mRoots.clear();
+    mHidden.clear();
+}
+
+void ParmTree::build( const std::vector<Parm>& parms )
+{
+    clear();
+
+    int count = int( parms.size() );
+    mParms = parms;
+    mIndex.reserve( count );
+    mParent.assign( count, -1 );
+    mChildren.resize( count );
+    mHidden.assign( count, false );
+
+    for ( int i = 0; i < count; ++i )
+        mIndex[ mParms[i].info().id ] = i;
+
+    // Parms whose parent is not part of the node are treated as roots.
+    for ( int i = 0; i < count; ++i )
+    {
+        int parent = indexOf( mParms[i].info().parentId );
+        mParent[i] = parent;
+        if ( parent < 0 )
+            mRoots.push_back( i );
+        else
+            mChildren[parent].push_back( i );
+    }
+
+    // Breadth first from the roots so every parent is resolved before its
+    // children.
+    std::vector<int> queue( mRoots );
+    queue.reserve( count );
+    for ( size_t head = 0; head < queue.size(); ++head )
+    {
+        int index = queue[head];
+        int parent = mParent[index];
+        mHidden[index] = mParms[index].info().invisible ||
+                ( parent >= 0 && mHidden[parent] );
+
+        const std::vector<int>& children = mChildren[index];
+        queue.insert( queue.end(), children.begin(), children.end() );
+    }
+}
+
+int ParmTree::indexOf( HAPI_ParmId id ) const
+{
+    if ( id < 0 )
+        return -1;
+
+    std::unordered_map<HAPI_ParmId, int>::const_iterator it = mIndex.find( id );
+    return it == mIndex.end() ? -1 : it->second;
+}
+
+bool ParmTree::isParentHidden( int index ) const
+{
+    int parent = mParent[index];
+    return parent >= 0 && mHidden[parent];
+}
+
+};
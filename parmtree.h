@@ -0,0 +1,51 @@
+#ifndef PARMTREE_H
+#define PARMTREE_H
+
+#include "HAPI_cpp.h"
+#include <vector>
+#include <unordered_map>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Parameter hierarchy index:
+
+// Indexes an asset's parms once so that id lookups, child lists and
+// visibility are O(1) queries. A parm is hidden when it or any of its
+// ancestors is invisible; this is resolved for every parm in a single
+// top-down pass over the hierarchy.
+class ParmTree
+{
+public:
+    ParmTree();
+    explicit ParmTree( const std::vector<Parm>& parms );
+
+    void                    build( const std::vector<Parm>& parms );
+    void                    clear();
+
+    int                     size() const { return int( mParms.size() ); }
+    const std::vector<Parm>& parms() const { return mParms; }
+    const Parm&             parm( int index ) const { return mParms[index]; }
+
+    // Returns -1 for ids that are not part of the tree.
+    int                     indexOf( HAPI_ParmId id ) const;
+    int                     parent( int index ) const { return mParent[index]; }
+    const std::vector<int>& children( int index ) const { return mChildren[index]; }
+    const std::vector<int>& roots() const { return mRoots; }
+
+    bool                    isHidden( int index ) const { return mHidden[index]; }
+    bool                    isParentHidden( int index ) const;
+
+private:
+    std::vector<Parm>                   mParms;
+    std::unordered_map<HAPI_ParmId, int> mIndex;
+    std::vector<int>                    mParent;
+    std::vector< std::vector<int> >     mChildren;
+    std::vector<int>                    mRoots;
+    std::vector<bool>                   mHidden;
+};
+
+}
+
+#endif // PARMTREE_H
@@ -0,0 +1,961 @@
+//
+// libHAPI for clients of HoudiniEngineServer, see engineserver.h. Built in
+// place of Houdini's libHAPI with qmake CONFIG+=hapi_remote: every HAPI
+// call becomes a request to the server over a local socket, so the engine,
+// its loaded libraries and its instantiated assets outlive the process.
+//
+// The first call connects, starting the server when none is running: the
+// program named by HOUDINI_ENGINE_SERVER, else HoudiniEngineServer next to
+// our executable or on the PATH. A connection that breaks stays broken
+// until the next HAPI_Initialize, so asset ids of a dead server are never
+// sent to a fresh one. Calls are serialized by one lock, as they are in
+// Houdini Engine itself.
+//
+
+#include "remoteprotocol.h"
+#include "cookcache.h"
+#include <HAPI/HAPI.h>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// How long a server we started gets to start listening.
+#define SERVER_START_TIMEOUT_MS     (30000)
+#define CONNECT_RETRY_MS            (20)
+
+using namespace hapi;
+
+//----------------------------------------------------------------------------
+// Connection:
+
+#ifdef _WIN32
+typedef HANDLE Channel;
+static const Channel NO_CHANNEL = INVALID_HANDLE_VALUE;
+#else
+typedef int Channel;
+static const Channel NO_CHANNEL = -1;
+#endif
+
+static std::mutex   sLock;
+static Channel      sChannel = NO_CHANNEL;
+// Why the last call failed without an answer from the server; what
+// HAPI_GetStatusString reports for HAPI_STATUS_CALL_RESULT meanwhile.
+static std::string  sError;
+static bool         sLocalError = false;
+// Buffer sizes of the last HAPI_GetStatusStringBufLength per status type.
+static int          sStatusLength[ HAPI_STATUS_MAX ] = { 0 };
+
+static HAPI_Result LocalFailure( const std::string& error )
+{
+    sError = error;
+    sLocalError = true;
+    return HAPI_RESULT_FAILURE;
+}
+
+static std::string ServerProgram()
+{
+    const char* program = getenv( "HOUDINI_ENGINE_SERVER" );
+    if ( program && *program )
+        return program;
+
+#ifdef _WIN32
+    char path[ MAX_PATH ];
+    DWORD length = GetModuleFileNameA( NULL, path, MAX_PATH );
+    std::string directory( path, length < MAX_PATH ? length : 0 );
+    size_t slash = directory.find_last_of( "\\/" );
+    if ( slash != std::string::npos )
+        return directory.substr( 0, slash + 1 ) + "HoudiniEngineServer.exe";
+    return "HoudiniEngineServer.exe";
+#else
+    char path[ PATH_MAX ];
+    ssize_t length = readlink( "/proc/self/exe", path, sizeof(path) - 1 );
+    if ( length > 0 )
+    {
+        std::string directory( path, size_t( length ) );
+        size_t slash = directory.rfind( '/' );
+        std::string candidate = directory.substr( 0, slash + 1 ) + "HoudiniEngineServer";
+        if ( access( candidate.c_str(), X_OK ) == 0 )
+            return candidate;
+    }
+    return "HoudiniEngineServer";
+#endif
+}
+
+#ifdef _WIN32
+
+static Channel Open( const std::string& name )
+{
+    std::string pipe = "\\\\.\\pipe\\" + name;
+    HANDLE handle = CreateFileA( pipe.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                                 OPEN_EXISTING, 0, NULL );
+    if ( handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY &&
+         WaitNamedPipeA( pipe.c_str(), SERVER_START_TIMEOUT_MS ) )
+        handle = CreateFileA( pipe.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                              OPEN_EXISTING, 0, NULL );
+    return handle;
+}
+
+static void Close( Channel channel )
+{
+    CloseHandle( channel );
+}
+
+static bool WriteAll( Channel channel, const char* data, size_t size )
+{
+    while ( size > 0 )
+    {
+        DWORD chunk = size > 0x10000000 ? 0x10000000 : DWORD( size );
+        DWORD written = 0;
+        if ( !WriteFile( channel, data, chunk, &written, NULL ) || written == 0 )
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static bool ReadAll( Channel channel, char* data, size_t size )
+{
+    while ( size > 0 )
+    {
+        DWORD chunk = size > 0x10000000 ? 0x10000000 : DWORD( size );
+        DWORD read = 0;
+        if ( !ReadFile( channel, data, chunk, &read, NULL ) || read == 0 )
+            return false;
+        data += read;
+        size -= read;
+    }
+    return true;
+}
+
+static bool StartServer( const std::string& program )
+{
+    std::string command = "\"" + program + "\"";
+    STARTUPINFOA startup;
+    PROCESS_INFORMATION process;
+    ZeroMemory( &startup, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    if ( !CreateProcessA( program.c_str(), &command[0], NULL, NULL, FALSE,
+                          DETACHED_PROCESS | CREATE_NEW_PROCESS_GROUP, NULL, NULL,
+                          &startup, &process ) )
+        return false;
+    CloseHandle( process.hThread );
+    CloseHandle( process.hProcess );
+    return true;
+}
+
+#else
+
+static Channel Open( const std::string& name )
+{
+    sockaddr_un address;
+    memset( &address, 0, sizeof(address) );
+    address.sun_family = AF_UNIX;
+    if ( name.size() >= sizeof(address.sun_path) )
+        return NO_CHANNEL;
+    memcpy( address.sun_path, name.c_str(), name.size() );
+
+    int channel = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( channel < 0 )
+        return NO_CHANNEL;
+    fcntl( channel, F_SETFD, FD_CLOEXEC );
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt( channel, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on) );
+#endif
+
+    int result;
+    do
+        result = connect( channel, reinterpret_cast<sockaddr*>( &address ), sizeof(address) );
+    while ( result < 0 && errno == EINTR );
+    if ( result < 0 )
+    {
+        close( channel );
+        return NO_CHANNEL;
+    }
+    return channel;
+}
+
+static void Close( Channel channel )
+{
+    close( channel );
+}
+
+static bool WriteAll( Channel channel, const char* data, size_t size )
+{
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while ( size > 0 )
+    {
+        ssize_t written = send( channel, data, size, flags );
+        if ( written < 0 && errno == EINTR )
+            continue;
+        if ( written <= 0 )
+            return false;
+        data += written;
+        size -= size_t( written );
+    }
+    return true;
+}
+
+static bool ReadAll( Channel channel, char* data, size_t size )
+{
+    while ( size > 0 )
+    {
+        ssize_t read = recv( channel, data, size, 0 );
+        if ( read < 0 && errno == EINTR )
+            continue;
+        if ( read <= 0 )
+            return false;
+        data += read;
+        size -= size_t( read );
+    }
+    return true;
+}
+
+// Detached twice, so the server is nobody's child and outlives us. It gets
+// our stderr but not our stdin or stdout, which may be a CookFarm pipe.
+static bool StartServer( const std::string& program )
+{
+    pid_t child = fork();
+    if ( child < 0 )
+        return false;
+    if ( child == 0 )
+    {
+        setsid();
+        if ( fork() != 0 )
+            _exit( 0 );
+
+        int null = open( "/dev/null", O_RDWR );
+        dup2( null, 0 );
+        dup2( null, 1 );
+        for ( int fd = 3; fd < 1024; ++fd )
+            close( fd );
+        execlp( program.c_str(), program.c_str(), (char*)nullptr );
+        _exit( 127 );
+    }
+
+    int status;
+    while ( waitpid( child, &status, 0 ) < 0 && errno == EINTR )
+        ;
+    return true;
+}
+
+#endif
+
+static void Disconnect()
+{
+    if ( sChannel != NO_CHANNEL )
+        Close( sChannel );
+    sChannel = NO_CHANNEL;
+}
+
+static bool Exchange( const RemoteMessage& request, RemoteMessage& reply )
+{
+    uint32_t size = uint32_t( request.size() );
+    if ( !WriteAll( sChannel, reinterpret_cast<const char*>( &size ), sizeof(size) ) ||
+         !WriteAll( sChannel, request.data(), request.size() ) ||
+         !ReadAll( sChannel, reinterpret_cast<char*>( &size ), sizeof(size) ) ||
+         size > REMOTE_MAX_MESSAGE_SIZE ||
+         !ReadAll( sChannel, reply.prepare( size ), size ) )
+    {
+        Disconnect();
+        return false;
+    }
+    return true;
+}
+
+static bool Connect()
+{
+    if ( sChannel != NO_CHANNEL )
+        return true;
+
+    std::string name = RemoteServerName();
+    sChannel = Open( name );
+    if ( sChannel == NO_CHANNEL )
+    {
+        std::string program = ServerProgram();
+        if ( !StartServer( program ) )
+        {
+            LocalFailure( "cannot start " + program );
+            return false;
+        }
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                std::chrono::milliseconds( SERVER_START_TIMEOUT_MS );
+        while ( ( sChannel = Open( name ) ) == NO_CHANNEL )
+        {
+            if ( std::chrono::steady_clock::now() > deadline )
+            {
+                LocalFailure( program + " did not start listening on " + name );
+                return false;
+            }
+            std::this_thread::sleep_for( std::chrono::milliseconds( CONNECT_RETRY_MS ) );
+        }
+    }
+
+    // A server we just started answers once its engine is up.
+    RemoteMessage request, reply;
+    request << uint32_t( REMOTE_HELLO ) << uint32_t( REMOTE_PROTOCOL_VERSION )
+            << RemoteStructSignature();
+    if ( !Exchange( request, reply ) )
+    {
+        LocalFailure( "HoudiniEngineServer closed the connection while starting" );
+        return false;
+    }
+
+    int32_t result = HAPI_RESULT_FAILURE;
+    reply >> result;
+    if ( result != HAPI_RESULT_SUCCESS )
+    {
+        const char* error = reply.readString();
+        Disconnect();
+        LocalFailure( error ? error : "HoudiniEngineServer refused the connection" );
+        return false;
+    }
+    return true;
+}
+
+// Sends request and waits for the reply, whose HAPI_Result has been read
+// already. Only connects when connect is set; see the top of the file.
+static HAPI_Result Call( const RemoteMessage& request, RemoteMessage& reply,
+                         bool connect = false )
+{
+    std::lock_guard<std::mutex> lock( sLock );
+
+    if ( sChannel == NO_CHANNEL && !( connect && Connect() ) )
+    {
+        if ( !connect )
+            LocalFailure( "not connected to HoudiniEngineServer" );
+        return HAPI_RESULT_FAILURE;
+    }
+    if ( !Exchange( request, reply ) )
+        return LocalFailure( "lost the connection to HoudiniEngineServer" );
+
+    int32_t result = HAPI_RESULT_FAILURE;
+    reply >> result;
+    if ( !reply.ok() )
+        return LocalFailure( "malformed reply from HoudiniEngineServer" );
+
+    sLocalError = false;
+    return HAPI_Result( result );
+}
+
+// The outputs of a successful call are read after Call() returns; a reply
+// too short for them is treated like a broken connection.
+static HAPI_Result Outputs( HAPI_Result result, const RemoteMessage& reply )
+{
+    if ( result == HAPI_RESULT_SUCCESS && !reply.ok() )
+    {
+        std::lock_guard<std::mutex> lock( sLock );
+        Disconnect();
+        return LocalFailure( "malformed reply from HoudiniEngineServer" );
+    }
+    return result;
+}
+
+static RemoteMessage Request( RemoteOpcode opcode )
+{
+    RemoteMessage request;
+    request << uint32_t( opcode );
+    return request;
+}
+
+//----------------------------------------------------------------------------
+// Sessions and status:
+
+HAPI_CookOptions HAPI_CookOptions_Create()
+{
+    HAPI_CookOptions options;
+    memset( &options, 0, sizeof(options) );
+
+    RemoteMessage reply;
+    HAPI_Result result = Call( Request( REMOTE_COOK_OPTIONS_CREATE ), reply, true );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> options;
+    return options;
+}
+
+HAPI_Result HAPI_IsInitialized()
+{
+    RemoteMessage reply;
+    HAPI_Result result = Call( Request( REMOTE_IS_INITIALIZED ), reply );
+    return result == HAPI_RESULT_FAILURE ? HAPI_RESULT_NOT_INITIALIZED : result;
+}
+
+HAPI_Result HAPI_Initialize( const char * otl_search_path,
+                             const char * dso_search_path,
+                             const HAPI_CookOptions * cook_options,
+                             HAPI_Bool use_cooking_thread,
+                             int cooking_thread_stack_size )
+{
+    RemoteMessage request = Request( REMOTE_INITIALIZE ), reply;
+    request << otl_search_path << dso_search_path << int32_t( cook_options ? 1 : 0 );
+    if ( cook_options )
+        request << *cook_options;
+    request << int32_t( use_cooking_thread ) << int32_t( cooking_thread_stack_size );
+    return Call( request, reply, true );
+}
+
+HAPI_Result HAPI_Cleanup()
+{
+    RemoteMessage reply;
+    return Call( Request( REMOTE_CLEANUP ), reply );
+}
+
+HAPI_Result HAPI_GetStatus( HAPI_StatusType status_type, int * status )
+{
+    RemoteMessage request = Request( REMOTE_GET_STATUS ), reply;
+    request << int32_t( status_type );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *status;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetStatusStringBufLength( HAPI_StatusType status_type,
+                                           HAPI_StatusVerbosity verbosity,
+                                           int * buffer_size )
+{
+    if ( status_type < 0 || status_type >= HAPI_STATUS_MAX )
+        return HAPI_RESULT_INVALID_ARGUMENT;
+
+    {
+        std::lock_guard<std::mutex> lock( sLock );
+        if ( sLocalError && status_type == HAPI_STATUS_CALL_RESULT )
+        {
+            *buffer_size = sStatusLength[ status_type ] = int( sError.size() ) + 1;
+            return HAPI_RESULT_SUCCESS;
+        }
+    }
+
+    RemoteMessage request = Request( REMOTE_GET_STATUS_STRING_BUF_LENGTH ), reply;
+    request << int32_t( status_type ) << int32_t( verbosity );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+    {
+        reply >> *buffer_size;
+        sStatusLength[ status_type ] = *buffer_size;
+    }
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetStatusString( HAPI_StatusType status_type, char * buffer )
+{
+    if ( status_type < 0 || status_type >= HAPI_STATUS_MAX )
+        return HAPI_RESULT_INVALID_ARGUMENT;
+
+    int length;
+    {
+        std::lock_guard<std::mutex> lock( sLock );
+        length = sStatusLength[ status_type ];
+        if ( sLocalError && status_type == HAPI_STATUS_CALL_RESULT )
+        {
+            if ( length > 0 )
+            {
+                strncpy( buffer, sError.c_str(), size_t( length ) );
+                buffer[ length - 1 ] = 0;
+            }
+            return HAPI_RESULT_SUCCESS;
+        }
+    }
+
+    RemoteMessage request = Request( REMOTE_GET_STATUS_STRING ), reply;
+    request << int32_t( status_type ) << int32_t( length );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( buffer, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetCookingTotalCount( int * count )
+{
+    RemoteMessage reply;
+    HAPI_Result result = Call( Request( REMOTE_GET_COOKING_TOTAL_COUNT ), reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *count;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetCookingCurrentCount( int * count )
+{
+    RemoteMessage reply;
+    HAPI_Result result = Call( Request( REMOTE_GET_COOKING_CURRENT_COUNT ), reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *count;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_Interrupt()
+{
+    RemoteMessage reply;
+    return Call( Request( REMOTE_INTERRUPT ), reply );
+}
+
+//----------------------------------------------------------------------------
+// Strings:
+
+HAPI_Result HAPI_GetStringBufLength( HAPI_StringHandle string_handle, int * buffer_length )
+{
+    RemoteMessage request = Request( REMOTE_GET_STRING_BUF_LENGTH ), reply;
+    request << string_handle;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *buffer_length;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetString( HAPI_StringHandle string_handle, char * string_value,
+                            int buffer_length )
+{
+    RemoteMessage request = Request( REMOTE_GET_STRING ), reply;
+    request << string_handle << buffer_length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( string_value, buffer_length );
+    return Outputs( result, reply );
+}
+
+//----------------------------------------------------------------------------
+// Assets:
+
+HAPI_Result HAPI_LoadAssetLibraryFromFile( const char * file_path,
+                                           HAPI_Bool allow_overwrite,
+                                           HAPI_AssetLibraryId * library_id )
+{
+    RemoteMessage request = Request( REMOTE_LOAD_ASSET_LIBRARY_FROM_FILE ), reply;
+    request << file_path << int32_t( allow_overwrite );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *library_id;
+    return Outputs( result, reply );
+}
+
+// Libraries the server already holds are found by hash and not sent again.
+HAPI_Result HAPI_LoadAssetLibraryFromMemory( const char * library_buffer,
+                                             int library_buffer_size,
+                                             HAPI_Bool allow_overwrite,
+                                             HAPI_AssetLibraryId * library_id )
+{
+    if ( !library_buffer || library_buffer_size <= 0 )
+        return HAPI_RESULT_INVALID_ARGUMENT;
+
+    // The only pass over the bytes: the engine wrapper compares libraries
+    // by file stamp, and the server takes this hash with the load.
+    uint64_t hash = CookCache::hashData( library_buffer, size_t( library_buffer_size ) );
+    RemoteMessage find = Request( REMOTE_FIND_LIBRARY ), found;
+    find << hash;
+    HAPI_Result result = Call( find, found );
+    if ( result != HAPI_RESULT_SUCCESS )
+        return result;
+
+    int32_t known = -1;
+    found >> known;
+    if ( found.ok() && known >= 0 )
+    {
+        *library_id = known;
+        return HAPI_RESULT_SUCCESS;
+    }
+
+    RemoteMessage request = Request( REMOTE_LOAD_ASSET_LIBRARY_FROM_MEMORY ), reply;
+    request << hash << int32_t( allow_overwrite ) << int32_t( library_buffer_size );
+    request.write( library_buffer, library_buffer_size );
+    result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *library_id;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetAvailableAssetCount( HAPI_AssetLibraryId library_id, int * asset_count )
+{
+    RemoteMessage request = Request( REMOTE_GET_AVAILABLE_ASSET_COUNT ), reply;
+    request << library_id;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *asset_count;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetAvailableAssets( HAPI_AssetLibraryId library_id,
+                                     HAPI_StringHandle * asset_names_array,
+                                     int asset_count )
+{
+    RemoteMessage request = Request( REMOTE_GET_AVAILABLE_ASSETS ), reply;
+    request << library_id << asset_count;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( asset_names_array, asset_count );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_InstantiateAsset( const char * asset_name, HAPI_Bool cook_on_load,
+                                   HAPI_AssetId * asset_id )
+{
+    RemoteMessage request = Request( REMOTE_INSTANTIATE_ASSET ), reply;
+    request << asset_name << int32_t( cook_on_load );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *asset_id;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_DestroyAsset( HAPI_AssetId asset_id )
+{
+    RemoteMessage request = Request( REMOTE_DESTROY_ASSET ), reply;
+    request << asset_id;
+    return Call( request, reply );
+}
+
+HAPI_Result HAPI_GetAssetInfo( HAPI_AssetId asset_id, HAPI_AssetInfo * asset_info )
+{
+    RemoteMessage request = Request( REMOTE_GET_ASSET_INFO ), reply;
+    request << asset_id;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *asset_info;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_CookAsset( HAPI_AssetId asset_id, const HAPI_CookOptions * cook_options )
+{
+    RemoteMessage request = Request( REMOTE_COOK_ASSET ), reply;
+    request << asset_id << int32_t( cook_options ? 1 : 0 );
+    if ( cook_options )
+        request << *cook_options;
+    return Call( request, reply );
+}
+
+HAPI_Result HAPI_IsAssetValid( HAPI_AssetId asset_id, int asset_validation_id,
+                               int * answer )
+{
+    RemoteMessage request = Request( REMOTE_IS_ASSET_VALID ), reply;
+    request << asset_id << asset_validation_id;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *answer;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetAssetTransform( HAPI_AssetId asset_id, HAPI_RSTOrder rst_order,
+                                    HAPI_XYZOrder rot_order,
+                                    HAPI_TransformEuler * transform )
+{
+    RemoteMessage request = Request( REMOTE_GET_ASSET_TRANSFORM ), reply;
+    request << asset_id << int32_t( rst_order ) << int32_t( rot_order );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *transform;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_ConvertTransformEulerToMatrix( const HAPI_TransformEuler * transform,
+                                                float * matrix )
+{
+    RemoteMessage request = Request( REMOTE_CONVERT_TRANSFORM_EULER_TO_MATRIX ), reply;
+    request << *transform;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( matrix, 16 );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_ConvertTransformQuatToMatrix( const HAPI_Transform * transform,
+                                               float * matrix )
+{
+    RemoteMessage request = Request( REMOTE_CONVERT_TRANSFORM_QUAT_TO_MATRIX ), reply;
+    request << *transform;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( matrix, 16 );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetInputName( HAPI_AssetId asset_id, int input_idx, int input_type,
+                               HAPI_StringHandle * name )
+{
+    RemoteMessage request = Request( REMOTE_GET_INPUT_NAME ), reply;
+    request << asset_id << input_idx << input_type;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *name;
+    return Outputs( result, reply );
+}
+
+//----------------------------------------------------------------------------
+// Nodes and parms:
+
+HAPI_Result HAPI_GetNodeInfo( HAPI_NodeId node_id, HAPI_NodeInfo * node_info )
+{
+    RemoteMessage request = Request( REMOTE_GET_NODE_INFO ), reply;
+    request << node_id;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *node_info;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetParameters( HAPI_NodeId node_id, HAPI_ParmInfo * parm_infos,
+                                int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_PARAMETERS ), reply;
+    request << node_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( parm_infos, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetParmIntValues( HAPI_NodeId node_id, int * values,
+                                   int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_PARM_INT_VALUES ), reply;
+    request << node_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( values, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetParmFloatValues( HAPI_NodeId node_id, float * values,
+                                     int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_PARM_FLOAT_VALUES ), reply;
+    request << node_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( values, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetParmStringValues( HAPI_NodeId node_id, HAPI_Bool evaluate,
+                                      HAPI_StringHandle * values,
+                                      int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_PARM_STRING_VALUES ), reply;
+    request << node_id << int32_t( evaluate ) << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( values, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetParmChoiceLists( HAPI_NodeId node_id,
+                                     HAPI_ParmChoiceInfo * parm_choices,
+                                     int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_PARM_CHOICE_LISTS ), reply;
+    request << node_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( parm_choices, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_SetParmIntValues( HAPI_NodeId node_id, const int * values,
+                                   int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_SET_PARM_INT_VALUES ), reply;
+    request << node_id << start << length;
+    request.write( values, length );
+    return Call( request, reply );
+}
+
+HAPI_Result HAPI_SetParmFloatValues( HAPI_NodeId node_id, const float * values,
+                                     int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_SET_PARM_FLOAT_VALUES ), reply;
+    request << node_id << start << length;
+    request.write( values, length );
+    return Call( request, reply );
+}
+
+HAPI_Result HAPI_SetParmStringValue( HAPI_NodeId node_id, const char * value,
+                                     HAPI_ParmId parm_id, int index )
+{
+    RemoteMessage request = Request( REMOTE_SET_PARM_STRING_VALUE ), reply;
+    request << node_id << value << parm_id << index;
+    return Call( request, reply );
+}
+
+HAPI_Result HAPI_InsertMultiparmInstance( HAPI_NodeId node_id, HAPI_ParmId parm_id,
+                                          int instance_position )
+{
+    RemoteMessage request = Request( REMOTE_INSERT_MULTIPARM_INSTANCE ), reply;
+    request << node_id << parm_id << instance_position;
+    return Call( request, reply );
+}
+
+HAPI_Result HAPI_RemoveMultiparmInstance( HAPI_NodeId node_id, HAPI_ParmId parm_id,
+                                          int instance_position )
+{
+    RemoteMessage request = Request( REMOTE_REMOVE_MULTIPARM_INSTANCE ), reply;
+    request << node_id << parm_id << instance_position;
+    return Call( request, reply );
+}
+
+//----------------------------------------------------------------------------
+// Objects, geos and parts:
+
+HAPI_Result HAPI_GetObjects( HAPI_AssetId asset_id, HAPI_ObjectInfo * object_infos,
+                             int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_OBJECTS ), reply;
+    request << asset_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( object_infos, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetObjectTransforms( HAPI_AssetId asset_id, HAPI_RSTOrder rst_order,
+                                      HAPI_Transform * transforms,
+                                      int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_OBJECT_TRANSFORMS ), reply;
+    request << asset_id << int32_t( rst_order ) << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( transforms, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetGeoInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                             HAPI_GeoId geo_id, HAPI_GeoInfo * geo_info )
+{
+    RemoteMessage request = Request( REMOTE_GET_GEO_INFO ), reply;
+    request << asset_id << object_id << geo_id;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *geo_info;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetPartInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                              HAPI_GeoId geo_id, HAPI_PartId part_id,
+                              HAPI_PartInfo * part_info )
+{
+    RemoteMessage request = Request( REMOTE_GET_PART_INFO ), reply;
+    request << asset_id << object_id << geo_id << part_id;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *part_info;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetFaceCounts( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                int * face_counts, int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_FACE_COUNTS ), reply;
+    request << asset_id << object_id << geo_id << part_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( face_counts, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetVertexList( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                int * vertex_list, int start, int length )
+{
+    RemoteMessage request = Request( REMOTE_GET_VERTEX_LIST ), reply;
+    request << asset_id << object_id << geo_id << part_id << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( vertex_list, length );
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetAttributeInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                   HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                   const char * name, HAPI_AttributeOwner owner,
+                                   HAPI_AttributeInfo * attr_info )
+{
+    RemoteMessage request = Request( REMOTE_GET_ATTRIBUTE_INFO ), reply;
+    request << asset_id << object_id << geo_id << part_id << name << int32_t( owner );
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply >> *attr_info;
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetAttributeNames( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                    HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                    HAPI_AttributeOwner owner,
+                                    HAPI_StringHandle * attribute_names_array,
+                                    int count )
+{
+    RemoteMessage request = Request( REMOTE_GET_ATTRIBUTE_NAMES ), reply;
+    request << asset_id << object_id << geo_id << part_id << int32_t( owner ) << count;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+        reply.read( attribute_names_array, count );
+    return Outputs( result, reply );
+}
+
+// The attribute data calls take the attribute info in and hand it back,
+// possibly updated; the data holds length tuples.
+template <typename T>
+static HAPI_Result GetAttributeData( RemoteOpcode opcode,
+                                     HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                     HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                     const char * name, HAPI_AttributeInfo * attr_info,
+                                     T * data, int start, int length )
+{
+    RemoteMessage request = Request( opcode ), reply;
+    request << asset_id << object_id << geo_id << part_id << name << *attr_info
+            << start << length;
+    HAPI_Result result = Call( request, reply );
+    if ( result == HAPI_RESULT_SUCCESS )
+    {
+        int count = length * attr_info->tupleSize;
+        reply >> *attr_info;
+        reply.read( data, count );
+    }
+    return Outputs( result, reply );
+}
+
+HAPI_Result HAPI_GetAttributeIntData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                      HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                      const char * name, HAPI_AttributeInfo * attr_info,
+                                      int * data, int start, int length )
+{
+    return GetAttributeData( REMOTE_GET_ATTRIBUTE_INT_DATA, asset_id, object_id, geo_id,
+                             part_id, name, attr_info, data, start, length );
+}
+
+HAPI_Result HAPI_GetAttributeFloatData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                        HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                        const char * name, HAPI_AttributeInfo * attr_info,
+                                        float * data, int start, int length )
+{
+    return GetAttributeData( REMOTE_GET_ATTRIBUTE_FLOAT_DATA, asset_id, object_id, geo_id,
+                             part_id, name, attr_info, data, start, length );
+}
+
+HAPI_Result HAPI_GetAttributeStringData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                         HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                         const char * name, HAPI_AttributeInfo * attr_info,
+                                         HAPI_StringHandle * data, int start, int length )
+{
+    return GetAttributeData( REMOTE_GET_ATTRIBUTE_STRING_DATA, asset_id, object_id, geo_id,
+                             part_id, name, attr_info, data, start, length );
+}
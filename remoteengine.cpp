@@ -0,0 +1,1065 @@
+#include "remoteengine.h"
+#include "cookcache.h"
+#include "infocache.h"
+#include "mappedfile.h"
+#include "stringcache.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#define DEFAULT_MAX_IDLE_ASSETS     (8)
+#define DEFAULT_MAX_LIBRARIES       (16)
+#define DEFAULT_IDLE_TIMEOUT        (600)
+#define POLL_INTERVAL_MS            (2)
+
+namespace hapi {
+
+// Loads and cooks return right away, the engine has a cooking thread.
+static bool WaitForReady()
+{
+    int state = HAPI_STATE_STARTING_COOK;
+    while ( state > HAPI_STATE_MAX_READY_STATE )
+    {
+        if ( HAPI_TRACE( HAPI_GetStatus( HAPI_STATUS_COOK_STATE, &state ) ) != HAPI_RESULT_SUCCESS )
+            return false;
+        if ( state > HAPI_STATE_MAX_READY_STATE )
+            std::this_thread::sleep_for( std::chrono::milliseconds( POLL_INTERVAL_MS ) );
+    }
+    return state != HAPI_STATE_READY_WITH_FATAL_ERRORS;
+}
+
+static std::vector<std::string> ListAssets( int library_id )
+{
+    std::vector<std::string> names;
+    int count = 0;
+    if ( HAPI_TRACE( HAPI_GetAvailableAssetCount( library_id, &count ) ) != HAPI_RESULT_SUCCESS ||
+         count <= 0 )
+        return names;
+
+    std::vector<HAPI_StringHandle> handles( count );
+    if ( HAPI_TRACE( HAPI_GetAvailableAssets( library_id, &handles[0], count ) ) !=
+         HAPI_RESULT_SUCCESS )
+        return names;
+
+    for ( int i = 0; i < count; ++i )
+        names.push_back( getString( handles[i] ) );
+    return names;
+}
+
+// Client sizes are checked before anything is allocated for them.
+static bool ValidCount( int count, size_t element_size )
+{
+    return count >= 0 && size_t( count ) <= REMOTE_MAX_MESSAGE_SIZE / element_size;
+}
+
+template <typename T>
+static T* Data( std::vector<T>& values )
+{
+    return values.empty() ? nullptr : &values[0];
+}
+
+static bool Reply( RemoteMessage& reply, HAPI_Result result )
+{
+    reply << int32_t( result );
+    return result == HAPI_RESULT_SUCCESS;
+}
+
+RemoteEngine::RemoteEngine() :
+    mMaxIdleAssets(DEFAULT_MAX_IDLE_ASSETS),
+    mMaxLibraries(DEFAULT_MAX_LIBRARIES),
+    mIdleTimeout(DEFAULT_IDLE_TIMEOUT),
+    mReused(0),
+    mInstantiated(0),
+    mFailed(false)
+{
+}
+
+RemoteEngine::~RemoteEngine()
+{
+    Engine::getInstance()->cleanup();
+}
+
+bool RemoteEngine::initialize()
+{
+    Engine* hapi = Engine::getInstance();
+    if ( !hapi->initialize( nullptr, nullptr, true, -1 ) )
+    {
+        mError = hapi->getLastError();
+        return false;
+    }
+    return true;
+}
+
+int RemoteEngine::idleAssetCount() const
+{
+    int count = 0;
+    for ( std::map<int, Instance>::const_iterator it = mInstances.begin();
+          it != mInstances.end(); ++it )
+        if ( it->second.owner < 0 )
+            ++count;
+    return count;
+}
+
+void RemoteEngine::handle( int client_id, RemoteMessage& request, RemoteMessage& reply )
+{
+    Client& client = mClients[ client_id ];
+    reply.clear();
+
+    uint32_t opcode = 0;
+    request >> opcode;
+
+    if ( opcode == REMOTE_HELLO )
+    {
+        uint32_t version = 0, signature = 0;
+        request >> version >> signature;
+        if ( version != REMOTE_PROTOCOL_VERSION || signature != RemoteStructSignature() )
+        {
+            Reply( reply, HAPI_RESULT_FAILURE );
+            reply << "HoudiniEngineServer was built from another version; stop it and retry";
+            return;
+        }
+        client.greeted = true;
+        Reply( reply, mFailed ? HAPI_RESULT_FAILURE : HAPI_RESULT_SUCCESS );
+        if ( mFailed )
+            reply << mError;
+        return;
+    }
+    if ( !client.greeted || mFailed || !request.ok() )
+    {
+        Reply( reply, HAPI_RESULT_FAILURE );
+        return;
+    }
+
+    switch ( opcode )
+    {
+    case REMOTE_FIND_LIBRARY:
+    {
+        uint64_t hash = 0;
+        request >> hash;
+        if ( !request.ok() )
+            break;
+
+        int32_t library_id = -1;
+        for ( size_t i = 0; i < mLibraries.size(); ++i )
+            if ( mLibraries[i].hash == hash )
+            {
+                mLibraries[i].used = Clock::now();
+                library_id = mLibraries[i].id;
+            }
+        Reply( reply, HAPI_RESULT_SUCCESS );
+        reply << library_id;
+        return;
+    }
+
+    //------------------------------------------------------------------------
+    // Sessions and status:
+
+    case REMOTE_COOK_OPTIONS_CREATE:
+        Reply( reply, HAPI_RESULT_SUCCESS );
+        reply << HAPI_CookOptions_Create();
+        return;
+
+    case REMOTE_IS_INITIALIZED:
+        Reply( reply, client.initialized ? HAPI_RESULT_SUCCESS : HAPI_RESULT_NOT_INITIALIZED );
+        return;
+
+    case REMOTE_INITIALIZE:
+    {
+        HAPI_CookOptions cook_options;
+        int32_t has_cook_options = 0, use_cooking_thread = 0, stack_size = 0;
+        request.readString();
+        request.readString();
+        request >> has_cook_options;
+        if ( has_cook_options )
+            request >> cook_options;
+        request >> use_cooking_thread >> stack_size;
+        if ( !request.ok() )
+            break;
+
+        if ( client.initialized )
+        {
+            Reply( reply, HAPI_RESULT_ALREADY_INITIALIZED );
+            return;
+        }
+        client.initialized = true;
+        client.synchronous = !use_cooking_thread;
+        Reply( reply, HAPI_RESULT_SUCCESS );
+        return;
+    }
+
+    case REMOTE_CLEANUP:
+        park( client_id );
+        client.initialized = false;
+        Reply( reply, HAPI_RESULT_SUCCESS );
+        return;
+
+    case REMOTE_GET_STATUS:
+    {
+        int32_t status_type = 0;
+        request >> status_type;
+        if ( !request.ok() )
+            break;
+
+        int status = 0;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetStatus( HAPI_StatusType( status_type ), &status ) ) ) )
+            reply << status;
+        return;
+    }
+
+    case REMOTE_GET_STATUS_STRING_BUF_LENGTH:
+    {
+        int32_t status_type = 0, verbosity = 0;
+        request >> status_type >> verbosity;
+        if ( !request.ok() || status_type < 0 || status_type >= HAPI_STATUS_MAX )
+            break;
+
+        // The string is taken right away, as another client's calls may
+        // change the status before this one asks for it.
+        int buffer_size = 0;
+        HAPI_Result result = HAPI_TRACE( HAPI_GetStatusStringBufLength(
+                    HAPI_StatusType( status_type ), HAPI_StatusVerbosity( verbosity ),
+                    &buffer_size ) );
+        std::string& status = client.status[ status_type ];
+        status.clear();
+        if ( result == HAPI_RESULT_SUCCESS && buffer_size > 0 )
+        {
+            std::vector<char> buffer( buffer_size, 0 );
+            result = HAPI_TRACE( HAPI_GetStatusString( HAPI_StatusType( status_type ),
+                                                       Data( buffer ) ) );
+            buffer[ buffer_size - 1 ] = 0;
+            status = Data( buffer );
+        }
+        if ( Reply( reply, result ) )
+            reply << buffer_size;
+        return;
+    }
+
+    case REMOTE_GET_STATUS_STRING:
+    {
+        int32_t status_type = 0, length = 0;
+        request >> status_type >> length;
+        if ( !request.ok() || status_type < 0 || status_type >= HAPI_STATUS_MAX ||
+             !ValidCount( length, 1 ) )
+            break;
+
+        std::vector<char> buffer( length, 0 );
+        if ( length > 0 )
+            strncpy( Data( buffer ), client.status[ status_type ].c_str(), size_t( length - 1 ) );
+        Reply( reply, HAPI_RESULT_SUCCESS );
+        reply.write( Data( buffer ), length );
+        return;
+    }
+
+    case REMOTE_GET_COOKING_TOTAL_COUNT:
+    case REMOTE_GET_COOKING_CURRENT_COUNT:
+    {
+        int count = 0;
+        HAPI_Result result = opcode == REMOTE_GET_COOKING_TOTAL_COUNT
+                ? HAPI_TRACE( HAPI_GetCookingTotalCount( &count ) )
+                : HAPI_TRACE( HAPI_GetCookingCurrentCount( &count ) );
+        if ( Reply( reply, result ) )
+            reply << count;
+        return;
+    }
+
+    case REMOTE_INTERRUPT:
+        Reply( reply, HAPI_TRACE( HAPI_Interrupt() ) );
+        return;
+
+    //------------------------------------------------------------------------
+    // Strings:
+
+    case REMOTE_GET_STRING_BUF_LENGTH:
+    {
+        int32_t string_handle = 0;
+        request >> string_handle;
+        if ( !request.ok() )
+            break;
+
+        int buffer_length = 0;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetStringBufLength( string_handle, &buffer_length ) ) ) )
+            reply << buffer_length;
+        return;
+    }
+
+    case REMOTE_GET_STRING:
+    {
+        int32_t string_handle = 0, length = 0;
+        request >> string_handle >> length;
+        if ( !request.ok() || !ValidCount( length, 1 ) )
+            break;
+
+        std::vector<char> buffer( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetString( string_handle, Data( buffer ), length ) ) ) )
+            reply.write( Data( buffer ), length );
+        return;
+    }
+
+    //------------------------------------------------------------------------
+    // Assets:
+
+    case REMOTE_LOAD_ASSET_LIBRARY_FROM_FILE:
+    {
+        int32_t allow_overwrite = 0;
+        const char* path = request.readString();
+        request >> allow_overwrite;
+        if ( !request.ok() || !path )
+            break;
+
+        int library_id = -1;
+        if ( Reply( reply, loadLibraryFile( path, allow_overwrite != 0, library_id ) ) )
+            reply << library_id;
+        return;
+    }
+
+    case REMOTE_LOAD_ASSET_LIBRARY_FROM_MEMORY:
+    {
+        uint64_t hash = 0;
+        int32_t allow_overwrite = 0, size = 0;
+        request >> hash >> allow_overwrite >> size;
+        const char* data = size > 0 ? request.readBytes( size_t( size ) ) : nullptr;
+        if ( !request.ok() || !data )
+            break;
+
+        int library_id = -1;
+        if ( Reply( reply, loadLibrary( data, size_t( size ), hash, allow_overwrite != 0,
+                                        library_id ) ) )
+            reply << library_id;
+        return;
+    }
+
+    case REMOTE_GET_AVAILABLE_ASSET_COUNT:
+    {
+        int32_t library_id = 0;
+        request >> library_id;
+        if ( !request.ok() )
+            break;
+
+        int count = 0;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetAvailableAssetCount( library_id, &count ) ) ) )
+            reply << count;
+        return;
+    }
+
+    case REMOTE_GET_AVAILABLE_ASSETS:
+    {
+        int32_t library_id = 0, count = 0;
+        request >> library_id >> count;
+        if ( !request.ok() || !ValidCount( count, sizeof(HAPI_StringHandle) ) )
+            break;
+
+        std::vector<HAPI_StringHandle> handles( count );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetAvailableAssets( library_id, Data( handles ),
+                                                                count ) ) ) )
+            reply.write( Data( handles ), count );
+        return;
+    }
+
+    case REMOTE_INSTANTIATE_ASSET:
+    {
+        int32_t cook_on_load = 0;
+        const char* name = request.readString();
+        request >> cook_on_load;
+        if ( !request.ok() || !name )
+            break;
+
+        int asset_id = -1;
+        if ( Reply( reply, instantiate( client, client_id, name, cook_on_load != 0, asset_id ) ) )
+            reply << asset_id;
+        return;
+    }
+
+    case REMOTE_DESTROY_ASSET:
+    {
+        int32_t asset_id = -1;
+        request >> asset_id;
+        if ( !request.ok() )
+            break;
+
+        Reply( reply, destroy( client_id, asset_id ) );
+        return;
+    }
+
+    case REMOTE_GET_ASSET_INFO:
+    {
+        int32_t asset_id = -1;
+        request >> asset_id;
+        if ( !request.ok() )
+            break;
+
+        HAPI_AssetInfo info;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetAssetInfo( asset_id, &info ) ) ) )
+            reply << info;
+        return;
+    }
+
+    case REMOTE_COOK_ASSET:
+    {
+        HAPI_CookOptions cook_options;
+        int32_t asset_id = -1, has_cook_options = 0;
+        request >> asset_id >> has_cook_options;
+        if ( has_cook_options )
+            request >> cook_options;
+        if ( !request.ok() )
+            break;
+
+        HAPI_Result result = HAPI_TRACE( HAPI_CookAsset(
+                    asset_id, has_cook_options ? &cook_options : nullptr ) );
+        if ( result == HAPI_RESULT_SUCCESS )
+        {
+            std::map<int, Instance>::iterator it = mInstances.find( asset_id );
+            if ( it != mInstances.end() )
+                it->second.cooked = true;
+            if ( client.synchronous )
+                WaitForReady();
+        }
+        Reply( reply, result );
+        return;
+    }
+
+    case REMOTE_IS_ASSET_VALID:
+    {
+        int32_t asset_id = -1, validation_id = 0;
+        request >> asset_id >> validation_id;
+        if ( !request.ok() )
+            break;
+
+        int answer = 0;
+        if ( Reply( reply, HAPI_TRACE( HAPI_IsAssetValid( asset_id, validation_id, &answer ) ) ) )
+            reply << answer;
+        return;
+    }
+
+    case REMOTE_GET_ASSET_TRANSFORM:
+    {
+        int32_t asset_id = -1, rst_order = 0, rot_order = 0;
+        request >> asset_id >> rst_order >> rot_order;
+        if ( !request.ok() )
+            break;
+
+        HAPI_TransformEuler transform;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetAssetTransform(
+                        asset_id, HAPI_RSTOrder( rst_order ), HAPI_XYZOrder( rot_order ),
+                        &transform ) ) ) )
+            reply << transform;
+        return;
+    }
+
+    case REMOTE_CONVERT_TRANSFORM_EULER_TO_MATRIX:
+    {
+        HAPI_TransformEuler transform;
+        request >> transform;
+        if ( !request.ok() )
+            break;
+
+        float matrix[16];
+        if ( Reply( reply, HAPI_TRACE( HAPI_ConvertTransformEulerToMatrix( &transform, matrix ) ) ) )
+            reply.write( matrix, 16 );
+        return;
+    }
+
+    case REMOTE_CONVERT_TRANSFORM_QUAT_TO_MATRIX:
+    {
+        HAPI_Transform transform;
+        request >> transform;
+        if ( !request.ok() )
+            break;
+
+        float matrix[16];
+        if ( Reply( reply, HAPI_TRACE( HAPI_ConvertTransformQuatToMatrix( &transform, matrix ) ) ) )
+            reply.write( matrix, 16 );
+        return;
+    }
+
+    case REMOTE_GET_INPUT_NAME:
+    {
+        int32_t asset_id = -1, input_idx = 0, input_type = 0;
+        request >> asset_id >> input_idx >> input_type;
+        if ( !request.ok() )
+            break;
+
+        HAPI_StringHandle name = -1;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetInputName( asset_id, input_idx, input_type,
+                                                          &name ) ) ) )
+            reply << name;
+        return;
+    }
+
+    //------------------------------------------------------------------------
+    // Nodes and parms:
+
+    case REMOTE_GET_NODE_INFO:
+    {
+        int32_t node_id = -1;
+        request >> node_id;
+        if ( !request.ok() )
+            break;
+
+        HAPI_NodeInfo info;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetNodeInfo( node_id, &info ) ) ) )
+            reply << info;
+        return;
+    }
+
+    case REMOTE_GET_PARAMETERS:
+    {
+        int32_t node_id = -1, start = 0, length = 0;
+        request >> node_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(HAPI_ParmInfo) ) )
+            break;
+
+        std::vector<HAPI_ParmInfo> infos( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetParameters( node_id, Data( infos ), start,
+                                                           length ) ) ) )
+            reply.write( Data( infos ), length );
+        return;
+    }
+
+    case REMOTE_GET_PARM_INT_VALUES:
+    {
+        int32_t node_id = -1, start = 0, length = 0;
+        request >> node_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(int) ) )
+            break;
+
+        std::vector<int> values( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetParmIntValues( node_id, Data( values ), start,
+                                                              length ) ) ) )
+            reply.write( Data( values ), length );
+        return;
+    }
+
+    case REMOTE_GET_PARM_FLOAT_VALUES:
+    {
+        int32_t node_id = -1, start = 0, length = 0;
+        request >> node_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(float) ) )
+            break;
+
+        std::vector<float> values( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetParmFloatValues( node_id, Data( values ), start,
+                                                                length ) ) ) )
+            reply.write( Data( values ), length );
+        return;
+    }
+
+    case REMOTE_GET_PARM_STRING_VALUES:
+    {
+        int32_t node_id = -1, evaluate = 0, start = 0, length = 0;
+        request >> node_id >> evaluate >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(HAPI_StringHandle) ) )
+            break;
+
+        std::vector<HAPI_StringHandle> values( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetParmStringValues( node_id, evaluate,
+                                                                 Data( values ), start,
+                                                                 length ) ) ) )
+            reply.write( Data( values ), length );
+        return;
+    }
+
+    case REMOTE_GET_PARM_CHOICE_LISTS:
+    {
+        int32_t node_id = -1, start = 0, length = 0;
+        request >> node_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(HAPI_ParmChoiceInfo) ) )
+            break;
+
+        std::vector<HAPI_ParmChoiceInfo> choices( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetParmChoiceLists( node_id, Data( choices ), start,
+                                                                length ) ) ) )
+            reply.write( Data( choices ), length );
+        return;
+    }
+
+    case REMOTE_SET_PARM_INT_VALUES:
+    {
+        int32_t node_id = -1, start = 0, length = 0;
+        request >> node_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(int) ) )
+            break;
+
+        std::vector<int> values( length );
+        if ( !request.read( Data( values ), length ) )
+            break;
+        Reply( reply, HAPI_TRACE( HAPI_SetParmIntValues( node_id, Data( values ), start,
+                                                         length ) ) );
+        return;
+    }
+
+    case REMOTE_SET_PARM_FLOAT_VALUES:
+    {
+        int32_t node_id = -1, start = 0, length = 0;
+        request >> node_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(float) ) )
+            break;
+
+        std::vector<float> values( length );
+        if ( !request.read( Data( values ), length ) )
+            break;
+        Reply( reply, HAPI_TRACE( HAPI_SetParmFloatValues( node_id, Data( values ), start,
+                                                           length ) ) );
+        return;
+    }
+
+    case REMOTE_SET_PARM_STRING_VALUE:
+    {
+        int32_t node_id = -1, parm_id = -1, index = 0;
+        request >> node_id;
+        const char* value = request.readString();
+        request >> parm_id >> index;
+        if ( !request.ok() )
+            break;
+
+        Reply( reply, HAPI_TRACE( HAPI_SetParmStringValue( node_id, value, parm_id, index ) ) );
+        return;
+    }
+
+    case REMOTE_INSERT_MULTIPARM_INSTANCE:
+    case REMOTE_REMOVE_MULTIPARM_INSTANCE:
+    {
+        int32_t node_id = -1, parm_id = -1, position = 0;
+        request >> node_id >> parm_id >> position;
+        if ( !request.ok() )
+            break;
+
+        Reply( reply, opcode == REMOTE_INSERT_MULTIPARM_INSTANCE
+               ? HAPI_TRACE( HAPI_InsertMultiparmInstance( node_id, parm_id, position ) )
+               : HAPI_TRACE( HAPI_RemoveMultiparmInstance( node_id, parm_id, position ) ) );
+        return;
+    }
+
+    //------------------------------------------------------------------------
+    // Objects, geos and parts:
+
+    case REMOTE_GET_OBJECTS:
+    {
+        int32_t asset_id = -1, start = 0, length = 0;
+        request >> asset_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(HAPI_ObjectInfo) ) )
+            break;
+
+        std::vector<HAPI_ObjectInfo> infos( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetObjects( asset_id, Data( infos ), start,
+                                                        length ) ) ) )
+            reply.write( Data( infos ), length );
+        return;
+    }
+
+    case REMOTE_GET_OBJECT_TRANSFORMS:
+    {
+        int32_t asset_id = -1, rst_order = 0, start = 0, length = 0;
+        request >> asset_id >> rst_order >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(HAPI_Transform) ) )
+            break;
+
+        std::vector<HAPI_Transform> transforms( length );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetObjectTransforms(
+                        asset_id, HAPI_RSTOrder( rst_order ), Data( transforms ), start,
+                        length ) ) ) )
+            reply.write( Data( transforms ), length );
+        return;
+    }
+
+    case REMOTE_GET_GEO_INFO:
+    {
+        int32_t asset_id = -1, object_id = -1, geo_id = -1;
+        request >> asset_id >> object_id >> geo_id;
+        if ( !request.ok() )
+            break;
+
+        HAPI_GeoInfo info;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetGeoInfo( asset_id, object_id, geo_id, &info ) ) ) )
+            reply << info;
+        return;
+    }
+
+    case REMOTE_GET_PART_INFO:
+    {
+        int32_t asset_id = -1, object_id = -1, geo_id = -1, part_id = -1;
+        request >> asset_id >> object_id >> geo_id >> part_id;
+        if ( !request.ok() )
+            break;
+
+        HAPI_PartInfo info;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetPartInfo( asset_id, object_id, geo_id, part_id,
+                                                         &info ) ) ) )
+            reply << info;
+        return;
+    }
+
+    case REMOTE_GET_FACE_COUNTS:
+    case REMOTE_GET_VERTEX_LIST:
+    {
+        int32_t asset_id = -1, object_id = -1, geo_id = -1, part_id = -1, start = 0, length = 0;
+        request >> asset_id >> object_id >> geo_id >> part_id >> start >> length;
+        if ( !request.ok() || !ValidCount( length, sizeof(int) ) )
+            break;
+
+        std::vector<int> values( length );
+        HAPI_Result result = opcode == REMOTE_GET_FACE_COUNTS
+                ? HAPI_TRACE( HAPI_GetFaceCounts( asset_id, object_id, geo_id, part_id,
+                                                  Data( values ), start, length ) )
+                : HAPI_TRACE( HAPI_GetVertexList( asset_id, object_id, geo_id, part_id,
+                                                  Data( values ), start, length ) );
+        if ( Reply( reply, result ) )
+            reply.write( Data( values ), length );
+        return;
+    }
+
+    case REMOTE_GET_ATTRIBUTE_INFO:
+    {
+        int32_t asset_id = -1, object_id = -1, geo_id = -1, part_id = -1, owner = 0;
+        request >> asset_id >> object_id >> geo_id >> part_id;
+        const char* name = request.readString();
+        request >> owner;
+        if ( !request.ok() || !name )
+            break;
+
+        HAPI_AttributeInfo info;
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetAttributeInfo(
+                        asset_id, object_id, geo_id, part_id, name,
+                        HAPI_AttributeOwner( owner ), &info ) ) ) )
+            reply << info;
+        return;
+    }
+
+    case REMOTE_GET_ATTRIBUTE_NAMES:
+    {
+        int32_t asset_id = -1, object_id = -1, geo_id = -1, part_id = -1, owner = 0, count = 0;
+        request >> asset_id >> object_id >> geo_id >> part_id >> owner >> count;
+        if ( !request.ok() || !ValidCount( count, sizeof(HAPI_StringHandle) ) )
+            break;
+
+        std::vector<HAPI_StringHandle> names( count );
+        if ( Reply( reply, HAPI_TRACE( HAPI_GetAttributeNames(
+                        asset_id, object_id, geo_id, part_id, HAPI_AttributeOwner( owner ),
+                        Data( names ), count ) ) ) )
+            reply.write( Data( names ), count );
+        return;
+    }
+
+    case REMOTE_GET_ATTRIBUTE_INT_DATA:
+    case REMOTE_GET_ATTRIBUTE_FLOAT_DATA:
+    case REMOTE_GET_ATTRIBUTE_STRING_DATA:
+    {
+        HAPI_AttributeInfo info;
+        int32_t asset_id = -1, object_id = -1, geo_id = -1, part_id = -1, start = 0, length = 0;
+        request >> asset_id >> object_id >> geo_id >> part_id;
+        const char* name = request.readString();
+        request >> info >> start >> length;
+        // Every storage is 4 bytes wide.
+        if ( !request.ok() || !name || info.tupleSize < 0 || length < 0 ||
+             ( info.tupleSize > 0 &&
+               !ValidCount( length, sizeof(int) * size_t( info.tupleSize ) ) ) )
+            break;
+
+        int count = length * info.tupleSize;
+        HAPI_Result result;
+        std::vector<int> ints;
+        std::vector<float> floats;
+        if ( opcode == REMOTE_GET_ATTRIBUTE_FLOAT_DATA )
+        {
+            floats.resize( count );
+            result = HAPI_TRACE( HAPI_GetAttributeFloatData( asset_id, object_id, geo_id, part_id,
+                                                             name, &info, Data( floats ),
+                                                             start, length ) );
+        }
+        else
+        {
+            ints.resize( count );
+            result = opcode == REMOTE_GET_ATTRIBUTE_INT_DATA
+                    ? HAPI_TRACE( HAPI_GetAttributeIntData( asset_id, object_id, geo_id, part_id,
+                                                            name, &info, Data( ints ),
+                                                            start, length ) )
+                    : HAPI_TRACE( HAPI_GetAttributeStringData( asset_id, object_id, geo_id,
+                                                               part_id, name, &info,
+                                                               Data( ints ), start, length ) );
+        }
+        if ( Reply( reply, result ) )
+        {
+            reply << info;
+            if ( opcode == REMOTE_GET_ATTRIBUTE_FLOAT_DATA )
+                reply.write( Data( floats ), count );
+            else
+                reply.write( Data( ints ), count );
+        }
+        return;
+    }
+
+    default:
+        break;
+    }
+
+    // Unknown opcode or malformed arguments.
+    reply.clear();
+    Reply( reply, HAPI_RESULT_INVALID_ARGUMENT );
+}
+
+HAPI_Result RemoteEngine::loadLibrary( const char* data, size_t size, uint64_t hash,
+                                       bool allow_overwrite, int& library_id )
+{
+    for ( size_t i = 0; i < mLibraries.size(); ++i )
+        if ( mLibraries[i].hash == hash )
+        {
+            mLibraries[i].used = Clock::now();
+            library_id = mLibraries[i].id;
+            return HAPI_RESULT_SUCCESS;
+        }
+
+    // Kept to load it again after a restart.
+    Library library;
+    library.hash = hash;
+    library.data.reset( new std::vector<char>( data, data + size ) );
+    library.used = Clock::now();
+
+    HAPI_Result result = HAPI_TRACE( HAPI_LoadAssetLibraryFromMemory(
+                &( *library.data )[0], int( size ), allow_overwrite, &library.id ) );
+    if ( result != HAPI_RESULT_SUCCESS )
+        return result;
+    WaitForReady();
+    library.assets = ListAssets( library.id );
+
+    // Parked instances of assets the library redefines are out of date.
+    for ( size_t i = 0; i < library.assets.size(); ++i )
+    {
+        std::map<int, Instance>::iterator it = mInstances.begin();
+        while ( it != mInstances.end() )
+        {
+            int asset_id = it->first;
+            Instance& instance = it->second;
+            ++it;
+            if ( instance.name != library.assets[i] )
+                continue;
+            instance.defaults.reset();
+            if ( instance.owner < 0 )
+                destroyInstance( asset_id );
+        }
+    }
+
+    mLibraries.push_back( library );
+    library_id = library.id;
+    return HAPI_RESULT_SUCCESS;
+}
+
+// Files are loaded from memory too, so they are deduplicated by content
+// and can be reloaded after a restart. What cannot be mapped is handed to
+// HAPI as a file, which reports why it can't be loaded.
+HAPI_Result RemoteEngine::loadLibraryFile( const char* path, bool allow_overwrite,
+                                           int& library_id )
+{
+    MappedFile file;
+    if ( !file.open( path ) || file.size() == 0 || file.size() > size_t( INT_MAX ) )
+    {
+        HAPI_Result result = HAPI_TRACE( HAPI_LoadAssetLibraryFromFile(
+                    path, allow_overwrite, &library_id ) );
+        if ( result == HAPI_RESULT_SUCCESS )
+            WaitForReady();
+        return result;
+    }
+
+    return loadLibrary( file.data(), file.size(), CookCache::hashData( file.data(), file.size() ),
+                        allow_overwrite, library_id );
+}
+
+void RemoteEngine::useLibraryOf( const std::string& asset_name )
+{
+    // The last library loaded that defines the asset is the one in use.
+    for ( size_t i = mLibraries.size(); i-- > 0; )
+        for ( size_t a = 0; a < mLibraries[i].assets.size(); ++a )
+            if ( mLibraries[i].assets[a] == asset_name )
+            {
+                mLibraries[i].used = Clock::now();
+                return;
+            }
+}
+
+HAPI_Result RemoteEngine::instantiate( Client& client, int client_id, const char* name,
+                                       bool cook, int& asset_id )
+{
+    useLibraryOf( name );
+
+    // The instance parked last is the likeliest to still be paged in.
+    std::map<int, Instance>::iterator reuse = mInstances.end();
+    for ( std::map<int, Instance>::iterator it = mInstances.begin(); it != mInstances.end(); ++it )
+        if ( it->second.owner < 0 && it->second.defaults && it->second.name == name &&
+             ( reuse == mInstances.end() || it->second.parked > reuse->second.parked ) )
+            reuse = it;
+
+    if ( reuse != mInstances.end() )
+    {
+        Instance& instance = reuse->second;
+        try
+        {
+            // The client changed the asset behind the caches' back.
+            StringCache::getInstance()->clear();
+            InfoCache::getInstance()->remove( reuse->first );
+
+            Asset asset( reuse->first );
+            int calls = instance.defaults->apply( asset, false );
+            if ( cook && ( calls > 0 || !instance.cooked ) )
+            {
+                asset.cook();
+                instance.cooked = true;
+                if ( client.synchronous )
+                    WaitForReady();
+            }
+            instance.owner = client_id;
+            asset_id = reuse->first;
+            ++mReused;
+            return HAPI_RESULT_SUCCESS;
+        }
+        catch ( Failure& )
+        {
+            destroyInstance( reuse->first );
+        }
+    }
+
+    HAPI_Result result = HAPI_TRACE( HAPI_InstantiateAsset( name, cook, &asset_id ) );
+    if ( result != HAPI_RESULT_SUCCESS )
+        return result;
+    ++mInstantiated;
+
+    Instance instance;
+    instance.name = name;
+    instance.owner = client_id;
+    instance.cooked = cook;
+
+    // The parms exist once the instance is ready.
+    if ( WaitForReady() )
+    {
+        try
+        {
+            InfoCache::getInstance()->remove( asset_id );
+            instance.defaults.reset( new ParmPreset );
+            instance.defaults->capture( Asset( asset_id ) );
+        }
+        catch ( Failure& )
+        {
+            instance.defaults.reset();
+        }
+    }
+
+    mInstances[ asset_id ] = instance;
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result RemoteEngine::destroy( int client_id, int asset_id )
+{
+    std::map<int, Instance>::iterator it = mInstances.find( asset_id );
+    if ( it == mInstances.end() )
+        return HAPI_TRACE( HAPI_DestroyAsset( asset_id ) );
+    if ( it->second.owner != client_id )
+        return HAPI_RESULT_INVALID_ARGUMENT;
+
+    if ( !it->second.defaults )
+    {
+        destroyInstance( asset_id );
+        return HAPI_RESULT_SUCCESS;
+    }
+    it->second.owner = -1;
+    it->second.parked = Clock::now();
+    trimIdle();
+    return HAPI_RESULT_SUCCESS;
+}
+
+void RemoteEngine::park( int client_id )
+{
+    std::vector<int> owned;
+    for ( std::map<int, Instance>::const_iterator it = mInstances.begin();
+          it != mInstances.end(); ++it )
+        if ( it->second.owner == client_id )
+            owned.push_back( it->first );
+
+    for ( size_t i = 0; i < owned.size(); ++i )
+        destroy( client_id, owned[i] );
+}
+
+void RemoteEngine::disconnected( int client_id )
+{
+    park( client_id );
+    mClients.erase( client_id );
+}
+
+void RemoteEngine::trimIdle()
+{
+    while ( idleAssetCount() > ( mMaxIdleAssets > 0 ? mMaxIdleAssets : 0 ) )
+    {
+        std::map<int, Instance>::iterator oldest = mInstances.end();
+        for ( std::map<int, Instance>::iterator it = mInstances.begin();
+              it != mInstances.end(); ++it )
+            if ( it->second.owner < 0 &&
+                 ( oldest == mInstances.end() || it->second.parked < oldest->second.parked ) )
+                oldest = it;
+        destroyInstance( oldest->first );
+    }
+}
+
+void RemoteEngine::destroyInstance( int asset_id )
+{
+    InfoCache::getInstance()->remove( asset_id );
+    HAPI_TRACE( HAPI_DestroyAsset( asset_id ) );
+    mInstances.erase( asset_id );
+}
+
+void RemoteEngine::evict()
+{
+    if ( mFailed )
+        return;
+
+    if ( mIdleTimeout > 0 )
+    {
+        Clock::time_point limit = Clock::now() - std::chrono::seconds( mIdleTimeout );
+        std::vector<int> expired;
+        for ( std::map<int, Instance>::const_iterator it = mInstances.begin();
+              it != mInstances.end(); ++it )
+            if ( it->second.owner < 0 && it->second.parked < limit )
+                expired.push_back( it->first );
+        for ( size_t i = 0; i < expired.size(); ++i )
+            destroyInstance( expired[i] );
+    }
+
+    if ( mMaxLibraries > 0 && int( mLibraries.size() ) > mMaxLibraries && mClients.empty() )
+        restart();
+}
+
+void RemoteEngine::restart()
+{
+    // Keep the most recently used libraries, in the order they were loaded
+    // so the same definitions win.
+    std::vector<Clock::time_point> uses;
+    for ( size_t i = 0; i < mLibraries.size(); ++i )
+        uses.push_back( mLibraries[i].used );
+    std::sort( uses.begin(), uses.end() );
+    Clock::time_point oldest_kept = uses[ uses.size() - mMaxLibraries ];
+
+    std::vector<Library> kept;
+    for ( size_t i = 0; i < mLibraries.size(); ++i )
+        if ( mLibraries[i].used >= oldest_kept && int( kept.size() ) < mMaxLibraries )
+            kept.push_back( mLibraries[i] );
+
+    mInstances.clear();
+    mLibraries.clear();
+
+    Engine* hapi = Engine::getInstance();
+    hapi->cleanup();
+    if ( !initialize() )
+    {
+        mFailed = true;
+        return;
+    }
+
+    for ( size_t i = 0; i < kept.size(); ++i )
+    {
+        Library& library = kept[i];
+        std::vector<char>& data = *library.data;
+        if ( HAPI_TRACE( HAPI_LoadAssetLibraryFromMemory( &data[0], int( data.size() ), false,
+                                                          &library.id ) ) != HAPI_RESULT_SUCCESS )
+            continue;
+        WaitForReady();
+        mLibraries.push_back( library );
+    }
+}
+
+};
@@ -0,0 +1,134 @@
+#ifndef REMOTEENGINE_H
+#define REMOTEENGINE_H
+
+#include "parmpreset.h"
+#include "remoteprotocol.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Remote engine:
+
+// The server side of the remote protocol: answers the requests of any
+// number of clients from one engine that stays up between them, so a
+// client starts without initializing Houdini and finds the libraries it
+// loaded last time already there. Not thread safe; HoudiniEngineServer
+// calls it from its event loop only.
+//
+// Most requests go straight to HAPI. The ones that would tear the engine
+// down or lose work don't:
+//  - HAPI_Initialize and HAPI_Cleanup only start and end the client's
+//    session; the engine runs with a cooking thread whatever the client
+//    asked for, but a client that asked for none gets its replies to
+//    cooks and loads once they finished. Search paths are ignored.
+//  - Libraries are kept by content hash, so loading one the engine already
+//    has costs nothing, and remoteclient.cpp doesn't even send it again.
+//  - Destroyed assets, and the assets of clients that go away, are parked
+//    instead. Instantiating the same asset again hands out a parked
+//    instance, reverted to the parm values it was created with, in place
+//    of a fresh one.
+//
+// Parked instances are destroyed least recently parked first beyond
+// maxIdleAssets, and once they have been idle for idleTimeout. Houdini
+// Engine 1.x cannot unload a library, so when more than maxLibraries are
+// loaded and no client is connected, evict() restarts the engine with the
+// most recently used ones only.
+class RemoteEngine
+{
+public:
+    RemoteEngine();
+    ~RemoteEngine();
+
+    void            setMaxIdleAssets( int count ) { mMaxIdleAssets = count; }
+    void            setMaxLibraries( int count ) { mMaxLibraries = count; }
+    // In seconds; 0 keeps parked instances until they are pushed out.
+    void            setIdleTimeout( int seconds ) { mIdleTimeout = seconds; }
+
+    // Initializes the engine; false when it cannot, see error().
+    bool            initialize();
+    // After a failed restart nothing can be served any more.
+    bool            isFailed() const { return mFailed; }
+    const std::string& error() const { return mError; }
+
+    // Answers one request of client; client ids are up to the caller.
+    void            handle( int client, RemoteMessage& request, RemoteMessage& reply );
+    // Parks everything client still owns.
+    void            disconnected( int client );
+    // Applies the idle timeout and the library limit; call now and then.
+    void            evict();
+
+    int             idleAssetCount() const;
+    int             libraryCount() const { return int( mLibraries.size() ); }
+    // Instantiations served by a parked instance, and by a new one.
+    int             reuseCount() const { return mReused; }
+    int             instantiateCount() const { return mInstantiated; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Client
+    {
+        Client() : greeted(false), initialized(false), synchronous(false) {}
+
+        bool        greeted;
+        bool        initialized;
+        bool        synchronous;
+        // Taken by HAPI_GetStatusStringBufLength for HAPI_GetStatusString.
+        std::string status[ HAPI_STATUS_MAX ];
+    };
+
+    struct Instance
+    {
+        std::string         name;
+        int                 owner;      // client id, -1 when parked
+        bool                cooked;
+        // The parm values it was created with; null when they couldn't be
+        // read, in which case it is not handed out again.
+        std::shared_ptr<ParmPreset> defaults;
+        Clock::time_point   parked;
+    };
+
+    struct Library
+    {
+        uint64_t            hash;
+        std::shared_ptr<std::vector<char> > data;
+        int                 id;
+        std::vector<std::string> assets;
+        Clock::time_point   used;
+    };
+
+    HAPI_Result     loadLibrary( const char* data, size_t size, uint64_t hash,
+                                 bool allow_overwrite, int& library_id );
+    HAPI_Result     loadLibraryFile( const char* path, bool allow_overwrite, int& library_id );
+    HAPI_Result     instantiate( Client& client, int client_id, const char* name, bool cook,
+                                 int& asset_id );
+    HAPI_Result     destroy( int client_id, int asset_id );
+    void            park( int client_id );
+    void            trimIdle();
+    void            destroyInstance( int asset_id );
+    void            useLibraryOf( const std::string& asset_name );
+    void            restart();
+
+    std::map<int, Client>       mClients;
+    std::map<int, Instance>     mInstances;
+    // In load order.
+    std::vector<Library>        mLibraries;
+
+    int                         mMaxIdleAssets;
+    int                         mMaxLibraries;
+    int                         mIdleTimeout;
+    int                         mReused;
+    int                         mInstantiated;
+    bool                        mFailed;
+    std::string                 mError;
+};
+
+}
+
+#endif // REMOTEENGINE_H
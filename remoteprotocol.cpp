@@ -0,0 +1,110 @@
+#include "remoteprotocol.h"
+#include <HAPI/HAPI.h>
+#include <cstdlib>
+
+namespace hapi {
+
+void RemoteMessage::clear()
+{
+    mData.clear();
+    mRead = 0;
+    mBad = false;
+}
+
+char* RemoteMessage::prepare( size_t size )
+{
+    clear();
+    mData.resize( size );
+    return size ? &mData[0] : nullptr;
+}
+
+void RemoteMessage::append( const void* data, size_t size )
+{
+    const char* bytes = static_cast<const char*>( data );
+    mData.insert( mData.end(), bytes, bytes + size );
+}
+
+void RemoteMessage::take( void* data, size_t size )
+{
+    if ( mBad || size > mData.size() - mRead )
+    {
+        mBad = true;
+        memset( data, 0, size );
+        return;
+    }
+    memcpy( data, &mData[ mRead ], size );
+    mRead += size;
+}
+
+RemoteMessage& RemoteMessage::operator<<( const char* text )
+{
+    int32_t length = text ? int32_t( strlen( text ) ) : -1;
+    *this << length;
+    if ( text )
+        append( text, size_t( length ) + 1 );
+    return *this;
+}
+
+const char* RemoteMessage::readString()
+{
+    int32_t length = -1;
+    *this >> length;
+    if ( mBad || length < 0 )
+        return nullptr;
+
+    const char* text = readBytes( size_t( length ) + 1 );
+    if ( text && text[ length ] != 0 )
+    {
+        mBad = true;
+        return nullptr;
+    }
+    return text;
+}
+
+const char* RemoteMessage::readBytes( size_t size )
+{
+    if ( mBad || size > mData.size() - mRead )
+    {
+        mBad = true;
+        return nullptr;
+    }
+    const char* bytes = size ? &mData[ mRead ] : "";
+    mRead += size;
+    return bytes;
+}
+
+std::string RemoteServerName()
+{
+    const char* name = getenv( "HOUDINI_ENGINE_SERVER_NAME" );
+    if ( name && *name )
+        return name;
+
+#ifdef _WIN32
+    const char* user = getenv( "USERNAME" );
+    return std::string( "HoudiniEngineServer-" ) + ( user ? user : "default" );
+#else
+    const char* temp = getenv( "TMPDIR" );
+    const char* user = getenv( "USER" );
+    std::string directory( temp && *temp ? temp : "/tmp" );
+    if ( directory[ directory.size() - 1 ] != '/' )
+        directory += '/';
+    return directory + "HoudiniEngineServer-" + ( user ? user : "default" ) + ".sock";
+#endif
+}
+
+uint32_t RemoteStructSignature()
+{
+    const size_t sizes[] = {
+        sizeof(HAPI_CookOptions), sizeof(HAPI_AssetInfo), sizeof(HAPI_NodeInfo),
+        sizeof(HAPI_ParmInfo), sizeof(HAPI_ParmChoiceInfo), sizeof(HAPI_ObjectInfo),
+        sizeof(HAPI_GeoInfo), sizeof(HAPI_PartInfo), sizeof(HAPI_AttributeInfo),
+        sizeof(HAPI_TransformEuler), sizeof(HAPI_Transform)
+    };
+
+    uint32_t signature = 2166136261u;
+    for ( size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i )
+        signature = ( signature ^ uint32_t( sizes[i] ) ) * 16777619u;
+    return signature;
+}
+
+};
@@ -0,0 +1,174 @@
+#ifndef REMOTEPROTOCOL_H
+#define REMOTEPROTOCOL_H
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Remote engine protocol:
+
+// Spoken between the remote libHAPI in remoteclient.cpp and
+// HoudiniEngineServer over a local socket (a named pipe on Windows).
+//
+// Every message is a frame: a uint32_t payload size followed by the
+// payload. A request starts with its RemoteOpcode and carries the inputs of
+// the HAPI call in declaration order; the reply starts with the
+// HAPI_Result and, on success, carries the outputs. Arrays whose length
+// the call already names are sent raw; strings are an int32_t length (-1
+// for a null pointer) followed by the bytes and a terminating 0. Structs
+// go over as they are in memory, which is fine as both ends are built from
+// the same HAPI.h and run on the same machine; REMOTE_HELLO checks that.
+//
+// The client waits for each reply before it sends the next request.
+
+#define REMOTE_PROTOCOL_VERSION     (2)
+// Largest payload either side accepts; asset libraries go over in one
+// message.
+#define REMOTE_MAX_MESSAGE_SIZE     (0x7fffff00u)
+
+enum RemoteOpcode
+{
+    // version, sizeof of the HAPI structs
+    REMOTE_HELLO = 1,
+    // hash -> library id, or -1 when the server doesn't have the library
+    REMOTE_FIND_LIBRARY,
+
+    REMOTE_COOK_OPTIONS_CREATE,
+    REMOTE_IS_INITIALIZED,
+    REMOTE_INITIALIZE,
+    REMOTE_CLEANUP,
+    REMOTE_GET_STATUS,
+    REMOTE_GET_STATUS_STRING_BUF_LENGTH,
+    REMOTE_GET_STATUS_STRING,
+    REMOTE_GET_COOKING_TOTAL_COUNT,
+    REMOTE_GET_COOKING_CURRENT_COUNT,
+    REMOTE_INTERRUPT,
+
+    REMOTE_GET_STRING_BUF_LENGTH,
+    REMOTE_GET_STRING,
+
+    REMOTE_LOAD_ASSET_LIBRARY_FROM_FILE,
+    // Preceded by the hash the client sent REMOTE_FIND_LIBRARY, so the
+    // server doesn't hash the library again.
+    REMOTE_LOAD_ASSET_LIBRARY_FROM_MEMORY,
+    REMOTE_GET_AVAILABLE_ASSET_COUNT,
+    REMOTE_GET_AVAILABLE_ASSETS,
+    REMOTE_INSTANTIATE_ASSET,
+    REMOTE_DESTROY_ASSET,
+    REMOTE_GET_ASSET_INFO,
+    REMOTE_COOK_ASSET,
+    REMOTE_IS_ASSET_VALID,
+    REMOTE_GET_ASSET_TRANSFORM,
+    REMOTE_CONVERT_TRANSFORM_EULER_TO_MATRIX,
+    REMOTE_CONVERT_TRANSFORM_QUAT_TO_MATRIX,
+    REMOTE_GET_INPUT_NAME,
+
+    REMOTE_GET_NODE_INFO,
+    REMOTE_GET_PARAMETERS,
+    REMOTE_GET_PARM_INT_VALUES,
+    REMOTE_GET_PARM_FLOAT_VALUES,
+    REMOTE_GET_PARM_STRING_VALUES,
+    REMOTE_GET_PARM_CHOICE_LISTS,
+    REMOTE_SET_PARM_INT_VALUES,
+    REMOTE_SET_PARM_FLOAT_VALUES,
+    REMOTE_SET_PARM_STRING_VALUE,
+    REMOTE_INSERT_MULTIPARM_INSTANCE,
+    REMOTE_REMOVE_MULTIPARM_INSTANCE,
+
+    REMOTE_GET_OBJECTS,
+    REMOTE_GET_OBJECT_TRANSFORMS,
+    REMOTE_GET_GEO_INFO,
+    REMOTE_GET_PART_INFO,
+    REMOTE_GET_FACE_COUNTS,
+    REMOTE_GET_VERTEX_LIST,
+    REMOTE_GET_ATTRIBUTE_INFO,
+    REMOTE_GET_ATTRIBUTE_NAMES,
+    REMOTE_GET_ATTRIBUTE_INT_DATA,
+    REMOTE_GET_ATTRIBUTE_FLOAT_DATA,
+    REMOTE_GET_ATTRIBUTE_STRING_DATA
+};
+
+// Payload of one frame, written front to back and read back in the same
+// order. Reads past the end or of malformed strings mark the message as
+// bad instead of failing one by one; check ok() once at the end.
+class RemoteMessage
+{
+public:
+    RemoteMessage() : mRead(0), mBad(false) {}
+    RemoteMessage( const char* data, size_t size ) :
+        mData(data, data + size), mRead(0), mBad(false) {}
+
+    void            clear();
+
+    template <typename T>
+    RemoteMessage&  operator<<( const T& value )
+    {
+        append( &value, sizeof(T) );
+        return *this;
+    }
+    RemoteMessage&  operator<<( const char* text );
+    RemoteMessage&  operator<<( const std::string& text ) { return *this << text.c_str(); }
+
+    template <typename T>
+    void            write( const T* values, int count )
+    {
+        if ( count > 0 )
+            append( values, sizeof(T) * size_t( count ) );
+    }
+
+    template <typename T>
+    RemoteMessage&  operator>>( T& value )
+    {
+        take( &value, sizeof(T) );
+        return *this;
+    }
+
+    template <typename T>
+    bool            read( T* values, int count )
+    {
+        if ( count > 0 )
+            take( values, sizeof(T) * size_t( count ) );
+        return !mBad;
+    }
+
+    // The next string; nullptr for a null one or when the message is bad.
+    // Points into the message.
+    const char*     readString();
+    // The next size bytes, in place.
+    const char*     readBytes( size_t size );
+
+    bool            ok() const { return !mBad; }
+    bool            atEnd() const { return mRead == mData.size(); }
+
+    const char*     data() const { return mData.empty() ? nullptr : &mData[0]; }
+    size_t          size() const { return mData.size(); }
+
+    // Empties the message and makes room for a size byte payload to be
+    // received into.
+    char*           prepare( size_t size );
+
+private:
+    void            append( const void* data, size_t size );
+    void            take( void* data, size_t size );
+
+    std::vector<char>   mData;
+    size_t              mRead;
+    bool                mBad;
+};
+
+// Where the server listens: a socket in the temp directory on Unix, a pipe
+// name on Windows, both per user. HOUDINI_ENGINE_SERVER_NAME overrides it.
+std::string RemoteServerName();
+
+// Changes whenever one of the structs sent as they are changes size, so a
+// server built against another HAPI.h turns clients away.
+uint32_t RemoteStructSignature();
+
+}
+
+#endif // REMOTEPROTOCOL_H
@@ -0,0 +1,125 @@
+#include "resultcache.h"
+
+namespace hapi {
+
+ResultCache::ResultCache( size_t capacity_bytes ) :
+    mCapacity(capacity_bytes),
+    mBytes(0),
+    mHits(0),
+    mMisses(0),
+    mEvictions(0)
+{
+}
+
+std::shared_ptr<const CookResult> ResultCache::find( uint64_t key )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::unordered_map< uint64_t, std::list<Entry>::iterator >::iterator it = mIndex.find( key );
+    if ( it == mIndex.end() )
+    {
+        ++mMisses;
+        return std::shared_ptr<const CookResult>();
+    }
+
+    ++mHits;
+    mEntries.splice( mEntries.begin(), mEntries, it->second );
+    return it->second->second;
+}
+
+void ResultCache::insert( uint64_t key, const std::shared_ptr<CookResult>& result )
+{
+    result->byte_size = 0;
+    for ( size_t i = 0; i < result->meshes.size(); ++i )
+        result->byte_size += sizeof(ExportedMesh) + result->meshes[i]->byteSize();
+
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::unordered_map< uint64_t, std::list<Entry>::iterator >::iterator it = mIndex.find( key );
+    if ( it != mIndex.end() )
+    {
+        mBytes -= it->second->second->byte_size;
+        mEntries.erase( it->second );
+        mIndex.erase( it );
+    }
+
+    if ( result->byte_size > mCapacity )
+        return;
+
+    evict( mCapacity - result->byte_size );
+    mEntries.push_front( Entry( key, result ) );
+    mIndex[ key ] = mEntries.begin();
+    mBytes += result->byte_size;
+}
+
+void ResultCache::evict( size_t capacity )
+{
+    while ( mBytes > capacity && !mEntries.empty() )
+    {
+        mBytes -= mEntries.back().second->byte_size;
+        mIndex.erase( mEntries.back().first );
+        mEntries.pop_back();
+        ++mEvictions;
+    }
+}
+
+void ResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mEntries.clear();
+    mIndex.clear();
+    mBytes = 0;
+}
+
+void ResultCache::setCapacity( size_t capacity_bytes )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mCapacity = capacity_bytes;
+    evict( mCapacity );
+}
+
+size_t ResultCache::capacity() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mCapacity;
+}
+
+size_t ResultCache::byteSize() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mBytes;
+}
+
+size_t ResultCache::size() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mEntries.size();
+}
+
+size_t ResultCache::hits() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mHits;
+}
+
+size_t ResultCache::misses() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mMisses;
+}
+
+size_t ResultCache::evictions() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mEvictions;
+}
+
+void ResultCache::resetCounters()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mHits = 0;
+    mMisses = 0;
+    mEvictions = 0;
+}
+
+};
@@ -0,0 +1,72 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "geoexport.h"
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Cooked result cache:
+
+// Geometry extracted from one cook.
+struct CookResult
+{
+    CookResult() : byte_size(0) {}
+
+    std::vector< std::shared_ptr<ExportedMesh> > meshes;
+    size_t byte_size;
+};
+
+// Bounded in-memory LRU of recent cook results keyed by library, asset
+// name and parameter state (see CookCache::makeKey()). Flipping a toggle or menu back to a value
+// cooked recently finds its geometry here instead of cooking again.
+//
+// Memory is capped by the summed mesh sizes; the least recently used
+// results are evicted to make room. Results are shared, so an evicted one
+// stays valid for whoever still holds it.
+class ResultCache
+{
+public:
+    explicit ResultCache( size_t capacity_bytes = 256 * 1024 * 1024 );
+
+    std::shared_ptr<const CookResult> find( uint64_t key );
+    // Results bigger than the whole capacity are not kept.
+    void            insert( uint64_t key, const std::shared_ptr<CookResult>& result );
+    void            clear();
+
+    void            setCapacity( size_t capacity_bytes );
+    size_t          capacity() const;
+    size_t          byteSize() const;
+    size_t          size() const;
+
+    size_t          hits() const;
+    size_t          misses() const;
+    size_t          evictions() const;
+    void            resetCounters();
+
+private:
+    typedef std::pair< uint64_t, std::shared_ptr<const CookResult> > Entry;
+
+    // Must be called with mMutex held.
+    void            evict( size_t capacity );
+
+    mutable std::mutex  mMutex;
+    std::list<Entry>    mEntries;
+    std::unordered_map< uint64_t, std::list<Entry>::iterator > mIndex;
+    size_t              mCapacity;
+    size_t              mBytes;
+    size_t              mHits;
+    size_t              mMisses;
+    size_t              mEvictions;
+};
+
+}
+
+#endif // RESULTCACHE_H
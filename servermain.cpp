@@ -0,0 +1,66 @@
+#include "engineserver.h"
+#include <QCoreApplication>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace hapi;
+
+static void usage()
+{
+    fprintf( stderr,
+             "usage: HoudiniEngineServer [--name name] [--max-idle assets]\n"
+             "                           [--max-libraries libraries] [--idle-timeout s]\n"
+             "\n"
+             "  --name name          socket to listen on (default: per user, see\n"
+             "                       HOUDINI_ENGINE_SERVER_NAME)\n"
+             "  --max-idle n         instances kept for reuse once their client is done\n"
+             "                       with them (default: 8)\n"
+             "  --max-libraries n    libraries kept loaded while no client is connected\n"
+             "                       (default: 16, 0: all)\n"
+             "  --idle-timeout s     destroy instances unused for this long (default: 600,\n"
+             "                       0: never)\n" );
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app( argc, argv );
+
+    QString name = QString::fromLocal8Bit( RemoteServerName().c_str() );
+    EngineServer server;
+    RemoteEngine& engine = server.engine();
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( !strcmp( argv[i], "--name" ) && i + 1 < argc )
+            name = QString::fromLocal8Bit( argv[++i] );
+        else if ( !strcmp( argv[i], "--max-idle" ) && i + 1 < argc )
+            engine.setMaxIdleAssets( atoi( argv[++i] ) );
+        else if ( !strcmp( argv[i], "--max-libraries" ) && i + 1 < argc )
+            engine.setMaxLibraries( atoi( argv[++i] ) );
+        else if ( !strcmp( argv[i], "--idle-timeout" ) && i + 1 < argc )
+            engine.setIdleTimeout( atoi( argv[++i] ) );
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    // Clients start a server whenever they find none, so losing that race
+    // to another one is fine.
+    if ( !server.listen( name ) )
+    {
+        fprintf( stderr, "HoudiniEngineServer: %s\n", server.error().toLocal8Bit().constData() );
+        return 0;
+    }
+
+    if ( !engine.initialize() )
+    {
+        fprintf( stderr, "HoudiniEngineServer: cannot initialize Houdini Engine: %s\n",
+                 engine.error().c_str() );
+        return 1;
+    }
+
+    return app.exec();
+}
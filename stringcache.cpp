@@ -0,0 +1,130 @@
+#include "stringcache.h"
+#include "hapitrace.h"
+
+namespace hapi {
+
+StringCache::StringCache() : mHits(0), mMisses(0)
+{
+}
+
+StringCache* StringCache::getInstance()
+{
+    static StringCache instance;
+    return &instance;
+}
+
+// Must be called with mMutex held. A handle that cannot be read resolves to
+// an empty string but is not interned, so the next lookup asks again.
+const std::string& StringCache::fetch( HAPI_StringHandle handle )
+{
+    ++mMisses;
+
+    int buffer_length = 0;
+    if ( HAPI_TRACE( HAPI_GetStringBufLength( handle, &buffer_length ) ) != HAPI_RESULT_SUCCESS )
+        return mEmpty;
+
+    if ( buffer_length <= 0 )
+        return mStrings[ handle ];
+
+    if ( int( mScratch.size() ) < buffer_length )
+        mScratch.resize( buffer_length );
+
+    if ( HAPI_TRACE( HAPI_GetString( handle, &mScratch[0], buffer_length ) ) != HAPI_RESULT_SUCCESS )
+        return mEmpty;
+
+    std::string& result = mStrings[ handle ];
+    result.assign( &mScratch[0] );
+    return result;
+}
+
+std::string StringCache::get( HAPI_StringHandle handle )
+{
+    if ( handle == 0 )
+        return std::string();
+
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::unordered_map<HAPI_StringHandle, std::string>::const_iterator it = mStrings.find( handle );
+    if ( it != mStrings.end() )
+    {
+        ++mHits;
+        return it->second;
+    }
+    return fetch( handle );
+}
+
+void StringCache::get( HAPI_StringHandle handle, std::string& result )
+{
+    if ( handle == 0 )
+    {
+        result.clear();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::unordered_map<HAPI_StringHandle, std::string>::const_iterator it = mStrings.find( handle );
+    if ( it != mStrings.end() )
+    {
+        ++mHits;
+        result.assign( it->second );
+        return;
+    }
+    result.assign( fetch( handle ) );
+}
+
+void StringCache::resolve( const HAPI_StringHandle* handles, int count )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    for ( int i = 0; i < count; ++i )
+    {
+        HAPI_StringHandle handle = handles[i];
+        if ( handle == 0 )
+            continue;
+
+        if ( mStrings.find( handle ) != mStrings.end() )
+            ++mHits;
+        else
+            fetch( handle );
+    }
+}
+
+void StringCache::resolve( const std::vector<HAPI_StringHandle>& handles )
+{
+    if ( !handles.empty() )
+        resolve( &handles[0], int( handles.size() ) );
+}
+
+void StringCache::clear()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mStrings.clear();
+}
+
+size_t StringCache::size() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mStrings.size();
+}
+
+size_t StringCache::hits() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mHits;
+}
+
+size_t StringCache::misses() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mMisses;
+}
+
+void StringCache::resetCounters()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mHits = 0;
+    mMisses = 0;
+}
+
+};
@@ -0,0 +1,59 @@
+#ifndef STRINGCACHE_H
+#define STRINGCACHE_H
+
+#include <HAPI/HAPI.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// String handle cache:
+
+// Resolves HAPI string handles and interns the results so repeated lookups
+// of parm names, labels, choice labels and attribute names never go back to
+// the engine. A single scratch buffer is reused for every miss.
+//
+// HAPI only guarantees a handle's contents until the engine state changes,
+// so the cache is flushed whenever an asset is cooked, instantiated or
+// destroyed.
+class StringCache
+{
+private:
+    StringCache();
+public:
+    static StringCache* getInstance();
+
+    std::string     get( HAPI_StringHandle handle );
+    // Assigns into result so its existing capacity is reused.
+    void            get( HAPI_StringHandle handle, std::string& result );
+
+    // Resolve every handle in one pass: duplicates are skipped and only the
+    // handles not already interned are fetched from the engine.
+    void            resolve( const HAPI_StringHandle* handles, int count );
+    void            resolve( const std::vector<HAPI_StringHandle>& handles );
+
+    void            clear();
+
+    size_t          size() const;
+    size_t          hits() const;
+    size_t          misses() const;
+    void            resetCounters();
+
+private:
+    const std::string& fetch( HAPI_StringHandle handle );
+
+    mutable std::mutex                                  mMutex;
+    std::unordered_map<HAPI_StringHandle, std::string>  mStrings;
+    std::vector<char>                                   mScratch;
+    const std::string                                   mEmpty;
+    size_t                                              mHits;
+    size_t                                              mMisses;
+};
+
+}
+
+#endif // STRINGCACHE_H
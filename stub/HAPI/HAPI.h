@@ -0,0 +1,442 @@
+#ifndef HAPI_H
+#define HAPI_H
+
+//
+// The subset of the Houdini Engine 1.x API used by the wrapper, declared
+// exactly as in the toolkit's HAPI.h so the same sources build against
+// either. Implemented by stub/hapistub.cpp, which serves synthetic assets;
+// see stub/hapistub.h.
+//
+
+//----------------------------------------------------------------------------
+// Types:
+
+typedef int HAPI_Bool;
+typedef int HAPI_StringHandle;
+typedef int HAPI_AssetLibraryId;
+typedef int HAPI_AssetId;
+typedef int HAPI_NodeId;
+typedef int HAPI_ParmId;
+typedef int HAPI_ObjectId;
+typedef int HAPI_GeoId;
+typedef int HAPI_PartId;
+
+enum HAPI_Result
+{
+    HAPI_RESULT_SUCCESS                     = 0,
+    HAPI_RESULT_FAILURE                     = 1,
+    HAPI_RESULT_ALREADY_INITIALIZED         = 2,
+    HAPI_RESULT_NOT_INITIALIZED             = 3,
+    HAPI_RESULT_CANT_LOADFILE               = 4,
+    HAPI_RESULT_PARM_SET_FAILED             = 5,
+    HAPI_RESULT_INVALID_ARGUMENT            = 6,
+    HAPI_RESULT_CANT_LOAD_GEO               = 7,
+    HAPI_RESULT_CANT_GENERATE_PRESET        = 8,
+    HAPI_RESULT_CANT_LOAD_PRESET            = 9,
+    HAPI_RESULT_ASSET_DEF_ALREADY_LOADED    = 10,
+    HAPI_RESULT_NO_LICENSE_FOUND            = 110,
+    HAPI_RESULT_USER_INTERRUPTED            = 18
+};
+
+enum HAPI_StatusType
+{
+    HAPI_STATUS_CALL_RESULT,
+    HAPI_STATUS_COOK_RESULT,
+    HAPI_STATUS_COOK_STATE,
+    HAPI_STATUS_MAX
+};
+
+enum HAPI_StatusVerbosity
+{
+    HAPI_STATUSVERBOSITY_0,
+    HAPI_STATUSVERBOSITY_1,
+    HAPI_STATUSVERBOSITY_2,
+
+    HAPI_STATUSVERBOSITY_ALL        = HAPI_STATUSVERBOSITY_2,
+    HAPI_STATUSVERBOSITY_ERRORS     = HAPI_STATUSVERBOSITY_0,
+    HAPI_STATUSVERBOSITY_WARNINGS   = HAPI_STATUSVERBOSITY_1,
+    HAPI_STATUSVERBOSITY_MESSAGES   = HAPI_STATUSVERBOSITY_2
+};
+
+enum HAPI_State
+{
+    HAPI_STATE_READY,
+    HAPI_STATE_READY_WITH_FATAL_ERRORS,
+    HAPI_STATE_READY_WITH_COOK_ERRORS,
+    HAPI_STATE_STARTING_COOK,
+    HAPI_STATE_COOKING,
+    HAPI_STATE_STARTING_LOAD,
+    HAPI_STATE_LOADING,
+    HAPI_STATE_MAX,
+
+    HAPI_STATE_MAX_READY_STATE = HAPI_STATE_READY_WITH_COOK_ERRORS
+};
+
+enum HAPI_ParmType
+{
+    HAPI_PARMTYPE_INT = 0,
+    HAPI_PARMTYPE_MULTIPARMLIST,
+    HAPI_PARMTYPE_TOGGLE,
+    HAPI_PARMTYPE_BUTTON,
+
+    HAPI_PARMTYPE_FLOAT,
+    HAPI_PARMTYPE_COLOR,
+
+    HAPI_PARMTYPE_STRING,
+    HAPI_PARMTYPE_PATH_FILE,
+    HAPI_PARMTYPE_PATH_FILE_GEO,
+    HAPI_PARMTYPE_PATH_FILE_IMAGE,
+    HAPI_PARMTYPE_PATH_NODE,
+
+    HAPI_PARMTYPE_FOLDERLIST,
+
+    HAPI_PARMTYPE_FOLDER,
+    HAPI_PARMTYPE_LABEL,
+    HAPI_PARMTYPE_SEPARATOR,
+
+    HAPI_PARMTYPE_MAX
+};
+
+enum HAPI_AttributeOwner
+{
+    HAPI_ATTROWNER_INVALID = -1,
+    HAPI_ATTROWNER_VERTEX,
+    HAPI_ATTROWNER_POINT,
+    HAPI_ATTROWNER_PRIM,
+    HAPI_ATTROWNER_DETAIL,
+    HAPI_ATTROWNER_MAX
+};
+
+enum HAPI_StorageType
+{
+    HAPI_STORAGETYPE_INVALID = -1,
+    HAPI_STORAGETYPE_INT,
+    HAPI_STORAGETYPE_FLOAT,
+    HAPI_STORAGETYPE_STRING,
+    HAPI_STORAGETYPE_MAX
+};
+
+enum HAPI_RSTOrder
+{
+    HAPI_TRS,
+    HAPI_TSR,
+    HAPI_RTS,
+    HAPI_RST,
+    HAPI_STR,
+    HAPI_SRT
+};
+
+enum HAPI_XYZOrder
+{
+    HAPI_XYZ,
+    HAPI_XZY,
+    HAPI_YXZ,
+    HAPI_YZX,
+    HAPI_ZXY,
+    HAPI_ZYX
+};
+
+enum HAPI_InputType
+{
+    HAPI_INPUT_INVALID = -1,
+    HAPI_INPUT_TRANSFORM,
+    HAPI_INPUT_GEOMETRY,
+    HAPI_INPUT_MAX
+};
+
+struct HAPI_CookOptions
+{
+    HAPI_Bool           splitGeosByGroup;
+    int                 maxVerticesPerPrimitive;
+    HAPI_Bool           refineCurveToLinear;
+    float               curveRefineLOD;
+    HAPI_Bool           clearErrorsAndWarnings;
+};
+
+struct HAPI_AssetInfo
+{
+    HAPI_AssetId        id;
+    int                 type;
+    int                 subType;
+    int                 validationId;
+    HAPI_NodeId         nodeId;
+    HAPI_NodeId         objectNodeId;
+    HAPI_Bool           hasEverCooked;
+    HAPI_StringHandle   nameSH;
+    HAPI_StringHandle   labelSH;
+    HAPI_StringHandle   filePathSH;
+    HAPI_StringHandle   versionSH;
+    HAPI_StringHandle   fullOpNameSH;
+    HAPI_StringHandle   helpTextSH;
+    int                 objectCount;
+    int                 handleCount;
+    int                 transformInputCount;
+    int                 geoInputCount;
+    HAPI_Bool           haveObjectsChanged;
+    HAPI_Bool           haveMaterialsChanged;
+};
+
+struct HAPI_NodeInfo
+{
+    HAPI_NodeId         id;
+    HAPI_AssetId        assetId;
+    HAPI_StringHandle   nameSH;
+    int                 totalCookCount;
+    int                 uniqueHoudiniNodeId;
+    HAPI_StringHandle   internalNodePathSH;
+    int                 parmCount;
+    int                 parmIntValueCount;
+    int                 parmFloatValueCount;
+    int                 parmStringValueCount;
+    int                 parmChoiceCount;
+};
+
+struct HAPI_ParmInfo
+{
+    HAPI_ParmId         id;
+    HAPI_ParmId         parentId;
+    HAPI_ParmType       type;
+    HAPI_StringHandle   typeInfoSH;
+    int                 permissions;
+    int                 size;
+    int                 choiceCount;
+    HAPI_Bool           hasMin;
+    HAPI_Bool           hasMax;
+    HAPI_Bool           hasUIMin;
+    HAPI_Bool           hasUIMax;
+    float               min;
+    float               max;
+    float               UIMin;
+    float               UIMax;
+    HAPI_Bool           invisible;
+    HAPI_Bool           disabled;
+    HAPI_Bool           spare;
+    HAPI_Bool           joinNext;
+    HAPI_Bool           labelNone;
+    int                 intValuesIndex;
+    int                 floatValuesIndex;
+    int                 stringValuesIndex;
+    int                 choiceIndex;
+    HAPI_Bool           isChildOfMultiParm;
+    int                 instanceNum;
+    int                 instanceLength;
+    int                 instanceCount;
+    int                 instanceStartOffset;
+    int                 rampType;
+    HAPI_StringHandle   nameSH;
+    HAPI_StringHandle   labelSH;
+    HAPI_StringHandle   templateNameSH;
+    HAPI_StringHandle   helpSH;
+};
+
+struct HAPI_ParmChoiceInfo
+{
+    HAPI_ParmId         parentParmId;
+    HAPI_StringHandle   labelSH;
+    HAPI_StringHandle   valueSH;
+};
+
+struct HAPI_ObjectInfo
+{
+    HAPI_ObjectId       id;
+    HAPI_StringHandle   nameSH;
+    HAPI_StringHandle   objectInstancePathSH;
+    HAPI_Bool           hasTransformChanged;
+    HAPI_Bool           haveGeosChanged;
+    HAPI_Bool           isVisible;
+    HAPI_Bool           isInstancer;
+    int                 geoCount;
+    HAPI_NodeId         nodeId;
+    HAPI_ObjectId       objectToInstanceId;
+};
+
+struct HAPI_GeoInfo
+{
+    HAPI_GeoId          id;
+    int                 type;
+    HAPI_StringHandle   nameSH;
+    HAPI_NodeId         nodeId;
+    HAPI_Bool           isEditable;
+    HAPI_Bool           isTemplated;
+    HAPI_Bool           isDisplayGeo;
+    HAPI_Bool           hasGeoChanged;
+    HAPI_Bool           hasMaterialChanged;
+    int                 pointGroupCount;
+    int                 primitiveGroupCount;
+    int                 partCount;
+};
+
+struct HAPI_PartInfo
+{
+    HAPI_PartId         id;
+    HAPI_StringHandle   nameSH;
+    int                 faceCount;
+    int                 vertexCount;
+    int                 pointCount;
+    int                 pointAttributeCount;
+    int                 faceAttributeCount;
+    int                 vertexAttributeCount;
+    int                 detailAttributeCount;
+    HAPI_Bool           isInstanced;
+    int                 instancedPartCount;
+    int                 instanceCount;
+    HAPI_Bool           hasVolume;
+    HAPI_Bool           isCurve;
+};
+
+struct HAPI_AttributeInfo
+{
+    HAPI_Bool           exists;
+    HAPI_AttributeOwner owner;
+    HAPI_StorageType    storage;
+    HAPI_AttributeOwner originalOwner;
+    int                 count;
+    int                 tupleSize;
+};
+
+struct HAPI_TransformEuler
+{
+    float               position[3];
+    float               rotationEuler[3];
+    float               scale[3];
+    HAPI_XYZOrder       rotationOrder;
+    HAPI_RSTOrder       rstOrder;
+};
+
+struct HAPI_Transform
+{
+    float               position[3];
+    float               rotationQuaternion[4];
+    float               scale[3];
+    HAPI_RSTOrder       rstOrder;
+};
+
+HAPI_CookOptions HAPI_CookOptions_Create();
+
+//----------------------------------------------------------------------------
+// Sessions and status:
+
+HAPI_Result HAPI_IsInitialized();
+HAPI_Result HAPI_Initialize( const char * otl_search_path,
+                             const char * dso_search_path,
+                             const HAPI_CookOptions * cook_options,
+                             HAPI_Bool use_cooking_thread,
+                             int cooking_thread_stack_size );
+HAPI_Result HAPI_Cleanup();
+
+HAPI_Result HAPI_GetStatus( HAPI_StatusType status_type, int * status );
+HAPI_Result HAPI_GetStatusStringBufLength( HAPI_StatusType status_type,
+                                           HAPI_StatusVerbosity verbosity,
+                                           int * buffer_size );
+HAPI_Result HAPI_GetStatusString( HAPI_StatusType status_type, char * buffer );
+HAPI_Result HAPI_GetCookingTotalCount( int * count );
+HAPI_Result HAPI_GetCookingCurrentCount( int * count );
+HAPI_Result HAPI_Interrupt();
+
+//----------------------------------------------------------------------------
+// Strings:
+
+HAPI_Result HAPI_GetStringBufLength( HAPI_StringHandle string_handle, int * buffer_length );
+HAPI_Result HAPI_GetString( HAPI_StringHandle string_handle, char * string_value,
+                            int buffer_length );
+
+//----------------------------------------------------------------------------
+// Assets:
+
+HAPI_Result HAPI_LoadAssetLibraryFromFile( const char * file_path,
+                                           HAPI_Bool allow_overwrite,
+                                           HAPI_AssetLibraryId * library_id );
+HAPI_Result HAPI_LoadAssetLibraryFromMemory( const char * library_buffer,
+                                             int library_buffer_size,
+                                             HAPI_Bool allow_overwrite,
+                                             HAPI_AssetLibraryId * library_id );
+HAPI_Result HAPI_GetAvailableAssetCount( HAPI_AssetLibraryId library_id, int * asset_count );
+HAPI_Result HAPI_GetAvailableAssets( HAPI_AssetLibraryId library_id,
+                                     HAPI_StringHandle * asset_names_array,
+                                     int asset_count );
+HAPI_Result HAPI_InstantiateAsset( const char * asset_name, HAPI_Bool cook_on_load,
+                                   HAPI_AssetId * asset_id );
+HAPI_Result HAPI_DestroyAsset( HAPI_AssetId asset_id );
+HAPI_Result HAPI_GetAssetInfo( HAPI_AssetId asset_id, HAPI_AssetInfo * asset_info );
+HAPI_Result HAPI_CookAsset( HAPI_AssetId asset_id, const HAPI_CookOptions * cook_options );
+HAPI_Result HAPI_IsAssetValid( HAPI_AssetId asset_id, int asset_validation_id,
+                               int * answer );
+HAPI_Result HAPI_GetAssetTransform( HAPI_AssetId asset_id, HAPI_RSTOrder rst_order,
+                                    HAPI_XYZOrder rot_order,
+                                    HAPI_TransformEuler * transform );
+HAPI_Result HAPI_ConvertTransformEulerToMatrix( const HAPI_TransformEuler * transform,
+                                                float * matrix );
+HAPI_Result HAPI_ConvertTransformQuatToMatrix( const HAPI_Transform * transform,
+                                               float * matrix );
+HAPI_Result HAPI_GetInputName( HAPI_AssetId asset_id, int input_idx, int input_type,
+                               HAPI_StringHandle * name );
+
+//----------------------------------------------------------------------------
+// Nodes and parms:
+
+HAPI_Result HAPI_GetNodeInfo( HAPI_NodeId node_id, HAPI_NodeInfo * node_info );
+HAPI_Result HAPI_GetParameters( HAPI_NodeId node_id, HAPI_ParmInfo * parm_infos,
+                                int start, int length );
+HAPI_Result HAPI_GetParmIntValues( HAPI_NodeId node_id, int * values,
+                                   int start, int length );
+HAPI_Result HAPI_GetParmFloatValues( HAPI_NodeId node_id, float * values,
+                                     int start, int length );
+HAPI_Result HAPI_GetParmStringValues( HAPI_NodeId node_id, HAPI_Bool evaluate,
+                                      HAPI_StringHandle * values,
+                                      int start, int length );
+HAPI_Result HAPI_GetParmChoiceLists( HAPI_NodeId node_id,
+                                     HAPI_ParmChoiceInfo * parm_choices,
+                                     int start, int length );
+HAPI_Result HAPI_SetParmIntValues( HAPI_NodeId node_id, const int * values,
+                                   int start, int length );
+HAPI_Result HAPI_SetParmFloatValues( HAPI_NodeId node_id, const float * values,
+                                     int start, int length );
+HAPI_Result HAPI_SetParmStringValue( HAPI_NodeId node_id, const char * value,
+                                     HAPI_ParmId parm_id, int index );
+HAPI_Result HAPI_InsertMultiparmInstance( HAPI_NodeId node_id, HAPI_ParmId parm_id,
+                                          int instance_position );
+HAPI_Result HAPI_RemoveMultiparmInstance( HAPI_NodeId node_id, HAPI_ParmId parm_id,
+                                          int instance_position );
+
+//----------------------------------------------------------------------------
+// Objects, geos and parts:
+
+HAPI_Result HAPI_GetObjects( HAPI_AssetId asset_id, HAPI_ObjectInfo * object_infos,
+                             int start, int length );
+HAPI_Result HAPI_GetObjectTransforms( HAPI_AssetId asset_id, HAPI_RSTOrder rst_order,
+                                      HAPI_Transform * transforms,
+                                      int start, int length );
+HAPI_Result HAPI_GetGeoInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                             HAPI_GeoId geo_id, HAPI_GeoInfo * geo_info );
+HAPI_Result HAPI_GetPartInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                              HAPI_GeoId geo_id, HAPI_PartId part_id,
+                              HAPI_PartInfo * part_info );
+HAPI_Result HAPI_GetFaceCounts( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                int * face_counts, int start, int length );
+HAPI_Result HAPI_GetVertexList( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                int * vertex_list, int start, int length );
+HAPI_Result HAPI_GetAttributeInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                   HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                   const char * name, HAPI_AttributeOwner owner,
+                                   HAPI_AttributeInfo * attr_info );
+HAPI_Result HAPI_GetAttributeNames( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                    HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                    HAPI_AttributeOwner owner,
+                                    HAPI_StringHandle * attribute_names_array,
+                                    int count );
+HAPI_Result HAPI_GetAttributeIntData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                      HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                      const char * name, HAPI_AttributeInfo * attr_info,
+                                      int * data, int start, int length );
+HAPI_Result HAPI_GetAttributeFloatData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                        HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                        const char * name, HAPI_AttributeInfo * attr_info,
+                                        float * data, int start, int length );
+HAPI_Result HAPI_GetAttributeStringData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                         HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                         const char * name, HAPI_AttributeInfo * attr_info,
+                                         HAPI_StringHandle * data, int start, int length );
+
+#endif // HAPI_H
@@ -0,0 +1,1130 @@
+#include "hapistub.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define STUB_ASSET_NAME     "Stub::synthetic"
+#define STUB_ATTRIB_COUNT   (3)
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* const ATTRIB_NAMES[STUB_ATTRIB_COUNT] = { "P", "N", "uv" };
+
+struct StubAsset
+{
+    HAPI_AssetId                        id;
+    HAPI_NodeId                         node_id;
+    int                                 validation_id;
+    int                                 cook_count;
+    bool                                dirty;
+    std::string                         library_path;
+    HAPI_StubConfig                     config;
+
+    std::vector<HAPI_ParmInfo>          parms;
+    std::vector<HAPI_ParmChoiceInfo>    choices;
+    std::vector<int>                    ints;
+    std::vector<float>                  floats;
+    std::vector<HAPI_StringHandle>      strings;
+
+    // Change flags per object; reading an info resets its flags.
+    std::vector<char>                   transform_changed;
+    std::vector<char>                   geos_changed;
+    std::vector<char>                   geo_changed;
+
+    int                                 grid_width;
+    int                                 grid_height;
+};
+
+struct StubEngine
+{
+    StubEngine();
+
+    std::mutex                          mutex;
+    HAPI_StubConfig                     config;
+    bool                                initialized;
+    bool                                cooking_thread;
+    Clock::time_point                   cook_done;
+
+    std::vector<std::string>            strings;
+    std::unordered_map<std::string, HAPI_StringHandle> string_index;
+    std::map<HAPI_AssetLibraryId, std::string> libraries;
+    std::map<HAPI_AssetId, StubAsset>   assets;
+    std::map<HAPI_NodeId, HAPI_AssetId> nodes;
+    int                                 next_library_id;
+    int                                 next_asset_id;
+    int                                 next_validation_id;
+
+    std::string                         last_error;
+    long long                           calls;
+};
+
+static int EnvInt( const char* name, int fallback )
+{
+    const char* value = getenv( name );
+    return value && *value ? atoi( value ) : fallback;
+}
+
+StubEngine::StubEngine() :
+    initialized(false),
+    cooking_thread(false),
+    next_library_id(1),
+    next_asset_id(1),
+    next_validation_id(1),
+    calls(0)
+{
+    config.parm_count = EnvInt( "HAPI_STUB_PARMS", 100 );
+    config.folder_depth = EnvInt( "HAPI_STUB_FOLDER_DEPTH", 1 );
+    config.object_count = EnvInt( "HAPI_STUB_OBJECTS", 1 );
+    config.part_count = EnvInt( "HAPI_STUB_PARTS", 1 );
+    config.point_count = EnvInt( "HAPI_STUB_POINTS", 10000 );
+    config.call_latency_us = EnvInt( "HAPI_STUB_CALL_LATENCY_US", 0 );
+    config.cook_latency_us = EnvInt( "HAPI_STUB_COOK_LATENCY_US", 0 );
+
+    strings.push_back( std::string() );
+    string_index[ std::string() ] = 0;
+}
+
+static StubEngine& Engine()
+{
+    static StubEngine engine;
+    return engine;
+}
+
+static void Wait( int microseconds )
+{
+    if ( microseconds <= 0 )
+        return;
+
+    // Sleeping is too coarse for short latencies.
+    if ( microseconds >= 1000 )
+    {
+        std::this_thread::sleep_for( std::chrono::microseconds( microseconds ) );
+        return;
+    }
+    Clock::time_point end = Clock::now() + std::chrono::microseconds( microseconds );
+    while ( Clock::now() < end )
+        ;
+}
+
+// Held for the duration of every API call.
+class Call
+{
+public:
+    Call() : mLock( Engine().mutex )
+    {
+        ++Engine().calls;
+        Wait( Engine().config.call_latency_us );
+    }
+
+private:
+    std::unique_lock<std::mutex> mLock;
+};
+
+static HAPI_Result Fail( HAPI_Result result, const std::string& message )
+{
+    Engine().last_error = message;
+    return result;
+}
+
+static HAPI_Result Succeed()
+{
+    Engine().last_error.clear();
+    return HAPI_RESULT_SUCCESS;
+}
+
+static HAPI_StringHandle Intern( const std::string& text )
+{
+    StubEngine& engine = Engine();
+    std::unordered_map<std::string, HAPI_StringHandle>::const_iterator it = engine.string_index.find( text );
+    if ( it != engine.string_index.end() )
+        return it->second;
+
+    HAPI_StringHandle handle = HAPI_StringHandle( engine.strings.size() );
+    engine.strings.push_back( text );
+    engine.string_index[ text ] = handle;
+    return handle;
+}
+
+static bool InRange( int start, int length, size_t size )
+{
+    return start >= 0 && length >= 0 && size_t( start ) + size_t( length ) <= size;
+}
+
+//----------------------------------------------------------------------------
+// Synthetic assets:
+
+static int AddParm( StubAsset& asset, HAPI_ParmType type, int size, int parent_id,
+                    const std::string& name, const std::string& label )
+{
+    HAPI_ParmInfo info;
+    memset( &info, 0, sizeof(info) );
+    info.id = HAPI_ParmId( asset.parms.size() );
+    info.parentId = parent_id;
+    info.type = type;
+    info.size = size;
+    info.nameSH = Intern( name );
+    info.labelSH = Intern( label );
+    info.templateNameSH = info.nameSH;
+    info.helpSH = Intern( std::string() );
+    info.typeInfoSH = Intern( std::string() );
+    info.intValuesIndex = int( asset.ints.size() );
+    info.floatValuesIndex = int( asset.floats.size() );
+    info.stringValuesIndex = int( asset.strings.size() );
+    info.choiceIndex = -1;
+    info.instanceNum = -1;
+
+    switch ( type )
+    {
+    case HAPI_PARMTYPE_INT:
+    case HAPI_PARMTYPE_TOGGLE:
+        asset.ints.resize( asset.ints.size() + size );
+        break;
+    case HAPI_PARMTYPE_FLOAT:
+    case HAPI_PARMTYPE_COLOR:
+        asset.floats.resize( asset.floats.size() + size );
+        break;
+    case HAPI_PARMTYPE_STRING:
+        asset.strings.resize( asset.strings.size() + size );
+        break;
+    default:
+        break;
+    }
+
+    asset.parms.push_back( info );
+    return info.id;
+}
+
+// Value parms cycle through the kinds the parameter editors support.
+static void AddValueParm( StubAsset& asset, int parent_id, int index )
+{
+    char name[32];
+    char label[32];
+    snprintf( name, sizeof(name), "parm%d", index );
+    snprintf( label, sizeof(label), "Parm %d", index );
+
+    switch ( index % 6 )
+    {
+    case 0:
+    {
+        int id = AddParm( asset, HAPI_PARMTYPE_INT, 1, parent_id, name, label );
+        HAPI_ParmInfo& info = asset.parms[id];
+        info.hasUIMin = info.hasUIMax = 1;
+        info.UIMax = 10.f;
+        asset.ints[ info.intValuesIndex ] = index % 10;
+        break;
+    }
+    case 1:
+    {
+        int id = AddParm( asset, HAPI_PARMTYPE_FLOAT, 3, parent_id, name, label );
+        HAPI_ParmInfo& info = asset.parms[id];
+        info.hasUIMin = info.hasUIMax = 1;
+        info.UIMax = 1.f;
+        for ( int c = 0; c < 3; ++c )
+            asset.floats[ info.floatValuesIndex + c ] = 0.25f * c;
+        break;
+    }
+    case 2:
+    {
+        int id = AddParm( asset, HAPI_PARMTYPE_TOGGLE, 1, parent_id, name, label );
+        asset.ints[ asset.parms[id].intValuesIndex ] = index % 2;
+        break;
+    }
+    case 3:
+    {
+        int id = AddParm( asset, HAPI_PARMTYPE_STRING, 1, parent_id, name, label );
+        asset.strings[ asset.parms[id].stringValuesIndex ] = Intern( std::string( "value of " ) + name );
+        break;
+    }
+    case 4:
+    {
+        int id = AddParm( asset, HAPI_PARMTYPE_COLOR, 3, parent_id, name, label );
+        for ( int c = 0; c < 3; ++c )
+            asset.floats[ asset.parms[id].floatValuesIndex + c ] = 0.5f;
+        break;
+    }
+    default:
+    {
+        int id = AddParm( asset, HAPI_PARMTYPE_INT, 1, parent_id, name, label );
+        HAPI_ParmInfo& info = asset.parms[id];
+        info.choiceIndex = int( asset.choices.size() );
+        info.choiceCount = 4;
+        for ( int c = 0; c < info.choiceCount; ++c )
+        {
+            char choice[32];
+            HAPI_ParmChoiceInfo choice_info;
+            choice_info.parentParmId = id;
+            snprintf( choice, sizeof(choice), "Choice %d", c );
+            choice_info.labelSH = Intern( choice );
+            snprintf( choice, sizeof(choice), "choice%d", c );
+            choice_info.valueSH = Intern( choice );
+            asset.choices.push_back( choice_info );
+        }
+        break;
+    }
+    }
+}
+
+// count value parms under parent_id, split over depth levels of two-tab
+// folder lists. Folders come right after their list and before their
+// contents, as in Houdini.
+static void AddParms( StubAsset& asset, int parent_id, int depth, int count, int& next_index )
+{
+    if ( depth <= 0 || count < 2 )
+    {
+        for ( int i = 0; i < count; ++i )
+            AddValueParm( asset, parent_id, next_index++ );
+        return;
+    }
+
+    char name[32];
+    snprintf( name, sizeof(name), "folders%d", int( asset.parms.size() ) );
+    int list_id = AddParm( asset, HAPI_PARMTYPE_FOLDERLIST, 2, parent_id, name, "" );
+
+    int folders[2];
+    for ( int f = 0; f < 2; ++f )
+    {
+        snprintf( name, sizeof(name), "folder%d", int( asset.parms.size() ) );
+        folders[f] = AddParm( asset, HAPI_PARMTYPE_FOLDER, 0, list_id, name, f ? "Tab B" : "Tab A" );
+    }
+
+    AddParms( asset, folders[0], depth - 1, count / 2, next_index );
+    AddParms( asset, folders[1], depth - 1, count - count / 2, next_index );
+}
+
+static void BuildAsset( StubAsset& asset )
+{
+    const HAPI_StubConfig& config = asset.config;
+
+    int next_index = 0;
+    AddParms( asset, -1, config.folder_depth, config.parm_count, next_index );
+
+    // A folder's size is its number of children.
+    for ( size_t i = 0; i < asset.parms.size(); ++i )
+    {
+        int parent_id = asset.parms[i].parentId;
+        if ( parent_id >= 0 && asset.parms[ parent_id ].type == HAPI_PARMTYPE_FOLDER )
+            ++asset.parms[ parent_id ].size;
+    }
+
+    int objects = config.object_count > 0 ? config.object_count : 0;
+    asset.transform_changed.assign( objects, 1 );
+    asset.geos_changed.assign( objects, 1 );
+    asset.geo_changed.assign( objects, 1 );
+
+    asset.grid_width = std::max( 2, int( std::sqrt( double( std::max( config.point_count, 4 ) ) ) ) );
+    asset.grid_height = std::max( 2, ( config.point_count + asset.grid_width - 1 ) / asset.grid_width );
+}
+
+static StubAsset* FindAsset( HAPI_AssetId asset_id )
+{
+    std::map<HAPI_AssetId, StubAsset>::iterator it = Engine().assets.find( asset_id );
+    return it == Engine().assets.end() ? nullptr : &it->second;
+}
+
+static StubAsset* FindNode( HAPI_NodeId node_id )
+{
+    std::map<HAPI_NodeId, HAPI_AssetId>::const_iterator it = Engine().nodes.find( node_id );
+    return it == Engine().nodes.end() ? nullptr : FindAsset( it->second );
+}
+
+static bool ValidPart( const StubAsset& asset, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                       HAPI_PartId part_id )
+{
+    return object_id >= 0 && object_id < asset.config.object_count && geo_id == 0 &&
+           part_id >= 0 && part_id < asset.config.part_count;
+}
+
+static int PointCount( const StubAsset& asset )
+{
+    return asset.grid_width * asset.grid_height;
+}
+
+static int FaceCount( const StubAsset& asset )
+{
+    return ( asset.grid_width - 1 ) * ( asset.grid_height - 1 );
+}
+
+static int AttribIndex( const char* name )
+{
+    for ( int i = 0; i < STUB_ATTRIB_COUNT; ++i )
+        if ( name && strcmp( name, ATTRIB_NAMES[i] ) == 0 )
+            return i;
+    return -1;
+}
+
+// Row vectors, translation in the last row, scale then rotation then
+// translation; the order arguments are ignored.
+static void ComposeMatrix( const float rotation[9], const float* position, const float* scale,
+                           float* matrix )
+{
+    for ( int row = 0; row < 3; ++row )
+    {
+        for ( int column = 0; column < 3; ++column )
+            matrix[ row * 4 + column ] = scale[row] * rotation[ row * 3 + column ];
+        matrix[ row * 4 + 3 ] = 0.f;
+    }
+    for ( int column = 0; column < 3; ++column )
+        matrix[ 12 + column ] = position[column];
+    matrix[15] = 1.f;
+}
+
+};
+
+//----------------------------------------------------------------------------
+// Configuration:
+
+void HAPI_Stub_SetConfig( const HAPI_StubConfig * config )
+{
+    std::lock_guard<std::mutex> lock( Engine().mutex );
+    Engine().config = *config;
+}
+
+void HAPI_Stub_GetConfig( HAPI_StubConfig * config )
+{
+    std::lock_guard<std::mutex> lock( Engine().mutex );
+    *config = Engine().config;
+}
+
+long long HAPI_Stub_CallCount()
+{
+    std::lock_guard<std::mutex> lock( Engine().mutex );
+    return Engine().calls;
+}
+
+void HAPI_Stub_ResetCallCount()
+{
+    std::lock_guard<std::mutex> lock( Engine().mutex );
+    Engine().calls = 0;
+}
+
+//----------------------------------------------------------------------------
+// Sessions and status:
+
+HAPI_CookOptions HAPI_CookOptions_Create()
+{
+    HAPI_CookOptions options;
+    options.splitGeosByGroup = 1;
+    options.maxVerticesPerPrimitive = -1;
+    options.refineCurveToLinear = 0;
+    options.curveRefineLOD = 8.f;
+    options.clearErrorsAndWarnings = 0;
+    return options;
+}
+
+HAPI_Result HAPI_IsInitialized()
+{
+    Call call;
+    return Engine().initialized ? HAPI_RESULT_SUCCESS : HAPI_RESULT_NOT_INITIALIZED;
+}
+
+HAPI_Result HAPI_Initialize( const char *, const char *, const HAPI_CookOptions *,
+                             HAPI_Bool use_cooking_thread, int )
+{
+    Call call;
+    StubEngine& engine = Engine();
+    if ( engine.initialized )
+        return Fail( HAPI_RESULT_ALREADY_INITIALIZED, "already initialized" );
+
+    engine.initialized = true;
+    engine.cooking_thread = use_cooking_thread != 0;
+    engine.cook_done = Clock::now();
+    return Succeed();
+}
+
+HAPI_Result HAPI_Cleanup()
+{
+    Call call;
+    StubEngine& engine = Engine();
+    if ( !engine.initialized )
+        return Fail( HAPI_RESULT_NOT_INITIALIZED, "not initialized" );
+
+    engine.initialized = false;
+    engine.assets.clear();
+    engine.nodes.clear();
+    engine.libraries.clear();
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetStatus( HAPI_StatusType status_type, int * status )
+{
+    Call call;
+    StubEngine& engine = Engine();
+    switch ( status_type )
+    {
+    case HAPI_STATUS_COOK_STATE:
+        *status = engine.cooking_thread && Clock::now() < engine.cook_done ?
+                    HAPI_STATE_COOKING : HAPI_STATE_READY;
+        return HAPI_RESULT_SUCCESS;
+    case HAPI_STATUS_CALL_RESULT:
+        *status = engine.last_error.empty() ? HAPI_RESULT_SUCCESS : HAPI_RESULT_FAILURE;
+        return HAPI_RESULT_SUCCESS;
+    case HAPI_STATUS_COOK_RESULT:
+        *status = HAPI_RESULT_SUCCESS;
+        return HAPI_RESULT_SUCCESS;
+    default:
+        return HAPI_RESULT_INVALID_ARGUMENT;
+    }
+}
+
+HAPI_Result HAPI_GetStatusStringBufLength( HAPI_StatusType, HAPI_StatusVerbosity, int * buffer_size )
+{
+    Call call;
+    *buffer_size = int( Engine().last_error.size() ) + 1;
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_GetStatusString( HAPI_StatusType, char * buffer )
+{
+    Call call;
+    const std::string& message = Engine().last_error;
+    memcpy( buffer, message.c_str(), message.size() + 1 );
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_GetCookingTotalCount( int * count )
+{
+    Call call;
+    *count = Clock::now() < Engine().cook_done ? 1 : 0;
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_GetCookingCurrentCount( int * count )
+{
+    Call call;
+    *count = 0;
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_Interrupt()
+{
+    Call call;
+    Engine().cook_done = Clock::now();
+    return HAPI_RESULT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Strings:
+
+HAPI_Result HAPI_GetStringBufLength( HAPI_StringHandle string_handle, int * buffer_length )
+{
+    Call call;
+    if ( string_handle < 0 || size_t( string_handle ) >= Engine().strings.size() )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid string handle" );
+    *buffer_length = int( Engine().strings[ string_handle ].size() ) + 1;
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_GetString( HAPI_StringHandle string_handle, char * string_value, int buffer_length )
+{
+    Call call;
+    if ( string_handle < 0 || size_t( string_handle ) >= Engine().strings.size() )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid string handle" );
+
+    const std::string& text = Engine().strings[ string_handle ];
+    if ( buffer_length < int( text.size() ) + 1 )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "string buffer too small" );
+    memcpy( string_value, text.c_str(), text.size() + 1 );
+    return HAPI_RESULT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Assets:
+
+HAPI_Result HAPI_LoadAssetLibraryFromFile( const char * file_path, HAPI_Bool,
+                                           HAPI_AssetLibraryId * library_id )
+{
+    Call call;
+    StubEngine& engine = Engine();
+    if ( !engine.initialized )
+        return Fail( HAPI_RESULT_NOT_INITIALIZED, "not initialized" );
+
+    FILE* file = fopen( file_path, "rb" );
+    if ( !file )
+        return Fail( HAPI_RESULT_CANT_LOADFILE, std::string( "cannot open " ) + file_path );
+    fclose( file );
+
+    *library_id = engine.next_library_id++;
+    engine.libraries[ *library_id ] = file_path;
+    return Succeed();
+}
+
+HAPI_Result HAPI_LoadAssetLibraryFromMemory( const char * library_buffer, int library_buffer_size,
+                                             HAPI_Bool, HAPI_AssetLibraryId * library_id )
+{
+    Call call;
+    StubEngine& engine = Engine();
+    if ( !engine.initialized )
+        return Fail( HAPI_RESULT_NOT_INITIALIZED, "not initialized" );
+    if ( !library_buffer || library_buffer_size <= 0 )
+        return Fail( HAPI_RESULT_CANT_LOADFILE, "empty library buffer" );
+
+    *library_id = engine.next_library_id++;
+    engine.libraries[ *library_id ] = "<memory>";
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAvailableAssetCount( HAPI_AssetLibraryId library_id, int * asset_count )
+{
+    Call call;
+    if ( !Engine().libraries.count( library_id ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid library" );
+    *asset_count = 1;
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAvailableAssets( HAPI_AssetLibraryId library_id,
+                                     HAPI_StringHandle * asset_names_array, int asset_count )
+{
+    Call call;
+    if ( !Engine().libraries.count( library_id ) || asset_count != 1 )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid library" );
+    asset_names_array[0] = Intern( STUB_ASSET_NAME );
+    return Succeed();
+}
+
+HAPI_Result HAPI_InstantiateAsset( const char * asset_name, HAPI_Bool cook_on_load,
+                                   HAPI_AssetId * asset_id )
+{
+    Call call;
+    StubEngine& engine = Engine();
+    if ( !engine.initialized )
+        return Fail( HAPI_RESULT_NOT_INITIALIZED, "not initialized" );
+    if ( !asset_name || strcmp( asset_name, STUB_ASSET_NAME ) != 0 )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, std::string( "no asset named " ) +
+                     ( asset_name ? asset_name : "" ) );
+
+    StubAsset asset;
+    asset.id = engine.next_asset_id++;
+    asset.node_id = asset.id * 100;
+    asset.validation_id = engine.next_validation_id++;
+    asset.cook_count = 0;
+    asset.dirty = true;
+    asset.library_path = engine.libraries.empty() ? std::string() : engine.libraries.rbegin()->second;
+    asset.config = engine.config;
+    BuildAsset( asset );
+
+    engine.nodes[ asset.node_id ] = asset.id;
+    *asset_id = asset.id;
+    StubAsset& stored = engine.assets[ asset.id ];
+    stored = std::move( asset );
+    if ( cook_on_load )
+    {
+        stored.cook_count = 1;
+        stored.dirty = false;
+        Wait( engine.config.cook_latency_us );
+    }
+    return Succeed();
+}
+
+HAPI_Result HAPI_DestroyAsset( HAPI_AssetId asset_id )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid asset" );
+    Engine().nodes.erase( asset->node_id );
+    Engine().assets.erase( asset_id );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAssetInfo( HAPI_AssetId asset_id, HAPI_AssetInfo * asset_info )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid asset" );
+
+    memset( asset_info, 0, sizeof(*asset_info) );
+    asset_info->id = asset->id;
+    asset_info->validationId = asset->validation_id;
+    asset_info->nodeId = asset->node_id;
+    asset_info->objectNodeId = asset->node_id;
+    asset_info->hasEverCooked = asset->cook_count > 0;
+    asset_info->nameSH = Intern( STUB_ASSET_NAME );
+    asset_info->labelSH = Intern( "Synthetic" );
+    asset_info->filePathSH = Intern( asset->library_path );
+    asset_info->versionSH = Intern( "1.0" );
+    asset_info->fullOpNameSH = Intern( "Object/synthetic" );
+    asset_info->helpTextSH = Intern( std::string() );
+    asset_info->objectCount = asset->config.object_count;
+    return Succeed();
+}
+
+HAPI_Result HAPI_CookAsset( HAPI_AssetId asset_id, const HAPI_CookOptions * )
+{
+    Call call;
+    StubEngine& engine = Engine();
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid asset" );
+
+    if ( asset->dirty )
+    {
+        asset->geos_changed.assign( asset->geos_changed.size(), 1 );
+        asset->geo_changed.assign( asset->geo_changed.size(), 1 );
+        asset->dirty = false;
+    }
+    ++asset->cook_count;
+
+    if ( engine.cooking_thread )
+        engine.cook_done = Clock::now() + std::chrono::microseconds( engine.config.cook_latency_us );
+    else
+        Wait( engine.config.cook_latency_us );
+    return Succeed();
+}
+
+HAPI_Result HAPI_IsAssetValid( HAPI_AssetId asset_id, int asset_validation_id, int * answer )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    *answer = asset && asset->validation_id == asset_validation_id;
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_GetAssetTransform( HAPI_AssetId asset_id, HAPI_RSTOrder rst_order,
+                                    HAPI_XYZOrder rot_order, HAPI_TransformEuler * transform )
+{
+    Call call;
+    if ( !FindAsset( asset_id ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid asset" );
+
+    memset( transform, 0, sizeof(*transform) );
+    transform->scale[0] = transform->scale[1] = transform->scale[2] = 1.f;
+    transform->rotationOrder = rot_order;
+    transform->rstOrder = rst_order;
+    return Succeed();
+}
+
+HAPI_Result HAPI_ConvertTransformEulerToMatrix( const HAPI_TransformEuler * transform, float * matrix )
+{
+    Call call;
+    const float to_radians = 3.14159265f / 180.f;
+    float cx = std::cos( transform->rotationEuler[0] * to_radians );
+    float sx = std::sin( transform->rotationEuler[0] * to_radians );
+    float cy = std::cos( transform->rotationEuler[1] * to_radians );
+    float sy = std::sin( transform->rotationEuler[1] * to_radians );
+    float cz = std::cos( transform->rotationEuler[2] * to_radians );
+    float sz = std::sin( transform->rotationEuler[2] * to_radians );
+
+    // X, then Y, then Z, for row vectors.
+    float rotation[9] = {
+        cy * cz,                    cy * sz,                    -sy,
+        sx * sy * cz - cx * sz,     sx * sy * sz + cx * cz,     sx * cy,
+        cx * sy * cz + sx * sz,     cx * sy * sz - sx * cz,     cx * cy
+    };
+    ComposeMatrix( rotation, transform->position, transform->scale, matrix );
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_ConvertTransformQuatToMatrix( const HAPI_Transform * transform, float * matrix )
+{
+    Call call;
+    float x = transform->rotationQuaternion[0];
+    float y = transform->rotationQuaternion[1];
+    float z = transform->rotationQuaternion[2];
+    float w = transform->rotationQuaternion[3];
+
+    float rotation[9] = {
+        1 - 2 * ( y * y + z * z ),  2 * ( x * y + z * w ),      2 * ( x * z - y * w ),
+        2 * ( x * y - z * w ),      1 - 2 * ( x * x + z * z ),  2 * ( y * z + x * w ),
+        2 * ( x * z + y * w ),      2 * ( y * z - x * w ),      1 - 2 * ( x * x + y * y )
+    };
+    ComposeMatrix( rotation, transform->position, transform->scale, matrix );
+    return HAPI_RESULT_SUCCESS;
+}
+
+HAPI_Result HAPI_GetInputName( HAPI_AssetId asset_id, int input_idx, int,
+                               HAPI_StringHandle * name )
+{
+    Call call;
+    if ( !FindAsset( asset_id ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid asset" );
+
+    char text[32];
+    snprintf( text, sizeof(text), "Input %d", input_idx + 1 );
+    *name = Intern( text );
+    return Succeed();
+}
+
+//----------------------------------------------------------------------------
+// Nodes and parms:
+
+HAPI_Result HAPI_GetNodeInfo( HAPI_NodeId node_id, HAPI_NodeInfo * node_info )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid node" );
+
+    memset( node_info, 0, sizeof(*node_info) );
+    node_info->id = node_id;
+    node_info->assetId = asset->id;
+    node_info->nameSH = Intern( "synthetic" );
+    node_info->totalCookCount = asset->cook_count;
+    node_info->uniqueHoudiniNodeId = node_id;
+    node_info->internalNodePathSH = Intern( "/obj/synthetic" );
+    node_info->parmCount = int( asset->parms.size() );
+    node_info->parmIntValueCount = int( asset->ints.size() );
+    node_info->parmFloatValueCount = int( asset->floats.size() );
+    node_info->parmStringValueCount = int( asset->strings.size() );
+    node_info->parmChoiceCount = int( asset->choices.size() );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetParameters( HAPI_NodeId node_id, HAPI_ParmInfo * parm_infos, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->parms.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid parm range" );
+    if ( length )
+        memcpy( parm_infos, &asset->parms[ start ], length * sizeof(HAPI_ParmInfo) );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetParmIntValues( HAPI_NodeId node_id, int * values, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->ints.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid int value range" );
+    if ( length )
+        memcpy( values, &asset->ints[ start ], length * sizeof(int) );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetParmFloatValues( HAPI_NodeId node_id, float * values, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->floats.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid float value range" );
+    if ( length )
+        memcpy( values, &asset->floats[ start ], length * sizeof(float) );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetParmStringValues( HAPI_NodeId node_id, HAPI_Bool, HAPI_StringHandle * values,
+                                      int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->strings.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid string value range" );
+    if ( length )
+        memcpy( values, &asset->strings[ start ], length * sizeof(HAPI_StringHandle) );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetParmChoiceLists( HAPI_NodeId node_id, HAPI_ParmChoiceInfo * parm_choices,
+                                     int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->choices.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid choice range" );
+    if ( length )
+        memcpy( parm_choices, &asset->choices[ start ], length * sizeof(HAPI_ParmChoiceInfo) );
+    return Succeed();
+}
+
+HAPI_Result HAPI_SetParmIntValues( HAPI_NodeId node_id, const int * values, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->ints.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid int value range" );
+    if ( length )
+        memcpy( &asset->ints[ start ], values, length * sizeof(int) );
+    asset->dirty = true;
+    return Succeed();
+}
+
+HAPI_Result HAPI_SetParmFloatValues( HAPI_NodeId node_id, const float * values, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || !InRange( start, length, asset->floats.size() ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid float value range" );
+    if ( length )
+        memcpy( &asset->floats[ start ], values, length * sizeof(float) );
+    asset->dirty = true;
+    return Succeed();
+}
+
+HAPI_Result HAPI_SetParmStringValue( HAPI_NodeId node_id, const char * value, HAPI_ParmId parm_id,
+                                     int index )
+{
+    Call call;
+    StubAsset* asset = FindNode( node_id );
+    if ( !asset || parm_id < 0 || size_t( parm_id ) >= asset->parms.size() )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid parm" );
+
+    const HAPI_ParmInfo& info = asset->parms[ parm_id ];
+    if ( info.type != HAPI_PARMTYPE_STRING || index < 0 || index >= info.size || !value )
+        return Fail( HAPI_RESULT_PARM_SET_FAILED, "not a string parm" );
+
+    asset->strings[ info.stringValuesIndex + index ] = Intern( value );
+    asset->dirty = true;
+    return Succeed();
+}
+
+HAPI_Result HAPI_InsertMultiparmInstance( HAPI_NodeId, HAPI_ParmId, int )
+{
+    Call call;
+    return Fail( HAPI_RESULT_INVALID_ARGUMENT, "synthetic assets have no multiparms" );
+}
+
+HAPI_Result HAPI_RemoveMultiparmInstance( HAPI_NodeId, HAPI_ParmId, int )
+{
+    Call call;
+    return Fail( HAPI_RESULT_INVALID_ARGUMENT, "synthetic assets have no multiparms" );
+}
+
+//----------------------------------------------------------------------------
+// Objects, geos and parts:
+
+HAPI_Result HAPI_GetObjects( HAPI_AssetId asset_id, HAPI_ObjectInfo * object_infos,
+                             int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || !InRange( start, length, size_t( asset->config.object_count ) ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid object range" );
+
+    for ( int i = 0; i < length; ++i )
+    {
+        int object_id = start + i;
+        char name[32];
+        snprintf( name, sizeof(name), "object%d", object_id );
+
+        HAPI_ObjectInfo& info = object_infos[i];
+        memset( &info, 0, sizeof(info) );
+        info.id = object_id;
+        info.nameSH = Intern( name );
+        info.objectInstancePathSH = Intern( std::string() );
+        info.hasTransformChanged = asset->transform_changed[ object_id ];
+        info.haveGeosChanged = asset->geos_changed[ object_id ];
+        info.isVisible = 1;
+        info.geoCount = 1;
+        info.nodeId = asset->node_id + 1 + object_id;
+        info.objectToInstanceId = -1;
+
+        asset->transform_changed[ object_id ] = 0;
+        asset->geos_changed[ object_id ] = 0;
+    }
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetObjectTransforms( HAPI_AssetId asset_id, HAPI_RSTOrder rst_order,
+                                      HAPI_Transform * transforms, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || !InRange( start, length, size_t( asset->config.object_count ) ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid object range" );
+
+    // Objects side by side along x.
+    for ( int i = 0; i < length; ++i )
+    {
+        HAPI_Transform& transform = transforms[i];
+        memset( &transform, 0, sizeof(transform) );
+        transform.position[0] = 2.f * ( start + i );
+        transform.rotationQuaternion[3] = 1.f;
+        transform.scale[0] = transform.scale[1] = transform.scale[2] = 1.f;
+        transform.rstOrder = rst_order;
+    }
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetGeoInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                             HAPI_GeoInfo * geo_info )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || object_id < 0 || object_id >= asset->config.object_count || geo_id != 0 )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid geo" );
+
+    memset( geo_info, 0, sizeof(*geo_info) );
+    geo_info->id = geo_id;
+    geo_info->nameSH = Intern( "geo" );
+    geo_info->nodeId = asset->node_id + 1 + object_id;
+    geo_info->isDisplayGeo = 1;
+    geo_info->hasGeoChanged = asset->geo_changed[ object_id ];
+    geo_info->partCount = asset->config.part_count;
+
+    asset->geo_changed[ object_id ] = 0;
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetPartInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                              HAPI_PartId part_id, HAPI_PartInfo * part_info )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || !ValidPart( *asset, object_id, geo_id, part_id ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid part" );
+
+    char name[32];
+    snprintf( name, sizeof(name), "part%d", part_id );
+
+    memset( part_info, 0, sizeof(*part_info) );
+    part_info->id = part_id;
+    part_info->nameSH = Intern( name );
+    part_info->faceCount = FaceCount( *asset );
+    part_info->vertexCount = FaceCount( *asset ) * 4;
+    part_info->pointCount = PointCount( *asset );
+    part_info->pointAttributeCount = STUB_ATTRIB_COUNT;
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetFaceCounts( HAPI_AssetId asset_id, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                                HAPI_PartId part_id, int * face_counts, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || !ValidPart( *asset, object_id, geo_id, part_id ) ||
+         !InRange( start, length, size_t( FaceCount( *asset ) ) ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid face range" );
+
+    for ( int i = 0; i < length; ++i )
+        face_counts[i] = 4;
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetVertexList( HAPI_AssetId asset_id, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                                HAPI_PartId part_id, int * vertex_list, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || !ValidPart( *asset, object_id, geo_id, part_id ) ||
+         !InRange( start, length, size_t( FaceCount( *asset ) ) * 4 ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid vertex range" );
+
+    static const int corner_x[4] = { 0, 1, 1, 0 };
+    static const int corner_y[4] = { 0, 0, 1, 1 };
+    int width = asset->grid_width;
+    for ( int i = 0; i < length; ++i )
+    {
+        int vertex = start + i;
+        int face = vertex / 4;
+        int corner = vertex % 4;
+        int x = face % ( width - 1 ) + corner_x[ corner ];
+        int y = face / ( width - 1 ) + corner_y[ corner ];
+        vertex_list[i] = y * width + x;
+    }
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAttributeInfo( HAPI_AssetId asset_id, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                                   HAPI_PartId part_id, const char * name, HAPI_AttributeOwner owner,
+                                   HAPI_AttributeInfo * attr_info )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    if ( !asset || !ValidPart( *asset, object_id, geo_id, part_id ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid part" );
+
+    memset( attr_info, 0, sizeof(*attr_info) );
+    if ( owner != HAPI_ATTROWNER_POINT || AttribIndex( name ) < 0 )
+    {
+        attr_info->owner = HAPI_ATTROWNER_INVALID;
+        attr_info->storage = HAPI_STORAGETYPE_INVALID;
+        attr_info->originalOwner = HAPI_ATTROWNER_INVALID;
+        return Succeed();
+    }
+
+    attr_info->exists = 1;
+    attr_info->owner = owner;
+    attr_info->storage = HAPI_STORAGETYPE_FLOAT;
+    attr_info->originalOwner = owner;
+    attr_info->count = PointCount( *asset );
+    attr_info->tupleSize = 3;
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAttributeNames( HAPI_AssetId asset_id, HAPI_ObjectId object_id, HAPI_GeoId geo_id,
+                                    HAPI_PartId part_id, HAPI_AttributeOwner owner,
+                                    HAPI_StringHandle * attribute_names_array, int count )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    int available = owner == HAPI_ATTROWNER_POINT ? STUB_ATTRIB_COUNT : 0;
+    if ( !asset || !ValidPart( *asset, object_id, geo_id, part_id ) || count < 0 || count > available )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid attribute name range" );
+
+    for ( int i = 0; i < count; ++i )
+        attribute_names_array[i] = Intern( ATTRIB_NAMES[i] );
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAttributeIntData( HAPI_AssetId, HAPI_ObjectId, HAPI_GeoId, HAPI_PartId,
+                                      const char *, HAPI_AttributeInfo *, int *, int, int )
+{
+    Call call;
+    return Fail( HAPI_RESULT_INVALID_ARGUMENT, "synthetic assets have no int attributes" );
+}
+
+HAPI_Result HAPI_GetAttributeFloatData( HAPI_AssetId asset_id, HAPI_ObjectId object_id,
+                                        HAPI_GeoId geo_id, HAPI_PartId part_id,
+                                        const char * name, HAPI_AttributeInfo * attr_info,
+                                        float * data, int start, int length )
+{
+    Call call;
+    StubAsset* asset = FindAsset( asset_id );
+    int attrib = AttribIndex( name );
+    if ( !asset || !ValidPart( *asset, object_id, geo_id, part_id ) || attrib < 0 ||
+         attr_info->owner != HAPI_ATTROWNER_POINT || attr_info->tupleSize != 3 ||
+         !InRange( start, length, size_t( PointCount( *asset ) ) ) )
+        return Fail( HAPI_RESULT_INVALID_ARGUMENT, "invalid attribute range" );
+
+    // A unit grid per part, parts stacked along y.
+    int width = asset->grid_width;
+    float scale_x = 1.f / float( width - 1 );
+    float scale_y = 1.f / float( asset->grid_height - 1 );
+    for ( int i = 0; i < length; ++i )
+    {
+        int point = start + i;
+        float u = float( point % width ) * scale_x;
+        float v = float( point / width ) * scale_y;
+        float* value = data + i * 3;
+        switch ( attrib )
+        {
+        case 0:
+            value[0] = u;
+            value[1] = float( part_id );
+            value[2] = v;
+            break;
+        case 1:
+            value[0] = 0.f;
+            value[1] = 1.f;
+            value[2] = 0.f;
+            break;
+        default:
+            value[0] = u;
+            value[1] = v;
+            value[2] = 0.f;
+            break;
+        }
+    }
+    return Succeed();
+}
+
+HAPI_Result HAPI_GetAttributeStringData( HAPI_AssetId, HAPI_ObjectId, HAPI_GeoId, HAPI_PartId,
+                                         const char *, HAPI_AttributeInfo *, HAPI_StringHandle *,
+                                         int, int )
+{
+    Call call;
+    return Fail( HAPI_RESULT_INVALID_ARGUMENT, "synthetic assets have no string attributes" );
+}
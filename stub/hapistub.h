@@ -0,0 +1,44 @@
+#ifndef HAPISTUB_H
+#define HAPISTUB_H
+
+#include <HAPI/HAPI.h>
+
+//----------------------------------------------------------------------------
+// Stub Houdini Engine:
+//
+// Every asset library holds one asset, "Stub::synthetic", whose shape is
+// set by the configuration below. Parms cycle through int, float, toggle,
+// string, color and menu parms and are spread evenly over a tree of tab
+// folders. Every object has one geo with part_count grid parts of about
+// point_count points each, carrying P, N and uv point attributes.
+//
+// Engine state is guarded by one lock, as in Houdini Engine, so calls from
+// several threads serialize. Every call spins for call_latency_us inside
+// the lock; a cook additionally takes cook_latency_us, in the background
+// when the engine was initialized with a cooking thread.
+//
+// The initial configuration is read from HAPI_STUB_PARMS,
+// HAPI_STUB_FOLDER_DEPTH, HAPI_STUB_OBJECTS, HAPI_STUB_PARTS,
+// HAPI_STUB_POINTS, HAPI_STUB_CALL_LATENCY_US and HAPI_STUB_COOK_LATENCY_US
+// when set.
+
+struct HAPI_StubConfig
+{
+    int     parm_count;         // value parms, folders not included
+    int     folder_depth;       // levels of two-tab folder lists
+    int     object_count;
+    int     part_count;         // parts per geo
+    int     point_count;        // points per part
+    int     call_latency_us;
+    int     cook_latency_us;
+};
+
+// Applies to assets instantiated afterwards.
+void        HAPI_Stub_SetConfig( const HAPI_StubConfig * config );
+void        HAPI_Stub_GetConfig( HAPI_StubConfig * config );
+
+// Number of HAPI calls served since the last reset.
+long long   HAPI_Stub_CallCount();
+void        HAPI_Stub_ResetCallCount();
+
+#endif // HAPISTUB_H
@@ -0,0 +1,157 @@
+#include "sweepfile.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace hapi {
+
+static std::string Trim( const std::string& text )
+{
+    size_t begin = text.find_first_not_of( " \t\r" );
+    if ( begin == std::string::npos )
+        return std::string();
+    size_t end = text.find_last_not_of( " \t\r" );
+    return text.substr( begin, end - begin + 1 );
+}
+
+// Split on commas outside of double quotes; quotes are removed.
+static bool SplitComponents( const std::string& text, std::vector<std::string>& result )
+{
+    std::string current;
+    bool quoted = false;
+    bool was_quoted = false;
+
+    for ( size_t i = 0; i < text.size(); ++i )
+    {
+        char c = text[i];
+        if ( c == '"' )
+        {
+            // Only the whitespace before the opening quote can be dropped.
+            if ( !was_quoted )
+                current.clear();
+            quoted = !quoted;
+            was_quoted = true;
+        }
+        else if ( c == ',' && !quoted )
+        {
+            result.push_back( was_quoted ? current : Trim( current ) );
+            current.clear();
+            was_quoted = false;
+        }
+        else if ( quoted || was_quoted == false )
+        {
+            current += c;
+        }
+    }
+    if ( quoted )
+        return false;
+
+    result.push_back( was_quoted ? current : Trim( current ) );
+    return true;
+}
+
+bool SweepFile::fail( int line, const std::string& message )
+{
+    std::ostringstream stream;
+    stream << "line " << line << ": " << message;
+    mError = stream.str();
+    mVariations.clear();
+    return false;
+}
+
+bool SweepFile::load( const std::string& path )
+{
+    std::ifstream in( path.c_str() );
+    if ( !in )
+    {
+        mError = "cannot open " + path;
+        return false;
+    }
+
+    std::ostringstream text;
+    text << in.rdbuf();
+    return parse( text.str() );
+}
+
+bool SweepFile::parse( const std::string& text )
+{
+    mVariations.clear();
+    mError.clear();
+
+    std::vector<SweepValue> base;
+    std::vector<SweepValue>* target = &base;
+
+    std::istringstream in( text );
+    std::string raw;
+    int line = 0;
+    while ( std::getline( in, raw ) )
+    {
+        ++line;
+        std::string entry = Trim( raw );
+        if ( entry.empty() || entry[0] == '#' )
+            continue;
+
+        if ( entry[0] == '[' )
+        {
+            if ( entry[ entry.size() - 1 ] != ']' )
+                return fail( line, "unterminated section name" );
+
+            SweepVariation variation;
+            variation.name = Trim( entry.substr( 1, entry.size() - 2 ) );
+            if ( variation.name.empty() )
+                return fail( line, "empty section name" );
+
+            // Shared assignments come first so the section can override them.
+            variation.values = base;
+            mVariations.push_back( variation );
+            target = &mVariations.back().values;
+            continue;
+        }
+
+        size_t equals = entry.find( '=' );
+        if ( equals == std::string::npos )
+            return fail( line, "expected parm = value" );
+
+        SweepValue value;
+        value.parm = Trim( entry.substr( 0, equals ) );
+        value.sub_index = 0;
+        value.line = line;
+
+        size_t bracket = value.parm.find( '[' );
+        if ( bracket != std::string::npos )
+        {
+            if ( value.parm[ value.parm.size() - 1 ] != ']' )
+                return fail( line, "unterminated component index" );
+
+            std::string index = value.parm.substr( bracket + 1, value.parm.size() - bracket - 2 );
+            char* end = nullptr;
+            long sub_index = strtol( index.c_str(), &end, 10 );
+            if ( index.empty() || *end != '\0' || sub_index < 0 )
+                return fail( line, "bad component index '" + index + "'" );
+
+            value.sub_index = int( sub_index );
+            value.parm = Trim( value.parm.substr( 0, bracket ) );
+        }
+        if ( value.parm.empty() )
+            return fail( line, "missing parm name" );
+
+        if ( !SplitComponents( Trim( entry.substr( equals + 1 ) ), value.components ) )
+            return fail( line, "unterminated string" );
+        if ( bracket != std::string::npos && value.components.size() != 1 )
+            return fail( line, "an indexed assignment takes one value" );
+
+        target->push_back( value );
+    }
+
+    // A file without sections is a single variation.
+    if ( mVariations.empty() )
+    {
+        SweepVariation variation;
+        variation.name = "default";
+        variation.values = base;
+        mVariations.push_back( variation );
+    }
+    return true;
+}
+
+};
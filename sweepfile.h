@@ -0,0 +1,62 @@
+#ifndef SWEEPFILE_H
+#define SWEEPFILE_H
+
+#include <string>
+#include <vector>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Parameter sweep file:
+
+// One assignment: parm = v0, v1, ... sets every component starting at
+// sub_index, parm[i] = v sets component i only.
+struct SweepValue
+{
+    std::string                 parm;
+    int                         sub_index;
+    std::vector<std::string>    components;
+    int                         line;
+};
+
+struct SweepVariation
+{
+    std::string                 name;
+    std::vector<SweepValue>     values;
+};
+
+// Text file of parameter sets:
+//
+//     # assignments before the first section apply to every variation
+//     scale = 2.5
+//
+//     [small]
+//     size = 1, 1, 1
+//     divisions[0] = 4
+//
+//     [large]
+//     size = 10, 10, 10
+//     label = "big box"
+//
+// Values are typed by the parm they are applied to. Strings may be quoted to
+// keep commas or surrounding spaces.
+class SweepFile
+{
+public:
+    bool            load( const std::string& path );
+    bool            parse( const std::string& text );
+
+    const std::vector<SweepVariation>& variations() const { return mVariations; }
+    const std::string& error() const { return mError; }
+
+private:
+    bool            fail( int line, const std::string& message );
+
+    std::vector<SweepVariation> mVariations;
+    std::string                 mError;
+};
+
+}
+
+#endif // SWEEPFILE_H
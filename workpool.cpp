@@ -0,0 +1,131 @@
+#include "workpool.h"
+#include <algorithm>
+
+namespace hapi {
+
+WorkPool::WorkPool( int thread_count ) :
+    mQueued(0), mPending(0), mStolen(0), mNext(0), mStop(false)
+{
+    if ( thread_count <= 0 )
+        thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+
+    for ( int i = 0; i < thread_count; ++i )
+        mQueues.push_back( std::unique_ptr<Queue>( new Queue ) );
+    for ( int i = 0; i < thread_count; ++i )
+        mThreads.push_back( std::thread( &WorkPool::run, this, i ) );
+}
+
+WorkPool::~WorkPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mStop = true;
+    }
+    mWake.notify_all();
+    for ( size_t i = 0; i < mThreads.size(); ++i )
+        mThreads[i].join();
+}
+
+void WorkPool::submit( const Task& task )
+{
+    ++mPending;
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        ++mQueued;
+    }
+
+    Queue& queue = *mQueues[ mNext++ % mQueues.size() ];
+    {
+        std::lock_guard<std::mutex> lock( queue.mutex );
+        queue.tasks.push_back( task );
+    }
+    mWake.notify_one();
+}
+
+bool WorkPool::pop( int worker, Task& task )
+{
+    {
+        Queue& own = *mQueues[worker];
+        std::lock_guard<std::mutex> lock( own.mutex );
+        if ( !own.tasks.empty() )
+        {
+            task = std::move( own.tasks.back() );
+            own.tasks.pop_back();
+            --mQueued;
+            return true;
+        }
+    }
+
+    int count = int( mQueues.size() );
+    for ( int i = 1; i < count; ++i )
+    {
+        Queue& victim = *mQueues[ (worker + i) % count ];
+        std::lock_guard<std::mutex> lock( victim.mutex );
+        if ( !victim.tasks.empty() )
+        {
+            task = std::move( victim.tasks.front() );
+            victim.tasks.pop_front();
+            --mQueued;
+            ++mStolen;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkPool::finish()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    --mPending;
+    mDone.notify_all();
+}
+
+void WorkPool::run( int worker )
+{
+    for (;;)
+    {
+        Task task;
+        if ( pop( worker, task ) )
+        {
+            try
+            {
+                task();
+            }
+            catch ( ... )
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                if ( !mError )
+                    mError = std::current_exception();
+            }
+            finish();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( mMutex );
+        mWake.wait( lock, [this]{ return mStop || mQueued > 0; } );
+        if ( mStop && mQueued == 0 )
+            return;
+    }
+}
+
+void WorkPool::waitForPending( size_t max_pending )
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+    mDone.wait( lock, [this, max_pending]{ return mPending <= max_pending; } );
+}
+
+void WorkPool::wait()
+{
+    waitForPending( 0 );
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        error = mError;
+        mError = std::exception_ptr();
+    }
+    if ( error )
+        std::rethrow_exception( error );
+}
+
+};
@@ -0,0 +1,74 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace hapi
+{
+
+//----------------------------------------------------------------------------
+// Work-stealing thread pool:
+
+// Each worker owns a deque. Submitted tasks are spread round-robin; a worker
+// pops from the back of its own deque and, when that runs dry, steals from
+// the front of the others. Tasks must not call into HAPI.
+class WorkPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // A thread count of 0 uses one worker per hardware thread.
+    explicit WorkPool( int thread_count = 0 );
+    ~WorkPool();
+
+    void        submit( const Task& task );
+
+    // Block until every submitted task has run. Rethrows the first exception
+    // a task threw since the last wait().
+    void        wait();
+
+    // Block until no more than max_pending tasks are queued or running.
+    void        waitForPending( size_t max_pending );
+
+    size_t      pending() const { return mPending; }
+    int         threadCount() const { return int( mThreads.size() ); }
+    size_t      stolenCount() const { return mStolen; }
+
+private:
+    WorkPool( const WorkPool& );
+    WorkPool& operator=( const WorkPool& );
+
+    struct Queue
+    {
+        std::mutex          mutex;
+        std::deque<Task>    tasks;
+    };
+
+    bool        pop( int worker, Task& task );
+    void        run( int worker );
+    void        finish();
+
+    std::vector< std::unique_ptr<Queue> >   mQueues;
+    std::vector<std::thread>                mThreads;
+    std::mutex                              mMutex;
+    std::condition_variable                 mWake;
+    std::condition_variable                 mDone;
+    std::atomic<size_t>                     mQueued;
+    std::atomic<size_t>                     mPending;
+    std::atomic<size_t>                     mStolen;
+    size_t                                  mNext;
+    bool                                    mStop;
+    std::exception_ptr                      mError;
+};
+
+}
+
+#endif // WORKPOOL_H